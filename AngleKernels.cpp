@@ -0,0 +1,17 @@
+#include "AngleKernels.h"
+
+void directionAngles(const float* x1, const float* y1, const float* x2, const float* y2, float* result, const int count) {
+	for (int i = 0; i < count; i++) {
+		result[i] = fastDirectionAngle(x1[i], y1[i], x2[i], y2[i]);
+	}
+}
+
+void threePointAngles(const float* ax, const float* ay, const float* az,
+	const float* bx, const float* by, const float* bz,
+	const float* cx, const float* cy, const float* cz,
+	float* result, const int count) {
+
+	for (int i = 0; i < count; i++) {
+		result[i] = fastThreePointAngle(ax[i], ay[i], az[i], bx[i], by[i], bz[i], cx[i], cy[i], cz[i]);
+	}
+}
@@ -0,0 +1,161 @@
+#include "ClassificationScheduler.h"
+
+#include <algorithm>
+
+ClassificationScheduler::ClassificationScheduler(const int maxUsers, const double budget, const int maxStaleness) : users((std::max)(0, maxUsers)) {
+	setLimits(budget, maxStaleness);
+}
+
+void ClassificationScheduler::setLimits(const double budget, const int maxStaleness) {
+	this->budget = (std::max)(0.0, budget);
+	this->maxStaleness = (std::max)(1, maxStaleness);
+}
+
+double ClassificationScheduler::getBudget() const {
+	return this->budget;
+}
+
+int ClassificationScheduler::getMaxStaleness() const {
+	return this->maxStaleness;
+}
+
+void ClassificationScheduler::beginFrame() {
+
+	endFrame();
+
+	frame++;
+
+	candidates.clear();
+	nextCandidate = 0;
+	currentCandidate = -1;
+	sorted = false;
+	spent = 0;
+}
+
+void ClassificationScheduler::endFrame() {
+
+	if (candidates.empty())
+		return;
+
+	statistics.frames++;
+	statistics.deferred += candidates.size() - nextCandidate;
+	statistics.averageFrameTime += (spent - statistics.averageFrameTime) / statistics.frames;
+	statistics.maxFrameTime = (std::max)(statistics.maxFrameTime, spent);
+}
+
+void ClassificationScheduler::addCandidate(const int userId, const FeatureString& featureString, const double distance, const double threshold) {
+
+	if (userId < 0 || userId >= (int)users.size() || featureString.isEmpty())
+		return;
+
+	UserSchedule& user = users[userId];
+
+	// the staleness is counted from the first frame, where the user was offered
+	if (!user.active) {
+		user.active = true;
+		user.estimated = false;
+		user.lastFrame = frame;
+	}
+
+	Candidate candidate;
+	candidate.userId = userId;
+	candidate.features = embedFeatures(featureString);
+
+	unsigned long long staleness = frame - user.lastFrame;
+
+	candidate.forced = (staleness >= (unsigned long long)maxStaleness);
+	candidate.priority = (double)staleness / maxStaleness;
+
+	if (!user.estimated)
+		candidate.priority += SCHEDULER_NEW_USER_BONUS;
+	else if (threshold > 0)
+		candidate.priority += EmbeddedMetric::distance(candidate.features, user.features) / threshold;
+
+	if (distance > 0)
+		candidate.priority += SCHEDULER_PROXIMITY_WEIGHT / (std::max)(distance, 0.5);
+
+	candidates.push_back(candidate);
+}
+
+bool ClassificationScheduler::next(int& userId) {
+
+	if (!sorted) {
+		// the forced users first, then by the priority
+		std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+			if (a.forced != b.forced)
+				return a.forced;
+
+			return a.priority > b.priority;
+		});
+
+		sorted = true;
+	}
+
+	while (nextCandidate < candidates.size()) {
+
+		Candidate& candidate = candidates[nextCandidate];
+		const UserSchedule& user = users[candidate.userId];
+
+		double cost = (user.cost > 0) ? user.cost : averageCost;
+
+		// the rest of the users wait for the next frames, unless they're at the staleness limit
+		if (!candidate.forced && spent + cost > budget)
+			return false;
+
+		if (candidate.forced && spent + cost > budget)
+			statistics.forced++;
+
+		currentCandidate = (int)nextCandidate;
+		nextCandidate++;
+
+		userId = candidate.userId;
+		return true;
+	}
+
+	return false;
+}
+
+void ClassificationScheduler::finish(const double elapsed) {
+
+	if (currentCandidate < 0)
+		return;
+
+	const Candidate& candidate = candidates[currentCandidate];
+	UserSchedule& user = users[candidate.userId];
+
+	user.estimated = true;
+	user.lastFrame = frame;
+	user.features = candidate.features;
+	user.cost = (user.cost > 0) ? user.cost + (elapsed - user.cost) * SCHEDULER_COST_SMOOTHING : elapsed;
+
+	averageCost = (averageCost > 0) ? averageCost + (elapsed - averageCost) * SCHEDULER_COST_SMOOTHING : elapsed;
+
+	spent += elapsed;
+	statistics.classified++;
+
+	currentCandidate = -1;
+}
+
+void ClassificationScheduler::reset(const int userId) {
+	if (userId >= 0 && userId < (int)users.size())
+		users[userId] = UserSchedule();
+}
+
+void ClassificationScheduler::reset() {
+
+	for (UserSchedule& user : users) {
+		user = UserSchedule();
+	}
+
+	averageCost = 0;
+	frame = 0;
+	candidates.clear();
+	nextCandidate = 0;
+	currentCandidate = -1;
+	spent = 0;
+	statistics = SchedulerStatistics();
+}
+
+SchedulerStatistics ClassificationScheduler::getStatistics() const {
+	return this->statistics;
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "FeatureSchema.h"
+
+#include <vector>
+
+#define SCHEDULER_FRAME_BUDGET 4.0      // the time for the pose estimations in one frame, in milliseconds
+#define SCHEDULER_MAX_STALENESS 4       // the maximum number of frames between two pose estimations of a user
+#define SCHEDULER_NEW_USER_BONUS 10.0   // the priority added to a user, that wasn't estimated yet (more than any change)
+#define SCHEDULER_PROXIMITY_WEIGHT 1.0  // the priority of a user 1 meter from the Kinect; falls with the distance
+#define SCHEDULER_COST_SMOOTHING 0.1    // the weight of the last pose estimation in the average time of a user
+
+/**
+	The counters of the scheduler
+*/
+struct SchedulerStatistics {
+
+	// the scheduled frames
+	unsigned long long frames = 0;
+
+	// the pose estimations: all, those run over the budget because of the staleness limit, and those left for a later frame
+	unsigned long long classified = 0;
+	unsigned long long forced = 0;
+	unsigned long long deferred = 0;
+
+	// the time of the pose estimations in one frame, in milliseconds: the average and the maximum
+	double averageFrameTime = 0;
+	double maxFrameTime = 0;
+};
+
+/**
+	Spreads the pose estimations of the users over the frames, so that every frame spends about the
+	same time on them, instead of estimating all the users in one frame and none in the next ones.
+
+	Every frame, the users with features are offered to the scheduler (see addCandidate()), and
+	then taken in the order of their priority (see next()), while the time spent in the frame plus
+	the average time of the user fits into the budget. The priority is the sum of:
+
+	- the staleness: the frames since the last estimation, divided by the staleness limit
+	- the change of the features since the last estimation, relative to the distance threshold of the poses
+	- SCHEDULER_NEW_USER_BONUS, if the user wasn't estimated yet
+	- the proximity: SCHEDULER_PROXIMITY_WEIGHT divided by the distance from the Kinect in meters
+
+	A user, that wasn't estimated for the staleness limit of frames, is estimated even over the budget,
+	so every user is estimated at least every maxStaleness frames, however many users there are. A user
+	without features (see KinectUser::extractUserFeatures()) isn't offered, and his staleness keeps growing.
+*/
+class ClassificationScheduler {
+
+public:
+	/**
+		Create the scheduler
+
+		@param maxUsers The maximum number of users. The user ids have to be lower than this value.
+		@param budget The time for the pose estimations in one frame, in milliseconds. Default: SCHEDULER_FRAME_BUDGET.
+		@param maxStaleness The maximum number of frames between two estimations of a user. Default: SCHEDULER_MAX_STALENESS.
+	*/
+	ClassificationScheduler(const int maxUsers, const double budget = SCHEDULER_FRAME_BUDGET, const int maxStaleness = SCHEDULER_MAX_STALENESS);
+
+	/**
+		Set the budget and the staleness limit
+
+		@param budget The time for the pose estimations in one frame, in milliseconds
+		@param maxStaleness The maximum number of frames between two estimations of a user (at least 1)
+	*/
+	void setLimits(const double budget, const int maxStaleness);
+
+	/**
+		Get the time for the pose estimations in one frame, in milliseconds
+	*/
+	double getBudget() const;
+
+	/**
+		Get the maximum number of frames between two estimations of a user
+	*/
+	int getMaxStaleness() const;
+
+	/**
+		Start a new frame. Forgets the candidates of the previous frame.
+	*/
+	void beginFrame();
+
+	/**
+		Offer a user for the pose estimation in this frame
+
+		@param userId The id of the user
+		@param featureString The features of the user in this frame
+		@param distance The distance of the user from the Kinect, in meters
+		@param threshold The distance threshold, that the change of the features is compared to (e.g. the smallest threshold of the poses)
+	*/
+	void addCandidate(const int userId, const FeatureString& featureString, const double distance, const double threshold);
+
+	/**
+		Get the next user to estimate in this frame. The candidates are sorted by the first call.
+		After the estimation, call finish() with its time.
+
+		@param userId The id of the user
+		@return Returns "false" if no other user fits into the budget.
+	*/
+	bool next(int& userId);
+
+	/**
+		Record the pose estimation of the user returned by next()
+
+		@param elapsed The time of the estimation, in milliseconds
+	*/
+	void finish(const double elapsed);
+
+	/**
+		Forget the history of the user, e.g. when he's lost
+
+		@param userId The id of the user
+	*/
+	void reset(const int userId);
+
+	/**
+		Forget the history of all the users and the counters
+	*/
+	void reset();
+
+	/**
+		Get the counters
+	*/
+	SchedulerStatistics getStatistics() const;
+
+private:
+	/**
+		The history of a user
+	*/
+	struct UserSchedule {
+
+		// was the user already estimated?
+		bool estimated = false;
+
+		// the frame of the last estimation (or the frame, where the user was first offered)
+		unsigned long long lastFrame = 0;
+
+		// the features of the last estimation
+		EmbeddedFeature features;
+
+		// the average time of an estimation, in milliseconds (0 = not known yet)
+		double cost = 0;
+
+		// is the history in use?
+		bool active = false;
+	};
+
+	/**
+		A user offered in this frame
+	*/
+	struct Candidate {
+		int userId;
+		EmbeddedFeature features;
+		double priority;
+		bool forced;
+	};
+
+	// the limits
+	double budget;
+	int maxStaleness;
+
+	// the history of every user, by the user id
+	std::vector<UserSchedule> users;
+
+	// the average time of an estimation over all the users, for the users without their own yet
+	double averageCost = 0;
+
+	// the current frame
+	unsigned long long frame = 0;
+
+	// the candidates of the current frame, the next one to return, the one being estimated (or -1) and the time spent
+	std::vector<Candidate> candidates;
+	size_t nextCandidate = 0;
+	int currentCandidate = -1;
+	bool sorted = false;
+	double spent = 0;
+
+	SchedulerStatistics statistics;
+
+	/**
+		Add the time of the frame to the counters
+	*/
+	void endFrame();
+};
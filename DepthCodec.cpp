@@ -0,0 +1,178 @@
+#include "DepthCodec.h"
+
+#include <cstring>
+
+/**
+	Writes the variable length numbers as groups of 4-bit nibbles (3 bits of the value and
+	a continuation bit) into 32-bit words, most significant nibble first
+*/
+class NibbleWriter {
+
+public:
+	NibbleWriter(std::vector<unsigned int>& words) : words(words) {
+	}
+
+	void write(unsigned int value) {
+		do {
+			unsigned int nibble = value & 0x7;
+			if (value >>= 3)
+				nibble |= 0x8;
+
+			word = (word << 4) | nibble;
+
+			if (++nibbles == 8) {
+				words.push_back(word);
+				word = 0;
+				nibbles = 0;
+			}
+		} while (value);
+	}
+
+	void flush() {
+		if (nibbles > 0)
+			words.push_back(word << (4 * (8 - nibbles)));
+
+		word = 0;
+		nibbles = 0;
+	}
+
+private:
+	std::vector<unsigned int>& words;
+	unsigned int word = 0;
+	int nibbles = 0;
+};
+
+/**
+	Reads the numbers written by the NibbleWriter
+*/
+class NibbleReader {
+
+public:
+	NibbleReader(const unsigned char* input, const size_t size) : input(input), end(input + size - size % 4) {
+	}
+
+	bool read(unsigned int& value) {
+		value = 0;
+
+		for (int shift = 0; shift < 32; shift += 3) {
+			if (nibbles == 0) {
+				if (input >= end)
+					return false;
+
+				word = input[3] | (input[2] << 8) | (input[1] << 16) | ((unsigned int)input[0] << 24);
+				input += 4;
+				nibbles = 8;
+			}
+
+			unsigned int nibble = word >> 28;
+			word <<= 4;
+			nibbles--;
+
+			value |= (nibble & 0x7) << shift;
+
+			if (!(nibble & 0x8))
+				return true;
+		}
+
+		return false;
+	}
+
+private:
+	const unsigned char* input;
+	const unsigned char* end;
+	unsigned int word = 0;
+	int nibbles = 0;
+};
+
+void compressDepthRVL(const cv::Mat& depth, std::vector<unsigned char>& output) {
+
+	// the buffer for the words is kept between the calls
+	static thread_local std::vector<unsigned int> words;
+	words.clear();
+
+	NibbleWriter writer(words);
+
+	int previous = 0;
+
+	for (int row = 0; row < depth.rows; row++) {
+		const unsigned short* pixel = depth.ptr<unsigned short>(row);
+		const unsigned short* end = pixel + depth.cols;
+
+		while (pixel != end) {
+			// the run of invalid pixels
+			unsigned int zeros = 0;
+			while (pixel != end && *pixel == 0) {
+				++pixel;
+				++zeros;
+			}
+			writer.write(zeros);
+
+			// the run of valid pixels
+			unsigned int nonzeros = 0;
+			for (const unsigned short* p = pixel; p != end && *p != 0; ++p)
+				++nonzeros;
+			writer.write(nonzeros);
+
+			for (unsigned int i = 0; i < nonzeros; i++) {
+				int current = *pixel++;
+				int delta = current - previous;
+				writer.write((unsigned int)((delta << 1) ^ (delta >> 31)));
+				previous = current;
+			}
+		}
+	}
+
+	writer.flush();
+
+	// store the words big-endian, so the nibbles are in the order they were written
+	output.resize(words.size() * 4);
+
+	unsigned char* out = output.data();
+	for (unsigned int word : words) {
+		out[0] = (unsigned char)(word >> 24);
+		out[1] = (unsigned char)(word >> 16);
+		out[2] = (unsigned char)(word >> 8);
+		out[3] = (unsigned char)word;
+		out += 4;
+	}
+}
+
+bool decompressDepthRVL(const unsigned char* input, const size_t size, cv::Mat& depth) {
+
+	NibbleReader reader(input, size);
+
+	int previous = 0;
+
+	for (int row = 0; row < depth.rows; row++) {
+		unsigned short* pixel = depth.ptr<unsigned short>(row);
+		int left = depth.cols;
+
+		while (left > 0) {
+			unsigned int zeros, nonzeros;
+
+			if (!reader.read(zeros) || zeros > left)
+				return false;
+
+			std::memset(pixel, 0, zeros * sizeof(unsigned short));
+			pixel += zeros;
+			left -= zeros;
+
+			if (!reader.read(nonzeros) || nonzeros > left)
+				return false;
+
+			for (unsigned int i = 0; i < nonzeros; i++) {
+				unsigned int positive;
+				if (!reader.read(positive))
+					return false;
+
+				int delta = (int)(positive >> 1) ^ -(int)(positive & 1);
+				previous += delta;
+				*pixel++ = (unsigned short)previous;
+			}
+
+			left -= nonzeros;
+		}
+	}
+
+	return true;
+}
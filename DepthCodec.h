@@ -0,0 +1,35 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+#include <vector>
+
+/**
+	Lossless compression of the 16-bit depth maps with the RVL codec
+	(A. D. Wilson, "Fast Lossless Depth Image Compression", 2017).
+
+	The depth map is scanned row by row as alternating runs of zero (invalid) and non-zero pixels.
+	The run lengths and the differences between the consecutive non-zero pixels (zigzag-encoded)
+	are written as variable length numbers of 3-bit nibbles. A Kinect depth map typically shrinks
+	to a third or a quarter of the original size, and both the compression and the decompression
+	take a few milliseconds for a 640x480 frame, so it easily keeps up with the camera on a single thread.
+*/
+
+/**
+	Compress the depth map
+
+	@param depth The depth map (CV_16UC1)
+	@param output The compressed data. The vector is reused, so it doesn't need to be reallocated every frame.
+*/
+void compressDepthRVL(const cv::Mat& depth, std::vector<unsigned char>& output);
+
+/**
+	Decompress the depth map
+
+	@param input The compressed data
+	@param size The size of the compressed data in bytes
+	@param depth The depth map, already allocated with the original size (CV_16UC1)
+
+	@return Returns "false" if the data is corrupted
+*/
+bool decompressDepthRVL(const unsigned char* input, const size_t size, cv::Mat& depth);
@@ -0,0 +1,97 @@
+#include "DepthProjection.h"
+
+// the field of view of the Kinect (PrimeSense) depth camera, as reported by OpenNI
+#define KINECT_DEPTH_HFOV 1.01447f
+#define KINECT_DEPTH_VFOV 0.789809f
+
+DepthProjection::DepthProjection() {
+	*this = fromFieldOfView(KINECT_DEPTH_HFOV, KINECT_DEPTH_VFOV, 640, 480);
+}
+
+DepthProjection::DepthProjection(const float coeffX, const float coeffY, const float halfResX, const float halfResY) {
+	this->coeffX = coeffX;
+	this->coeffY = coeffY;
+	this->halfResX = halfResX;
+	this->halfResY = halfResY;
+}
+
+DepthProjection DepthProjection::fromFieldOfView(const float hFov, const float vFov, const int resX, const int resY) {
+	// same as in the OpenNI's CoordinateConverter
+	float xzFactor = std::tan(hFov / 2) * 2;
+	float yzFactor = std::tan(vFov / 2) * 2;
+
+	return DepthProjection(resX / xzFactor, resY / yzFactor, resX / 2.f, resY / 2.f);
+}
+
+bool DepthProjection::calibrate(const nite::UserTracker& userTracker, const float tolerance) {
+
+	float centerX, centerY, unitX, unitY;
+
+	// a point on the optical axis lands on the principal point
+	if (userTracker.convertJointCoordinatesToDepth(0, 0, 1000, &centerX, &centerY) != nite::STATUS_OK)
+		return false;
+
+	// a point at X/Z = Y/Z = 1 gives the scale
+	if (userTracker.convertJointCoordinatesToDepth(1000, 1000, 1000, &unitX, &unitY) != nite::STATUS_OK)
+		return false;
+
+	DepthProjection calibrated(unitX - centerX, centerY - unitY, centerX, centerY);
+
+	// verify the model against a few more points, spread over the field of view
+	const cv::Point3f probes[] = {
+		cv::Point3f(-700, 450, 1500), cv::Point3f(350, -600, 2500), cv::Point3f(1200, 800, 4000)
+	};
+
+	for (const cv::Point3f& probe : probes) {
+		cv::Point2f expected;
+
+		if (userTracker.convertJointCoordinatesToDepth(probe.x, probe.y, probe.z, &expected.x, &expected.y) != nite::STATUS_OK)
+			return false;
+
+		cv::Point2f actual = calibrated.project(probe);
+
+		if (std::abs(actual.x - expected.x) > tolerance || std::abs(actual.y - expected.y) > tolerance) {
+			std::cerr << "Depth projection doesn't match NiTE: (" << actual.x << "; " << actual.y << ") vs ("
+				<< expected.x << "; " << expected.y << ")" << std::endl;
+			return false;
+		}
+	}
+
+	*this = calibrated;
+
+	return true;
+}
+
+cv::Point2f DepthProjection::project(const cv::Point3f& point) const {
+	float invZ = (point.z != 0) ? 1.f / point.z : 0.f;
+
+	return cv::Point2f(coeffX * point.x * invZ + halfResX, halfResY - coeffY * point.y * invZ);
+}
+
+void DepthProjection::projectAll(JointSnapshot& snapshot) const {
+
+	const int count = NUM_JOINTS * snapshot.getCapacity();
+
+	const float* x = snapshot.getAllX();
+	const float* y = snapshot.getAllY();
+	const float* z = snapshot.getAllZ();
+
+	float* depthX = snapshot.getAllDepthX();
+	float* depthY = snapshot.getAllDepthY();
+	float* displayX = snapshot.getAllDisplayX();
+	float* displayY = snapshot.getAllDisplayY();
+
+	const float cx = coeffX, cy = coeffY, hx = halfResX, hy = halfResY;
+
+	// a plain branch-free loop over contiguous arrays, so the compiler can vectorize it
+	for (int i = 0; i < count; i++) {
+		float invZ = (z[i] != 0) ? 1.f / z[i] : 0.f;
+
+		depthX[i] = cx * x[i] * invZ + hx;
+		depthY[i] = hy - cy * y[i] * invZ;
+
+		// drawn where they are, unless they're predicted later
+		displayX[i] = depthX[i];
+		displayY[i] = depthY[i];
+	}
+}
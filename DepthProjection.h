@@ -0,0 +1,86 @@
+#pragma once
+
+#include "JointSnapshot.h"
+
+#include <NiTE.h>
+
+#include <iostream>
+
+/**
+	The projection from the real world coordinates (milimeters) into the depth image (pixels).
+
+	This is the same pinhole model, that OpenNI and NiTE use internally in
+	nite::UserTracker::convertJointCoordinatesToDepth():
+
+		depthX = coeffX * worldX / worldZ + halfResX
+		depthY = halfResY - coeffY * worldY / worldZ
+
+	The parameters are captured once (either from the NiTE itself, or from the field of view
+	of the camera), after which all the joints of all the users can be projected in one batch,
+	without calling NiTE for every single joint. This also works when there is no
+	nite::UserTracker at all (e.g. in the replay mode).
+*/
+class DepthProjection {
+
+public:
+	/**
+		Create the projection with the default parameters of the Kinect depth camera (640x480)
+	*/
+	DepthProjection();
+
+	/**
+		Create the projection with the specified parameters. See the class description for details.
+	*/
+	DepthProjection(const float coeffX, const float coeffY, const float halfResX, const float halfResY);
+
+	/**
+		Create the projection from the field of view of the depth camera
+
+		@param hFov Horizontal field of view, in radians
+		@param vFov Vertical field of view, in radians
+		@param resX Horizontal resolution of the depth image
+		@param resY Vertical resolution of the depth image
+	*/
+	static DepthProjection fromFieldOfView(const float hFov, const float vFov, const int resX, const int resY);
+
+	/**
+		Capture the projection parameters from the user tracker, by letting it project
+		a few probe points. Should be called once, after the user tracker was created.
+
+		@param userTracker The created NiTE user tracker
+		@param tolerance The maximum allowed difference (in pixels) between the NiTE's projection and ours
+
+		@return Returns "true" if the parameters were captured and verified.
+	*/
+	bool calibrate(const nite::UserTracker& userTracker, const float tolerance = 0.01f);
+
+	/**
+		Project a single point on the depth image
+
+		@param point The real world point, in milimeters
+		@return The position on the depth image, in pixels
+	*/
+	cv::Point2f project(const cv::Point3f& point) const;
+
+	/**
+		Project all the joints of all the users in the snapshot in one batch. The results
+		are written back into the snapshot (see JointSnapshot::getDepthPosition()).
+
+		@param snapshot The snapshot of the joints in the current frame
+	*/
+	void projectAll(JointSnapshot& snapshot) const;
+
+	float getCoeffX() const { return coeffX; }
+	float getCoeffY() const { return coeffY; }
+	float getHalfResX() const { return halfResX; }
+	float getHalfResY() const { return halfResY; }
+
+private:
+	// pixels per unit of X/Z and Y/Z
+	float coeffX;
+	float coeffY;
+
+	// the principal point (the center of the depth image)
+	float halfResX;
+	float halfResY;
+};
@@ -0,0 +1,35 @@
+#include "DistanceTable.h"
+
+void DistanceTable::add(const unsigned long long frame, const nite::UserId userId, const std::vector<EstimationResult>& results, const double duration) {
+
+	Entry& entry = entries[makeKey(frame, userId)];
+
+	samples -= entry.samples.size();
+	entry.samples = results;
+	entry.duration = duration;
+	samples += entry.samples.size();
+}
+
+const DistanceTable::Entry* DistanceTable::find(const unsigned long long frame, const nite::UserId userId) const {
+
+	std::unordered_map<unsigned long long, Entry>::const_iterator it = entries.find(makeKey(frame, userId));
+
+	return (it != entries.end()) ? &it->second : nullptr;
+}
+
+size_t DistanceTable::size() const {
+	return entries.size();
+}
+
+size_t DistanceTable::getSampleCount() const {
+	return this->samples;
+}
+
+void DistanceTable::clear() {
+	entries.clear();
+	samples = 0;
+}
+
+unsigned long long DistanceTable::makeKey(const unsigned long long frame, const nite::UserId userId) {
+	return (frame << 16) | (unsigned short)userId;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "KinectPose.h"
+
+#include <NiTE.h>
+
+#include <unordered_map>
+#include <vector>
+
+/**
+	The training samples near every user in every frame of a replayed session, with their distances.
+
+	Comparing the features with the training samples is the expensive part of the pose estimation,
+	but it doesn't depend on the parameters of the recognition (the number of the neighbours, the hold,
+	the thresholds), only on the features. When the same session is replayed with many parameters (see
+	ParameterSweep), the distances are computed once, with the widest thresholds, and every replay only
+	filters them by its own thresholds (see PoseRecognizer::setDistanceTable()).
+
+	The table is filled by a single recognizer, and afterwards it can be read from any number of threads.
+*/
+class DistanceTable {
+
+public:
+	/**
+		The samples found for one user in one frame
+	*/
+	struct Entry {
+
+		// the samples within the threshold of their pose, sorted by the distance
+		std::vector<EstimationResult> samples;
+
+		// how long it took to find them, in milliseconds
+		double duration = 0;
+	};
+
+	/**
+		Add the samples found for the user in the frame
+
+		@param frame The number of the frame in the replay, starting with 1
+		@param userId The id of the user
+		@param results The samples within the threshold of their pose, sorted by the distance
+		@param duration How long it took to find the samples, in milliseconds
+	*/
+	void add(const unsigned long long frame, const nite::UserId userId, const std::vector<EstimationResult>& results, const double duration);
+
+	/**
+		Find the samples of the user in the frame
+
+		@param frame The number of the frame in the replay, starting with 1
+		@param userId The id of the user
+
+		@return Returns the samples, or nullptr if the user wasn't estimated in the frame.
+	*/
+	const Entry* find(const unsigned long long frame, const nite::UserId userId) const;
+
+	/**
+		Get the number of the estimations (the users in all the frames) in the table
+	*/
+	size_t size() const;
+
+	/**
+		Get the number of the stored samples in all the estimations
+	*/
+	size_t getSampleCount() const;
+
+	/**
+		Remove everything
+	*/
+	void clear();
+
+private:
+	// the samples, by the frame and the user id (see makeKey())
+	std::unordered_map<unsigned long long, Entry> entries;
+
+	// the number of the stored samples
+	size_t samples = 0;
+
+	/**
+		Combine the frame and the user id into one key
+	*/
+	static unsigned long long makeKey(const unsigned long long frame, const nite::UserId userId);
+};
@@ -0,0 +1,28 @@
+#include "FeatureExtractor.h"
+
+FeatureString extractFeatures(const FeatureProfile profile, const JointSnapshot& snapshot, const int slot) {
+	switch (profile) {
+	case PROFILE_BELT:
+		return FeatureExtractor<ProfilePolicies<PROFILE_BELT>::Reference>::extract(snapshot, slot);
+	case PROFILE_TORSO:
+		return FeatureExtractor<ProfilePolicies<PROFILE_TORSO>::Reference>::extract(snapshot, slot);
+	case PROFILE_HEAD:
+	default:
+		return FeatureExtractor<ProfilePolicies<PROFILE_HEAD>::Reference>::extract(snapshot, slot);
+	}
+}
+
+void extractFeatures(const FeatureProfile profile, const JointSnapshot& snapshot, FeatureBatch& batch) {
+	switch (profile) {
+	case PROFILE_BELT:
+		FeatureExtractor<ProfilePolicies<PROFILE_BELT>::Reference>::extractAll(snapshot, batch);
+		break;
+	case PROFILE_TORSO:
+		FeatureExtractor<ProfilePolicies<PROFILE_TORSO>::Reference>::extractAll(snapshot, batch);
+		break;
+	case PROFILE_HEAD:
+	default:
+		FeatureExtractor<ProfilePolicies<PROFILE_HEAD>::Reference>::extractAll(snapshot, batch);
+		break;
+	}
+}
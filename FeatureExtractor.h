@@ -0,0 +1,338 @@
+#pragma once
+
+#include "FeatureSchema.h"
+#include "JointSnapshot.h"
+#include "AngleKernels.h"
+
+#include <string>
+
+/**
+	The feature profile of a pose library. Every library of poses was recorded with its own
+	reference point (the "center of mass"), so the live features have to be extracted
+	the same way, as the training samples of the library.
+
+	PROFILE_HEAD   The default profile, used for the "poses" and "poses_from_head" libraries.
+                 The direction to the left hand is measured from the head, and the direction to
+                 the right hand from the torso. The positions are relative to the head.
+	PROFILE_BELT   Used for the "poses_belt_level" library. Both directions and positions
+                 are relative to the middle point between the hips.
+	PROFILE_TORSO  Both directions and positions are relative to the center of the body
+                 (between the neck and the torso).
+
+	The profile is declared with the library, when it's loaded (see PoseModelStore::load()),
+	not derived from the name of its folder. It selects both the extractor and the metric
+	(see ProfilePolicies).
+*/
+enum FeatureProfile {
+	PROFILE_HEAD = 0,
+	PROFILE_BELT,
+	PROFILE_TORSO,
+	NUM_FEATURE_PROFILES
+};
+
+/**
+	The features of all the users in the current frame, extracted in one batch,
+	together with the scratch arrays for the batch angle kernels (see AngleKernels.h).
+	All the arrays are allocated once and indexed by the slot of the user.
+*/
+struct FeatureBatch {
+
+	// the reference points for the direction angles
+	std::vector<float> leftOriginX, leftOriginY;
+	std::vector<float> rightOriginX, rightOriginY;
+
+	// the elbow and direction angles of all the users
+	std::vector<float> leftElbowAngles, rightElbowAngles;
+	std::vector<float> leftDirections, rightDirections;
+
+	// the resulting feature vectors
+	std::vector<FeatureString> features;
+
+	FeatureBatch(const int capacity = 0) {
+		leftOriginX = leftOriginY = rightOriginX = rightOriginY = std::vector<float>(capacity, 0.f);
+		leftElbowAngles = rightElbowAngles = leftDirections = rightDirections = std::vector<float>(capacity, 0.f);
+		features = std::vector<FeatureString>(capacity);
+	}
+};
+
+/**
+	Reference point policy: the head (and the torso for the right hand direction)
+*/
+struct HeadReference {
+	static cv::Point3f leftDirectionOrigin(const JointSnapshot& snapshot, const int slot) {
+		return snapshot.getPosition(slot, nite::JOINT_HEAD);
+	}
+
+	static cv::Point3f rightDirectionOrigin(const JointSnapshot& snapshot, const int slot) {
+		return snapshot.getPosition(slot, nite::JOINT_TORSO);
+	}
+
+	static cv::Point3f pointOrigin(const JointSnapshot& snapshot, const int slot) {
+		return snapshot.getPosition(slot, nite::JOINT_HEAD);
+	}
+
+	static void directionOrigins(const JointSnapshot& snapshot, FeatureBatch& batch) {
+		const int n = snapshot.getCapacity();
+
+		std::copy(snapshot.getX(nite::JOINT_HEAD), snapshot.getX(nite::JOINT_HEAD) + n, batch.leftOriginX.begin());
+		std::copy(snapshot.getY(nite::JOINT_HEAD), snapshot.getY(nite::JOINT_HEAD) + n, batch.leftOriginY.begin());
+		std::copy(snapshot.getX(nite::JOINT_TORSO), snapshot.getX(nite::JOINT_TORSO) + n, batch.rightOriginX.begin());
+		std::copy(snapshot.getY(nite::JOINT_TORSO), snapshot.getY(nite::JOINT_TORSO) + n, batch.rightOriginY.begin());
+	}
+};
+
+/**
+	Reference point policy: the belt (the middle point between the hips)
+*/
+struct BeltReference {
+	static cv::Point3f belt(const JointSnapshot& snapshot, const int slot) {
+		cv::Point3f leftHip = snapshot.getPosition(slot, nite::JOINT_LEFT_HIP);
+		cv::Point3f rightHip = snapshot.getPosition(slot, nite::JOINT_RIGHT_HIP);
+
+		return cv::Point3f((leftHip.x + rightHip.x) / 2, (leftHip.y + rightHip.y) / 2, (leftHip.z + rightHip.z) / 2);
+	}
+
+	static cv::Point3f leftDirectionOrigin(const JointSnapshot& snapshot, const int slot) {
+		return belt(snapshot, slot);
+	}
+
+	static cv::Point3f rightDirectionOrigin(const JointSnapshot& snapshot, const int slot) {
+		return belt(snapshot, slot);
+	}
+
+	static cv::Point3f pointOrigin(const JointSnapshot& snapshot, const int slot) {
+		return belt(snapshot, slot);
+	}
+
+	static void directionOrigins(const JointSnapshot& snapshot, FeatureBatch& batch) {
+		const int n = snapshot.getCapacity();
+
+		const float* leftHipX = snapshot.getX(nite::JOINT_LEFT_HIP);
+		const float* leftHipY = snapshot.getY(nite::JOINT_LEFT_HIP);
+		const float* rightHipX = snapshot.getX(nite::JOINT_RIGHT_HIP);
+		const float* rightHipY = snapshot.getY(nite::JOINT_RIGHT_HIP);
+
+		for (int i = 0; i < n; i++) {
+			batch.leftOriginX[i] = batch.rightOriginX[i] = (leftHipX[i] + rightHipX[i]) / 2;
+			batch.leftOriginY[i] = batch.rightOriginY[i] = (leftHipY[i] + rightHipY[i]) / 2;
+		}
+	}
+};
+
+/**
+	Reference point policy: the center of the body (the middle point between the neck and the torso)
+*/
+struct TorsoReference {
+	static cv::Point3f bodyCenter(const JointSnapshot& snapshot, const int slot) {
+		cv::Point3f neck = snapshot.getPosition(slot, nite::JOINT_NECK);
+		cv::Point3f torso = snapshot.getPosition(slot, nite::JOINT_TORSO);
+
+		return cv::Point3f((neck.x + torso.x) / 2, (neck.y + torso.y) / 2, (neck.z + torso.z) / 2);
+	}
+
+	static cv::Point3f leftDirectionOrigin(const JointSnapshot& snapshot, const int slot) {
+		return bodyCenter(snapshot, slot);
+	}
+
+	static cv::Point3f rightDirectionOrigin(const JointSnapshot& snapshot, const int slot) {
+		return bodyCenter(snapshot, slot);
+	}
+
+	static cv::Point3f pointOrigin(const JointSnapshot& snapshot, const int slot) {
+		return bodyCenter(snapshot, slot);
+	}
+
+	static void directionOrigins(const JointSnapshot& snapshot, FeatureBatch& batch) {
+		const int n = snapshot.getCapacity();
+
+		const float* neckX = snapshot.getX(nite::JOINT_NECK);
+		const float* neckY = snapshot.getY(nite::JOINT_NECK);
+		const float* torsoX = snapshot.getX(nite::JOINT_TORSO);
+		const float* torsoY = snapshot.getY(nite::JOINT_TORSO);
+
+		for (int i = 0; i < n; i++) {
+			batch.leftOriginX[i] = batch.rightOriginX[i] = (neckX[i] + torsoX[i]) / 2;
+			batch.leftOriginY[i] = batch.rightOriginY[i] = (neckY[i] + torsoY[i]) / 2;
+		}
+	}
+};
+
+/**
+	Extracts the feature vectors (see FeatureSchema.h) from the joint snapshot, either for
+	a single user, or for all the users at once.
+
+	@tparam Reference The reference point policy (HeadReference, BeltReference, TorsoReference)
+*/
+template <class Reference>
+struct FeatureExtractor {
+
+	/**
+		@param snapshot The joints of all the users in the current frame
+		@param slot The slot of the user in the snapshot
+		@return The feature vector of the user
+	*/
+	static FeatureString extract(const JointSnapshot& snapshot, const int slot) {
+
+		FeatureString featureString;
+
+		// read every joint we need only once
+		const cv::Point3f leftShoulder = snapshot.getPosition(slot, nite::JOINT_LEFT_SHOULDER);
+		const cv::Point3f rightShoulder = snapshot.getPosition(slot, nite::JOINT_RIGHT_SHOULDER);
+		const cv::Point3f leftElbow = snapshot.getPosition(slot, nite::JOINT_LEFT_ELBOW);
+		const cv::Point3f rightElbow = snapshot.getPosition(slot, nite::JOINT_RIGHT_ELBOW);
+		const cv::Point3f leftHand = snapshot.getPosition(slot, nite::JOINT_LEFT_HAND);
+		const cv::Point3f rightHand = snapshot.getPosition(slot, nite::JOINT_RIGHT_HAND);
+		const cv::Point3f leftOrigin = Reference::leftDirectionOrigin(snapshot, slot);
+		const cv::Point3f rightOrigin = Reference::rightDirectionOrigin(snapshot, slot);
+
+		// extract elbow angles for each hand:
+		featureString[FEATURE_ELBOW_ANGLES] = cv::Point2f(
+			fastThreePointAngle(leftShoulder.x, leftShoulder.y, leftShoulder.z, leftElbow.x, leftElbow.y, leftElbow.z, leftHand.x, leftHand.y, leftHand.z),
+			fastThreePointAngle(rightShoulder.x, rightShoulder.y, rightShoulder.z, rightElbow.x, rightElbow.y, rightElbow.z, rightHand.x, rightHand.y, rightHand.z)
+		);
+
+		// extract direction angles to the hands
+		featureString[FEATURE_DIRECTION_ANGLES] = cv::Point2f(
+			fastDirectionAngle(leftOrigin.x, leftOrigin.y, leftHand.x, leftHand.y),
+			fastDirectionAngle(rightOrigin.x, rightOrigin.y, rightHand.x, rightHand.y)
+		);
+
+		extractPoints(snapshot, slot, featureString);
+
+		return featureString;
+	}
+
+	/**
+		Extract the features of all the users in the snapshot at once. The angles are calculated
+		for all the users with the batch kernels, and the results are stored in batch.features,
+		indexed by the slot of the user. The features for the empty slots are left empty.
+
+		@param snapshot The joints of all the users in the current frame
+		@param batch The batch to fill
+	*/
+	static void extractAll(const JointSnapshot& snapshot, FeatureBatch& batch) {
+
+		const int n = snapshot.getCapacity();
+
+		// elbow angles
+		threePointAngles(
+			snapshot.getX(nite::JOINT_LEFT_SHOULDER), snapshot.getY(nite::JOINT_LEFT_SHOULDER), snapshot.getZ(nite::JOINT_LEFT_SHOULDER),
+			snapshot.getX(nite::JOINT_LEFT_ELBOW), snapshot.getY(nite::JOINT_LEFT_ELBOW), snapshot.getZ(nite::JOINT_LEFT_ELBOW),
+			snapshot.getX(nite::JOINT_LEFT_HAND), snapshot.getY(nite::JOINT_LEFT_HAND), snapshot.getZ(nite::JOINT_LEFT_HAND),
+			batch.leftElbowAngles.data(), n);
+
+		threePointAngles(
+			snapshot.getX(nite::JOINT_RIGHT_SHOULDER), snapshot.getY(nite::JOINT_RIGHT_SHOULDER), snapshot.getZ(nite::JOINT_RIGHT_SHOULDER),
+			snapshot.getX(nite::JOINT_RIGHT_ELBOW), snapshot.getY(nite::JOINT_RIGHT_ELBOW), snapshot.getZ(nite::JOINT_RIGHT_ELBOW),
+			snapshot.getX(nite::JOINT_RIGHT_HAND), snapshot.getY(nite::JOINT_RIGHT_HAND), snapshot.getZ(nite::JOINT_RIGHT_HAND),
+			batch.rightElbowAngles.data(), n);
+
+		// direction angles
+		Reference::directionOrigins(snapshot, batch);
+
+		directionAngles(batch.leftOriginX.data(), batch.leftOriginY.data(),
+			snapshot.getX(nite::JOINT_LEFT_HAND), snapshot.getY(nite::JOINT_LEFT_HAND), batch.leftDirections.data(), n);
+
+		directionAngles(batch.rightOriginX.data(), batch.rightOriginY.data(),
+			snapshot.getX(nite::JOINT_RIGHT_HAND), snapshot.getY(nite::JOINT_RIGHT_HAND), batch.rightDirections.data(), n);
+
+		// assemble the feature vectors of the tracked users
+		for (int slot = 0; slot < n; slot++) {
+			FeatureString& featureString = batch.features[slot];
+
+			featureString.valid = false;
+
+			if (!snapshot.isValid(slot))
+				continue;
+
+			featureString[FEATURE_ELBOW_ANGLES] = cv::Point2f(batch.leftElbowAngles[slot], batch.rightElbowAngles[slot]);
+			featureString[FEATURE_DIRECTION_ANGLES] = cv::Point2f(batch.leftDirections[slot], batch.rightDirections[slot]);
+
+			extractPoints(snapshot, slot, featureString);
+		}
+	}
+
+	/**
+		Extract the positions of the elbows and hands, relative to the reference point
+
+		@param snapshot The joints of all the users in the current frame
+		@param slot The slot of the user in the snapshot
+		@param featureString The feature vector, where the positions are stored
+	*/
+	static void extractPoints(const JointSnapshot& snapshot, const int slot, FeatureString& featureString) {
+
+		const cv::Point3f leftShoulder = snapshot.getPosition(slot, nite::JOINT_LEFT_SHOULDER);
+		const cv::Point3f rightShoulder = snapshot.getPosition(slot, nite::JOINT_RIGHT_SHOULDER);
+		const cv::Point3f leftHip = snapshot.getPosition(slot, nite::JOINT_LEFT_HIP);
+
+		const cv::Point3f pointOrigin = Reference::pointOrigin(snapshot, slot);
+
+		// distance between shoulders
+		double shoulderDist = calcDistance(leftShoulder, rightShoulder);
+
+		// height from hip to shoulder
+		double heightDist = calcDistance(leftHip, leftShoulder);
+
+		// extract other points, and make them position and scale invariant
+		const cv::Point3f salientPoints[] = {
+			snapshot.getPosition(slot, nite::JOINT_LEFT_ELBOW), snapshot.getPosition(slot, nite::JOINT_LEFT_HAND),
+			snapshot.getPosition(slot, nite::JOINT_RIGHT_ELBOW), snapshot.getPosition(slot, nite::JOINT_RIGHT_HAND)
+		};
+
+		for (int i = 0; i < 4; i++) {
+			cv::Point3f point = salientPoints[i] - pointOrigin;
+
+			// divide by the shoulder length and the torso height, to make it invariant to user's height and size
+			featureString[FEATURE_LEFT_ELBOW + i] = cv::Point2f(point.x / shoulderDist, point.y / heightDist);
+		}
+
+		featureString.valid = true;
+	}
+};
+
+/**
+	The policies of a feature profile, selected at compile time:
+
+	Reference  The reference point policy of the extractor (see FeatureExtractor)
+	Metric     The metric, that compares the embedded features in the pose estimation (see
+	           KinectPose::findSimilarSamples()). The cascade bounds and the calibrated thresholds
+	           assume the Euclidean norm of the embedded values, so all the profiles use EmbeddedMetric.
+*/
+template <FeatureProfile Profile>
+struct ProfilePolicies;
+
+template <>
+struct ProfilePolicies<PROFILE_HEAD> {
+	typedef HeadReference Reference;
+	typedef EmbeddedMetric Metric;
+};
+
+template <>
+struct ProfilePolicies<PROFILE_BELT> {
+	typedef BeltReference Reference;
+	typedef EmbeddedMetric Metric;
+};
+
+template <>
+struct ProfilePolicies<PROFILE_TORSO> {
+	typedef TorsoReference Reference;
+	typedef EmbeddedMetric Metric;
+};
+
+/**
+	Extract the features of the user, using the extractor of the specified profile
+
+	@param profile The feature profile of the current pose library
+	@param snapshot The joints of all the users in the current frame
+	@param slot The slot of the user in the snapshot
+*/
+FeatureString extractFeatures(const FeatureProfile profile, const JointSnapshot& snapshot, const int slot);
+
+/**
+	Extract the features of all the users in the snapshot at once, using the extractor of the specified profile
+
+	@param profile The feature profile of the current pose library
+	@param snapshot The joints of all the users in the current frame
+	@param batch The batch, where the features are stored
+*/
+void extractFeatures(const FeatureProfile profile, const JointSnapshot& snapshot, FeatureBatch& batch);
@@ -0,0 +1,253 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+#include "Utils.h"
+
+/**
+	The names of the slots of the feature vector. Every slot is a cv::Point2f.
+
+	Name:                    Type:           Description
+	Hand_Elbow_Angles        cv::Point2f     The angles between the upper arm and lower arm
+                                           for each hand (the elbow-angles) in Radians. Both
+                                           hands are recorded in a single cv::Point2f object,
+                                           with X being the left hand, and Y being the right hand
+                                           cv::Point2f::x = left_elbow_angle
+                                           cv::Point2f::y - right_hand_angle
+
+	Hand_Direction_Angles    cv::Point2f     The angle between the position of the user's center of mass
+                                           and the positions of the left and right hands (wrists).
+                                           The "center of mass" depends on the feature extractor
+                                           (see FeatureExtractor.h): the head, the torso or the belt.
+                                           The angles are given in the Descartes (Cartesian) coordinate system:
+                                                                  270
+                                                                   |
+                                                            180----0----360/0
+                                                                   |
+                                                                   90
+                                           Like in the previous case, the angles are stored in one
+                                           cv::Point2f object, with X and Y being left and right hands
+                                           respectively.
+
+	Left_Elbow_Position      cv::Point2f     The position of the user's left elbow relative to the center of mass
+
+	Left_Hand_Position       cv::Point2f     The position of the user's left wrist relative to the center of mass
+
+	Right_Elbow_Position     cv::Point2f     The position of the user's right elbow relative to the center of mass
+
+	Right_Hand_Position      cv::Point2f     The position of the user's right wrist relative to the center of mass
+
+	In the latter four cases the positions of the wrists and elbows are calculated relative to the center of mass.
+	Because positions are relative, the left hand will be a negative value, and the right hand will be in most
+	cases a positive value.
+	Note, that the positions are not only relative, but also scale invariant, as the X coordinates are divided by the
+	distance between uses's shoulders and the Y is divided by the height of the uses's torso.
+*/
+enum FeatureSlot {
+	FEATURE_ELBOW_ANGLES = 0,
+	FEATURE_DIRECTION_ANGLES,
+	FEATURE_LEFT_ELBOW,
+	FEATURE_LEFT_HAND,
+	FEATURE_RIGHT_ELBOW,
+	FEATURE_RIGHT_HAND,
+	NUM_FEATURE_SLOTS
+};
+
+/**
+	How the values in a slot are compared to each other
+*/
+enum FeatureKind {
+	FEATURE_KIND_ANGLE,        // a pair of plain angles (radians)
+	FEATURE_KIND_DIRECTION,    // a pair of direction angles (degrees, wrapping at 360)
+	FEATURE_KIND_POINT         // a 2D point
+};
+
+/**
+	The compile-time description of the feature vector.
+*/
+struct FeatureSchema {
+
+	// number of slots in the feature vector
+	static const int size = NUM_FEATURE_SLOTS;
+
+	// number of squared terms in the distance between two feature vectors
+	// (two per angle slot, one per point slot)
+	static const int numDistanceTerms = 8;
+
+	/**
+		Get the kind of the values in the specified slot
+	*/
+	static constexpr FeatureKind kind(const int slot) {
+		return (slot == FEATURE_ELBOW_ANGLES) ? FEATURE_KIND_ANGLE :
+			(slot == FEATURE_DIRECTION_ANGLES) ? FEATURE_KIND_DIRECTION : FEATURE_KIND_POINT;
+	}
+};
+
+/**
+	The vector of features, extracted from the current user in one frame.
+	A fixed-size array of slots, described by the FeatureSchema. Lives on the stack,
+	so no heap allocation is needed per feature vector.
+
+	Thus, the feature vector looks like this:
+	featureString[FEATURE_ELBOW_ANGLES]     = cv::Point2f(left_elbow_angle, right_elbow_angle)
+	featureString[FEATURE_DIRECTION_ANGLES] = cv::Point2f(left_hand_angle,  right_hand_angle)
+	featureString[FEATURE_LEFT_ELBOW]       = cv::Point2f(left_elbow.x, left_elbow.y)
+	featureString[FEATURE_LEFT_HAND]        = cv::Point2f(left_hand.x,  left_hand.y)
+	featureString[FEATURE_RIGHT_ELBOW]      = cv::Point2f(right_elbow.x, right_elbow.y)
+	featureString[FEATURE_RIGHT_HAND]       = cv::Point2f(right_hand.x,  right_hand.y)
+
+	A default-constructed feature string is empty, which means that no features could be
+	extracted (e.g. the joints were not confident enough).
+*/
+struct FeatureString {
+
+	cv::Point2f slots[NUM_FEATURE_SLOTS];
+
+	bool valid;
+
+	FeatureString() {
+		valid = false;
+	}
+
+	bool isEmpty() const { return !valid; }
+
+	cv::Point2f& operator[](const int slot) { return slots[slot]; }
+	const cv::Point2f& operator[](const int slot) const { return slots[slot]; }
+};
+
+/**
+	The squared distance between two values of a slot, depending on the kind of the slot
+*/
+template <FeatureKind Kind>
+struct SlotDistance;
+
+template <>
+struct SlotDistance<FEATURE_KIND_ANGLE> {
+	static double squared(const cv::Point2f& a, const cv::Point2f& b) {
+		double dx = a.x - b.x;
+		double dy = a.y - b.y;
+		return dx * dx + dy * dy;
+	}
+};
+
+template <>
+struct SlotDistance<FEATURE_KIND_DIRECTION> {
+	static double squared(const cv::Point2f& a, const cv::Point2f& b) {
+		double dx = angleDifference(a.x, b.x);
+		double dy = angleDifference(a.y, b.y);
+		return dx * dx + dy * dy;
+	}
+};
+
+template <>
+struct SlotDistance<FEATURE_KIND_POINT> {
+	static double squared(const cv::Point2f& a, const cv::Point2f& b) {
+		double dx = a.x - b.x;
+		double dy = a.y - b.y;
+		return dx * dx + dy * dy;
+	}
+};
+
+/**
+	Sum of the squared slot distances, unrolled at compile time over the slots of the schema
+*/
+template <int Slot>
+struct SlotDistanceSum {
+	static double squared(const FeatureString& a, const FeatureString& b) {
+		return SlotDistance<FeatureSchema::kind(Slot)>::squared(a[Slot], b[Slot]) + SlotDistanceSum<Slot - 1>::squared(a, b);
+	}
+};
+
+template <>
+struct SlotDistanceSum<-1> {
+	static double squared(const FeatureString&, const FeatureString&) {
+		return 0;
+	}
+};
+
+/**
+	The original metric: the Euclidian distance over all the terms of the feature vectors,
+	where the direction angles are compared with the wrap at 0/360:
+
+	d = sqrt( a^2 + b^2 + c^2 + ... )
+*/
+struct LegacyMetric {
+	static double distance(const FeatureString& a, const FeatureString& b) {
+		return std::sqrt(SlotDistanceSum<FeatureSchema::size - 1>::squared(a, b));
+	}
+};
+
+// number of values in the embedded feature vector
+#define EMBEDDED_SIZE 14
+
+// the scale of the embedded direction angles. With this scale the chord between two directions
+// on the unit circle is (for small differences) the same as the difference in degrees
+#define EMBEDDED_ANGLE_SCALE (180.0 / PI)
+
+/**
+	The feature vector, embedded into a plain Euclidean space.
+
+	The direction angles are replaced with points on the unit circle (cos, sin), so the wrap at 0/360
+	disappears, and the distance between two feature vectors becomes a plain Euclidean norm.
+	The weights of the terms are folded into the values (the unit circle is scaled by EMBEDDED_ANGLE_SCALE),
+	so no per-term weighting is needed at the comparison time:
+
+	values[0..1]   left and right elbow angles (radians)
+	values[2..3]   the left hand direction (cos, sin) * EMBEDDED_ANGLE_SCALE
+	values[4..5]   the right hand direction (cos, sin) * EMBEDDED_ANGLE_SCALE
+	values[6..13]  the positions of the left elbow, left hand, right elbow and right hand (x, y)
+*/
+struct EmbeddedFeature {
+	float values[EMBEDDED_SIZE];
+};
+
+/**
+	Embed the feature vector into the Euclidean space (see EmbeddedFeature)
+
+	@param featureString The feature vector
+	@return The embedded feature vector
+*/
+inline EmbeddedFeature embedFeatures(const FeatureString& featureString) {
+	EmbeddedFeature result;
+
+	const double toRadians = PI / 180;
+
+	const cv::Point2f& elbows = featureString[FEATURE_ELBOW_ANGLES];
+	const cv::Point2f& directions = featureString[FEATURE_DIRECTION_ANGLES];
+
+	result.values[0] = elbows.x;
+	result.values[1] = elbows.y;
+	result.values[2] = (float)(std::cos(directions.x * toRadians) * EMBEDDED_ANGLE_SCALE);
+	result.values[3] = (float)(std::sin(directions.x * toRadians) * EMBEDDED_ANGLE_SCALE);
+	result.values[4] = (float)(std::cos(directions.y * toRadians) * EMBEDDED_ANGLE_SCALE);
+	result.values[5] = (float)(std::sin(directions.y * toRadians) * EMBEDDED_ANGLE_SCALE);
+
+	for (int i = FEATURE_LEFT_ELBOW; i < FeatureSchema::size; i++) {
+		result.values[6 + (i - FEATURE_LEFT_ELBOW) * 2] = featureString[i].x;
+		result.values[7 + (i - FEATURE_LEFT_ELBOW) * 2] = featureString[i].y;
+	}
+
+	return result;
+}
+
+/**
+	The metric for the embedded feature vectors: the plain Euclidean distance
+
+	d = sqrt( (a0-b0)^2 + (a1-b1)^2 + ... )
+*/
+struct EmbeddedMetric {
+	static double squared(const EmbeddedFeature& a, const EmbeddedFeature& b) {
+		float result = 0;
+
+		for (int i = 0; i < EMBEDDED_SIZE; i++) {
+			float d = a.values[i] - b.values[i];
+			result += d * d;
+		}
+
+		return result;
+	}
+
+	static double distance(const EmbeddedFeature& a, const EmbeddedFeature& b) {
+		return std::sqrt(squared(a, b));
+	}
+};
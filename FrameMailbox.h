@@ -0,0 +1,208 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#define MAILBOX_DEFAULT_CAPACITY 2    // the default number of frames waiting for the consumer (for BACKPRESSURE_DROP_OLDEST and BACKPRESSURE_BLOCK)
+
+/**
+	What happens, when the producer is faster than the consumer of the frames
+*/
+enum BackpressurePolicy {
+
+	// a single slot: a new frame replaces the one, that wasn't taken yet (the frames are coalesced)
+	BACKPRESSURE_LATEST_WINS = 0,
+
+	// a bounded queue: when it's full, the oldest frame is dropped to make space for the new one
+	BACKPRESSURE_DROP_OLDEST,
+
+	// a bounded queue: when it's full, the producer waits for the consumer
+	BACKPRESSURE_BLOCK
+};
+
+/**
+	The counters of the mailbox
+*/
+struct MailboxStatistics {
+
+	// the frames posted by the producer
+	unsigned long long posted = 0;
+
+	// the frames taken by the consumer
+	unsigned long long delivered = 0;
+
+	// the frames dropped from a full queue (BACKPRESSURE_DROP_OLDEST)
+	unsigned long long dropped = 0;
+
+	// the frames replaced by a newer one (BACKPRESSURE_LATEST_WINS)
+	unsigned long long coalesced = 0;
+};
+
+/**
+	Passes the frames from one producer thread to one consumer thread, with a bounded number
+	of frames in between, so the latency can't grow without bound when the consumer falls behind.
+
+	How the producer is slowed down (or which frames are given up) is set by the BackpressurePolicy.
+	The frames are moved in and out, so a frame holding cv::Mat buffers (see FramePool) is never copied.
+
+	@tparam T The type of the frame. Must be default constructible and movable.
+*/
+template <typename T>
+class FrameMailbox {
+
+public:
+	/**
+		Create the mailbox
+
+		@param policy What to do with the new frames, when the consumer is behind
+		@param capacity The maximum number of waiting frames. Always 1 for BACKPRESSURE_LATEST_WINS.
+	*/
+	FrameMailbox(const BackpressurePolicy policy = BACKPRESSURE_LATEST_WINS, const int capacity = MAILBOX_DEFAULT_CAPACITY) {
+		this->policy = policy;
+		this->capacity = (policy == BACKPRESSURE_LATEST_WINS || capacity < 1) ? 1 : capacity;
+	}
+
+	/**
+		Post a new frame. With BACKPRESSURE_BLOCK this waits, until there's space for it.
+
+		@param frame The frame, it's moved into the mailbox
+		@return Returns "false" if the mailbox was closed (the frame is thrown away).
+	*/
+	bool post(T&& frame) {
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			if (policy == BACKPRESSURE_BLOCK)
+				notFull.wait(lock, [this] { return closed || frames.size() < capacity; });
+
+			if (closed)
+				return false;
+
+			if (frames.size() >= capacity) {
+				frames.pop_front();
+
+				if (policy == BACKPRESSURE_LATEST_WINS)
+					statistics.coalesced++;
+				else
+					statistics.dropped++;
+			}
+
+			frames.push_back(std::move(frame));
+			statistics.posted++;
+		}
+
+		notEmpty.notify_one();
+
+		return true;
+	}
+
+	/**
+		Take the oldest waiting frame, wait for one if there's none
+
+		@param frame Receives the frame
+		@return Returns "false" if the mailbox was closed, and there are no more frames.
+	*/
+	bool take(T& frame) {
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			notEmpty.wait(lock, [this] { return closed || !frames.empty(); });
+
+			if (frames.empty())
+				return false;
+
+			frame = std::move(frames.front());
+			frames.pop_front();
+			statistics.delivered++;
+		}
+
+		notFull.notify_one();
+
+		return true;
+	}
+
+	/**
+		Take the oldest waiting frame, if there is one
+
+		@param frame Receives the frame
+		@return Returns "false" if no frame was waiting.
+	*/
+	bool tryTake(T& frame) {
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (frames.empty())
+				return false;
+
+			frame = std::move(frames.front());
+			frames.pop_front();
+			statistics.delivered++;
+		}
+
+		notFull.notify_one();
+
+		return true;
+	}
+
+	/**
+		Close the mailbox, and wake up both sides. The frames already waiting can still be taken.
+	*/
+	void close() {
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			closed = true;
+		}
+
+		notEmpty.notify_all();
+		notFull.notify_all();
+	}
+
+	/**
+		Throw away the waiting frames, reset the counters and open the mailbox again
+	*/
+	void reset(const BackpressurePolicy policy, const int capacity) {
+		std::lock_guard<std::mutex> lock(mutex);
+
+		this->policy = policy;
+		this->capacity = (policy == BACKPRESSURE_LATEST_WINS || capacity < 1) ? 1 : capacity;
+
+		frames.clear();
+		statistics = MailboxStatistics();
+		closed = false;
+	}
+
+	/**
+		Get the counters
+	*/
+	MailboxStatistics getStatistics() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return statistics;
+	}
+
+	/**
+		Get the policy of the mailbox
+	*/
+	BackpressurePolicy getPolicy() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return policy;
+	}
+
+private:
+	// the waiting frames, the oldest first
+	std::deque<T> frames;
+
+	BackpressurePolicy policy;
+	size_t capacity;
+
+	// guards everything
+	mutable std::mutex mutex;
+	std::condition_variable notEmpty;
+	std::condition_variable notFull;
+	bool closed = false;
+
+	MailboxStatistics statistics;
+};
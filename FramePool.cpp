@@ -0,0 +1,48 @@
+#include "FramePool.h"
+
+FramePool::FramePool(const int maxBuffers) {
+	this->maxBuffers = maxBuffers;
+	buffers.reserve(maxBuffers);
+}
+
+cv::Mat FramePool::acquire(const int rows, const int cols, const int type) {
+
+	// first try to find a free buffer of the same size, so nothing is reallocated
+	for (cv::Mat& buffer : buffers) {
+		if (isFree(buffer) && buffer.rows == rows && buffer.cols == cols && buffer.type() == type)
+			return buffer;
+	}
+
+	// then any free buffer, which is reallocated to the new size
+	for (cv::Mat& buffer : buffers) {
+		if (isFree(buffer)) {
+			buffer.release();
+			buffer.create(rows, cols, type);
+			allocations++;
+			return buffer;
+		}
+	}
+
+	allocations++;
+
+	// there's still space for a new buffer
+	if (buffers.size() < maxBuffers) {
+		buffers.push_back(cv::Mat(rows, cols, type));
+		return buffers.back();
+	}
+
+	// everything is in use
+	return cv::Mat(rows, cols, type);
+}
+
+int FramePool::getAllocations() const {
+	return this->allocations;
+}
+
+FramePool::~FramePool() {
+	buffers.clear();
+}
+
+bool FramePool::isFree(const cv::Mat& buffer) const {
+	return buffer.u != nullptr && buffer.u->refcount == 1;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+#include <vector>
+
+/**
+	A small pool of preallocated image buffers, that are recycled between frames.
+
+	The pool relies on the reference counting of the cv::Mat: a buffer is free, when the pool
+	holds the only reference to it. Every cv::Mat handed out by acquire() shares the data with
+	the pooled buffer, so as long as somebody (e.g. the caller of getOriginalFrame()) keeps the
+	image, the buffer is not reused, and once all the copies are released, it goes back to the pool
+	automatically. This way the frames are never reallocated and never overwritten while in use.
+*/
+class FramePool {
+
+public:
+	/**
+		Create a new pool
+
+		@param maxBuffers The maximum number of buffers in the pool. Default: 3.
+	*/
+	FramePool(const int maxBuffers = 3);
+
+	/**
+		Get a free buffer of the specified size and type. If there's no free buffer
+		and the pool is full, a new (not pooled) image is allocated.
+
+		@param rows The height of the image
+		@param cols The width of the image
+		@param type The type of the image (CV_8UC3, CV_16UC1, etc.)
+		@return An image, that nobody else references
+	*/
+	cv::Mat acquire(const int rows, const int cols, const int type);
+
+	/**
+		Get the number of memory allocations the pool has done so far.
+		After the warm-up this number should not grow.
+	*/
+	int getAllocations() const;
+
+	~FramePool();
+
+private:
+	// the pooled buffers
+	std::vector<cv::Mat> buffers;
+
+	// maximum number of buffers
+	int maxBuffers;
+
+	// number of allocations
+	int allocations = 0;
+
+	/**
+		Check if the buffer is referenced only by the pool
+	*/
+	bool isFree(const cv::Mat& buffer) const;
+};
@@ -0,0 +1,288 @@
+#include "GestureRecognizer.h"
+#include "KinectPose.h"
+
+#include <limits>
+
+// GestureTemplate
+
+GestureTemplate::GestureTemplate(const std::string& name, const double threshold, const std::vector<FeatureString>& frames) {
+	this->name = name;
+	this->threshold = threshold;
+
+	for (const FeatureString& frame : frames) {
+		if (!frame.isEmpty())
+			this->features.push_back(frame);
+	}
+
+	prepare();
+}
+
+bool GestureTemplate::load(const std::string& fileName) {
+
+	std::ifstream ifs(fileName, std::ios::in);
+
+	if (!ifs.is_open()) {
+		std::cerr << "Couldn't open the gesture file " << fileName << std::endl;
+		return false;
+	}
+
+	ifs.close();
+
+	// the format is the same as of the poses, so the pose parses it
+	KinectPose pose(0, fileName);
+
+	this->name = pose.getPoseName();
+	this->threshold = (pose.getReferenceEstimate() > 0) ? pose.getReferenceEstimate() : GESTURE_DEFAULT_THRESHOLD;
+	this->features = pose.getFeatureVector();
+
+	prepare();
+
+	if (frames.empty()) {
+		std::cerr << "The gesture " << fileName << " has no frames" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool GestureTemplate::save(const std::string& fileName) const {
+
+	std::ofstream ofs(fileName, std::ios::out);
+
+	if (!ofs.is_open()) {
+		std::cerr << "Couldn't create the gesture file " << fileName << std::endl;
+		return false;
+	}
+
+	ofs << name << std::endl;
+	ofs << threshold << std::endl;
+
+	for (int i = 0; i < FeatureSchema::size; i++) {
+		for (const FeatureString& frame : features) {
+			ofs << frame[i].x << "," << frame[i].y << ";";
+		}
+		ofs << std::endl;
+	}
+
+	ofs.close();
+
+	return true;
+}
+
+void GestureTemplate::prepare() {
+
+	frames.clear();
+
+	for (const FeatureString& feature : features) {
+		frames.push_back(embedFeatures(feature));
+	}
+}
+
+const std::string& GestureTemplate::getName() const {
+	return this->name;
+}
+
+double GestureTemplate::getThreshold() const {
+	return this->threshold;
+}
+
+int GestureTemplate::length() const {
+	return (int)frames.size();
+}
+
+const std::vector<EmbeddedFeature>& GestureTemplate::getFrames() const {
+	return this->frames;
+}
+
+// GestureRecognizer
+
+GestureRecognizer::GestureRecognizer(const int maxUsers) : users((std::max)(1, maxUsers)) {
+}
+
+bool GestureRecognizer::loadGestures(const std::string& folder) {
+
+	std::vector<std::string> files = get_all_files_names_within_folder(folder);
+
+	for (const std::string& file : files) {
+		if (file.find(".txt") == std::string::npos)
+			continue;
+
+		GestureTemplate gesture("", GESTURE_DEFAULT_THRESHOLD, std::vector<FeatureString>());
+
+		if (gesture.load(file))
+			addGesture(gesture);
+	}
+
+	return hasGestures();
+}
+
+int GestureRecognizer::addGesture(const GestureTemplate& gesture) {
+
+	if (gesture.length() == 0 || gesture.length() > GESTURE_HISTORY) {
+		std::cerr << "The gesture " << gesture.getName() << " must have from 1 to " << GESTURE_HISTORY << " frames" << std::endl;
+		return -1;
+	}
+
+	gestures.push_back(gesture);
+
+	for (UserHistory& user : users) {
+		user.states.resize(gestures.size());
+		resetState(user.states.back(), gesture.length());
+	}
+
+	return (int)gestures.size() - 1;
+}
+
+const std::vector<GestureTemplate>& GestureRecognizer::getGestures() const {
+	return this->gestures;
+}
+
+bool GestureRecognizer::hasGestures() const {
+	return !gestures.empty();
+}
+
+int GestureRecognizer::update(const int slot, const FeatureString& featureString, std::vector<GestureMatch>& matches) {
+
+	if (slot < 0 || slot >= (int)users.size())
+		return 0;
+
+	if (featureString.isEmpty()) {
+		reset(slot);
+		return 0;
+	}
+
+	UserHistory& user = users[slot];
+
+	EmbeddedFeature embedded = embedFeatures(featureString);
+
+	user.frame++;
+
+	int found = 0;
+
+	for (int g = 0; g < (int)gestures.size(); g++) {
+		GestureMatch match;
+
+		if (updateState(user.states[g], gestures[g], embedded, user.frame, match)) {
+			match.gestureIndex = g;
+
+			matches.push_back(match);
+			found++;
+		}
+	}
+
+	return found;
+}
+
+void GestureRecognizer::reset(const int slot) {
+
+	if (slot < 0 || slot >= (int)users.size())
+		return;
+
+	UserHistory& user = users[slot];
+
+	for (int g = 0; g < (int)gestures.size(); g++) {
+		resetState(user.states[g], gestures[g].length());
+	}
+}
+
+void GestureRecognizer::resetState(MatchState& state, const int length) {
+
+	state.distances.assign(length + 1, std::numeric_limits<double>::infinity());
+	state.starts.assign(length + 1, 0);
+	state.bestDistance = std::numeric_limits<double>::infinity();
+}
+
+bool GestureRecognizer::updateState(MatchState& state, const GestureTemplate& gesture, const EmbeddedFeature& frame, const unsigned long long t, GestureMatch& match) {
+
+	const std::vector<EmbeddedFeature>& frames = gesture.getFrames();
+
+	const int n = gesture.length();
+	const double infinity = std::numeric_limits<double>::infinity();
+	const double squaredThreshold = gesture.getThreshold() * gesture.getThreshold();
+
+	// the longest and the shortest motion, that may match the gesture
+	const unsigned long long maxFrames = (unsigned long long)(n * GESTURE_MAX_STRETCH);
+	const unsigned long long minFrames = (std::max)(1ULL, (unsigned long long)std::ceil(n / GESTURE_MAX_STRETCH));
+
+	// the cell above the first gesture frame: every frame may start a new path
+	double diagonal = 0;
+	unsigned long long diagonalStart = t;
+
+	double left = infinity;
+	unsigned long long leftStart = t;
+
+	for (int j = 1; j <= n; j++) {
+
+		// the cell of the previous frame at the same gesture frame, if its path isn't too long yet
+		double up = (t - state.starts[j] < maxFrames) ? state.distances[j] : infinity;
+		unsigned long long upStart = state.starts[j];
+
+		if (diagonalStart + maxFrames <= t)
+			diagonal = infinity;
+
+		double best = diagonal;
+		unsigned long long bestStart = diagonalStart;
+
+		if (left < best) {
+			best = left;
+			bestStart = leftStart;
+		}
+
+		if (up < best) {
+			best = up;
+			bestStart = upStart;
+		}
+
+		// the previous frame at this gesture frame is the diagonal of the next one
+		diagonal = state.distances[j];
+		diagonalStart = upStart;
+
+		state.distances[j] = (best < infinity) ? best + EmbeddedMetric::squared(frame, frames[j - 1]) : infinity;
+		state.starts[j] = bestStart;
+
+		left = state.distances[j];
+		leftStart = bestStart;
+	}
+
+	bool reported = false;
+
+	// report the best match, once no path, that overlaps it, can be better
+	if (state.bestDistance < infinity) {
+		bool improving = false;
+
+		for (int j = 1; j <= n; j++) {
+			if (state.distances[j] < state.bestDistance && state.starts[j] <= state.bestEnd)
+				improving = true;
+		}
+
+		if (!improving) {
+			const unsigned long long length = state.bestEnd - state.bestStart + 1;
+
+			match.distance = std::sqrt(state.bestDistance / (std::max)((unsigned long long)n, length));
+			match.margin = 1.0 - match.distance / gesture.getThreshold();
+			match.frames = (int)length;
+
+			reported = true;
+
+			// the paths, that overlap the reported match, are discarded
+			for (int j = 1; j <= n; j++) {
+				if (state.starts[j] <= state.bestEnd)
+					state.distances[j] = infinity;
+			}
+
+			state.bestDistance = infinity;
+		}
+	}
+
+	// a path through the whole gesture ends here
+	const double distance = state.distances[n];
+	const unsigned long long length = t - state.starts[n] + 1;
+
+	if (distance < state.bestDistance && length >= minFrames && distance <= squaredThreshold * (std::max)((unsigned long long)n, length)) {
+		state.bestDistance = distance;
+		state.bestStart = state.starts[n];
+		state.bestEnd = t;
+	}
+
+	return reported;
+}
@@ -0,0 +1,244 @@
+#pragma once
+
+#include "FeatureSchema.h"
+
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#define GESTURE_HISTORY 64               // the maximum length of a gesture, in frames
+#define GESTURE_MAX_STRETCH 2.0          // how many times slower or faster than recorded a gesture may be performed
+#define GESTURE_DEFAULT_THRESHOLD 20.0   // the default maximum distance per frame, for the newly recorded gestures
+
+/**
+	A recorded motion gesture, like a beat of a conductor or a strike of a drummer:
+	a short sequence of feature vectors, one per frame.
+
+	The gesture files have the same format as the pose files (see PoseModel::load()), except
+	that every column is one frame of the gesture, in the order they were recorded, and the second
+	line is the maximum average distance per frame (in the embedded space, see EmbeddedFeature),
+	at which the gesture is still recognized:
+
+	Gesture_name
+	Threshold
+	Left_elbow_angle,Right_elbow_angle;     (first frame; second frame; ...)
+	...
+*/
+class GestureTemplate {
+
+public:
+	/**
+		Create the gesture from the recorded frames
+
+		@param name The name of the gesture
+		@param threshold The maximum average distance per frame
+		@param frames The feature vectors of the frames. The empty ones are skipped.
+	*/
+	GestureTemplate(const std::string& name, const double threshold, const std::vector<FeatureString>& frames);
+
+	/**
+		Load the gesture from a file
+
+		@param fileName The path to the gesture file
+
+		@return Returns "false" if the file couldn't be read, or doesn't contain a valid gesture.
+	*/
+	bool load(const std::string& fileName);
+
+	/**
+		Save the gesture to a file
+
+		@param fileName The path to the gesture file
+
+		@return Returns "false" if the file couldn't be written.
+	*/
+	bool save(const std::string& fileName) const;
+
+	/**
+		Get the name of the gesture
+	*/
+	const std::string& getName() const;
+
+	/**
+		Get the maximum average distance per frame, at which the gesture is still recognized
+	*/
+	double getThreshold() const;
+
+	/**
+		Get the number of frames in the gesture
+	*/
+	int length() const;
+
+	/**
+		Get the embedded frames of the gesture
+	*/
+	const std::vector<EmbeddedFeature>& getFrames() const;
+
+private:
+	// the name of the gesture
+	std::string name;
+
+	// the maximum average distance per frame
+	double threshold = GESTURE_DEFAULT_THRESHOLD;
+
+	// the recorded frames, and the same frames embedded
+	std::vector<FeatureString> features;
+	std::vector<EmbeddedFeature> frames;
+
+	/**
+		Embed the frames
+	*/
+	void prepare();
+};
+
+/**
+	A recognized gesture
+*/
+struct GestureMatch {
+
+	// the index of the gesture
+	int gestureIndex;
+
+	// the average distance per frame between the gesture and the motion
+	double distance;
+
+	// the number of the frames of the motion, that matched the gesture
+	int frames;
+
+	// how far inside the threshold is the distance: 1 - distance / threshold
+	double margin;
+};
+
+/**
+	Recognizes the gestures in the stream of feature vectors of every user.
+
+	The gestures are found with the subsequence Dynamic Time Warping (SPRING, Sakurai et al. 2007):
+	for every user and gesture, one column of the DTW matrix is kept, the cumulative squared
+	distance of the best warping path, that ends with the current frame at each frame of the gesture,
+	together with the frame, where the path started. Every new frame updates the column in O(N)
+	(N being the length of the gesture), and any frame may start a new path, so the motion is
+	matched with the whole gesture at any start and at any speed, without keeping the past frames.
+
+	A match is a path through the whole gesture, whose squared distance is at most
+	threshold^2 * max(N, M), M being the number of the motion frames, i.e. the average distance per
+	frame (over the longer of the two) is within the threshold. The motion may be from N / GESTURE_MAX_STRETCH
+	to N * GESTURE_MAX_STRETCH frames long; the longer paths are cut off.
+
+	Overlapping matches are reported once: the best one is kept, until no path, that overlaps it,
+	can be better. It's then reported (a few frames after the end of the gesture), and the paths, that
+	overlap it, are discarded.
+
+	The cost per user and frame is constant, O(N) for every gesture.
+*/
+class GestureRecognizer {
+
+public:
+	/**
+		Create the recognizer
+
+		@param maxUsers The maximum number of users. The user slots have to be lower than this value.
+	*/
+	GestureRecognizer(const int maxUsers);
+
+	/**
+		Load the gestures from the .txt files in the folder (see GestureTemplate)
+
+		@param folder The name of the folder that contains the gestures
+
+		@return Returns "true" if at least one gesture was loaded.
+	*/
+	bool loadGestures(const std::string& folder);
+
+	/**
+		Add a gesture
+
+		@param gesture The gesture
+		@return The index of the gesture, or -1 if the gesture is empty or too long.
+	*/
+	int addGesture(const GestureTemplate& gesture);
+
+	/**
+		Get all the gestures
+	*/
+	const std::vector<GestureTemplate>& getGestures() const;
+
+	/**
+		Check if any gestures are loaded. If not, nothing needs to be tracked.
+	*/
+	bool hasGestures() const;
+
+	/**
+		Add the next frame of the user, and report the gestures, whose best match is settled
+
+		@param slot The slot of the user (the NiTE user id)
+		@param featureString The features of the user in this frame. An empty feature string breaks the motion.
+		@param matches The recognized gestures are appended to this vector
+
+		@return The number of the recognized gestures
+	*/
+	int update(const int slot, const FeatureString& featureString, std::vector<GestureMatch>& matches);
+
+	/**
+		Forget the motion of the user, e.g. when the user is lost
+	*/
+	void reset(const int slot);
+
+private:
+	/**
+		The state of the matching of one gesture for one user
+	*/
+	struct MatchState {
+
+		// the column of the DTW matrix at the last frame: distances[j] is the squared distance of the
+		// best path, that ends at the gesture frame j - 1, and starts[j] is the first motion frame of the path
+		std::vector<double> distances;
+		std::vector<unsigned long long> starts;
+
+		// the best match, that wasn't reported yet: its squared distance (infinity if there's none),
+		// and its first and last motion frame
+		double bestDistance = std::numeric_limits<double>::infinity();
+		unsigned long long bestStart = 0;
+		unsigned long long bestEnd = 0;
+	};
+
+	/**
+		The matching state of one user
+	*/
+	struct UserHistory {
+
+		// the number of the current frame
+		unsigned long long frame = 0;
+
+		// one per gesture
+		std::vector<MatchState> states;
+	};
+
+	// the gestures
+	std::vector<GestureTemplate> gestures;
+
+	// the motion of every user
+	std::vector<UserHistory> users;
+
+	/**
+		Forget all the paths of the gesture
+
+		@param state The matching state
+		@param length The length of the gesture
+	*/
+	static void resetState(MatchState& state, const int length);
+
+	/**
+		Add the next frame to the matching of the gesture
+
+		@param state The matching state of the gesture for the user
+		@param gesture The gesture
+		@param frame The embedded features of the user in this frame
+		@param t The number of the frame
+		@param match Set to the match, that was just reported
+
+		@return Returns "true" if a match was reported.
+	*/
+	static bool updateState(MatchState& state, const GestureTemplate& gesture, const EmbeddedFeature& frame, const unsigned long long t, GestureMatch& match);
+};
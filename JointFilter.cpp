@@ -0,0 +1,106 @@
+#include "JointFilter.h"
+
+#include <cmath>
+
+#define FILTER_TWO_PI 6.28318530718f
+
+JointFilter::JointFilter(const int capacity) {
+	this->capacity = capacity;
+
+	previousX = previousY = previousZ = std::vector<float>(NUM_JOINTS * capacity, 0.f);
+	speedX = speedY = speedZ = std::vector<float>(NUM_JOINTS * capacity, 0.f);
+	active = std::vector<float>(capacity, 0.f);
+
+	// the torso barely moves, the hands move the fastest. With these values the jitter of a joint held
+	// still drops to about a third, and a hand swinging at 1 m/s isn't delayed more than the raw jitter
+	const JointFilterParams body = { 0.5f, 0.005f };
+	const JointFilterParams arms = { 1.0f, 0.02f };
+	const JointFilterParams hands = { 1.0f, 0.05f };
+
+	for (int j = 0; j < NUM_JOINTS; j++) {
+		params[j] = body;
+	}
+
+	params[nite::JOINT_LEFT_ELBOW] = params[nite::JOINT_RIGHT_ELBOW] = arms;
+	params[nite::JOINT_LEFT_HAND] = params[nite::JOINT_RIGHT_HAND] = hands;
+}
+
+void JointFilter::setParams(const nite::JointType type, const JointFilterParams& params) {
+	this->params[type] = params;
+}
+
+JointFilterParams JointFilter::getParams(const nite::JointType type) const {
+	return this->params[type];
+}
+
+void JointFilter::apply(JointSnapshot& snapshot, const unsigned long long timestamp) {
+
+	if (snapshot.getCapacity() != capacity)
+		return;
+
+	float dt = (timestamp > previousTimestamp) ? (timestamp - previousTimestamp) / 1e6f : 0.f;
+	previousTimestamp = timestamp;
+
+	// after a gap (or at the start) every user starts again
+	bool restart = (dt <= 0 || dt > FILTER_MAX_GAP);
+
+	for (int slot = 0; slot < capacity; slot++) {
+		active[slot] = (!restart && active[slot] > 0 && snapshot.isValid(slot)) ? 1.f : 0.f;
+	}
+
+	const float invDt = restart ? 0.f : 1.f / dt;
+
+	// the smoothing factor of the speed is the same for all the joints
+	const float derivativeTau = FILTER_TWO_PI * FILTER_DERIVATIVE_CUTOFF * dt;
+	const float derivativeAlpha = derivativeTau / (derivativeTau + 1.f);
+
+	float* x = snapshot.getAllX();
+	float* y = snapshot.getAllY();
+	float* z = snapshot.getAllZ();
+
+	for (int j = 0; j < NUM_JOINTS; j++) {
+		const float minCutoff = params[j].minCutoff;
+		const float beta = params[j].beta;
+
+		const int begin = j * capacity;
+
+		for (int slot = 0; slot < capacity; slot++) {
+			const int i = begin + slot;
+			const float keep = active[slot];
+
+			// the filtered speed of the joint
+			float vx = speedX[i] + derivativeAlpha * ((x[i] - previousX[i]) * invDt - speedX[i]);
+			float vy = speedY[i] + derivativeAlpha * ((y[i] - previousY[i]) * invDt - speedY[i]);
+			float vz = speedZ[i] + derivativeAlpha * ((z[i] - previousZ[i]) * invDt - speedZ[i]);
+
+			// the faster the joint, the higher the cutoff frequency
+			const float speed = std::sqrt(vx * vx + vy * vy + vz * vz);
+			const float tau = FILTER_TWO_PI * (minCutoff + beta * speed) * dt;
+
+			// a new user takes the raw position (alpha = 1) and no speed
+			const float alpha = keep * (tau / (tau + 1.f)) + (1.f - keep);
+
+			x[i] = previousX[i] + alpha * (x[i] - previousX[i]);
+			y[i] = previousY[i] + alpha * (y[i] - previousY[i]);
+			z[i] = previousZ[i] + alpha * (z[i] - previousZ[i]);
+
+			previousX[i] = x[i];
+			previousY[i] = y[i];
+			previousZ[i] = z[i];
+
+			speedX[i] = keep * vx;
+			speedY[i] = keep * vy;
+			speedZ[i] = keep * vz;
+		}
+	}
+
+	// the users of this frame are filtered from the next one on
+	for (int slot = 0; slot < capacity; slot++) {
+		active[slot] = snapshot.isValid(slot) ? 1.f : 0.f;
+	}
+}
+
+void JointFilter::reset() {
+	std::fill(active.begin(), active.end(), 0.f);
+	previousTimestamp = 0;
+}
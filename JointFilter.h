@@ -0,0 +1,86 @@
+#pragma once
+
+#include "JointSnapshot.h"
+
+#define FILTER_DERIVATIVE_CUTOFF 1.0f   // the cutoff frequency of the speed estimate, in Hz
+#define FILTER_MAX_GAP 0.5f             // the longest gap between two frames, in seconds; after a longer one the filter restarts
+
+/**
+	The tuning of the filter for one joint (see JointFilter)
+*/
+struct JointFilterParams {
+
+	// the cutoff frequency at rest, in Hz. Lower values remove more jitter, but add more lag
+	float minCutoff;
+
+	// how fast the cutoff frequency grows with the speed of the joint, in Hz per mm/s.
+	// Higher values reduce the lag of the fast movements
+	float beta;
+};
+
+/**
+	Smooths the skeleton joints of all the users with the One Euro filter (Casiez et al., 2012):
+	a low-pass filter, whose cutoff frequency follows the speed of the joint, so the joints
+	held still stop jittering, while the fast movements are not delayed.
+
+	The filter works in place on the JointSnapshot, once per frame, before the features are extracted.
+	Like the other batch kernels (see AngleKernels.h), it runs over the joint-major arrays of all
+	the users at once, with the per-user conditions done as selects, so the loops can be vectorized
+	by the compiler. Every joint has its own tuning (see setParams()).
+
+	A user is filtered from the second frame he is tracked in; the first frame initializes the filter.
+*/
+class JointFilter {
+
+public:
+	/**
+		Create the filter with the default tuning: the torso and the head are smoothed the most,
+		the hands the least
+
+		@param capacity The maximum number of users (the capacity of the snapshot)
+	*/
+	JointFilter(const int capacity = 0);
+
+	/**
+		Set the tuning of a joint
+
+		@param type The joint
+		@param params The tuning
+	*/
+	void setParams(const nite::JointType type, const JointFilterParams& params);
+
+	/**
+		Get the tuning of a joint
+	*/
+	JointFilterParams getParams(const nite::JointType type) const;
+
+	/**
+		Filter the joints of all the valid users in the snapshot
+
+		@param snapshot The joints of the current frame. Filtered in place.
+		@param timestamp The timestamp of the frame, in microseconds
+	*/
+	void apply(JointSnapshot& snapshot, const unsigned long long timestamp);
+
+	/**
+		Forget the history of all the users
+	*/
+	void reset();
+
+private:
+	// maximum number of users
+	int capacity;
+
+	// the tuning of every joint
+	JointFilterParams params[NUM_JOINTS];
+
+	// the filtered positions and the filtered speeds of the previous frame, in the same layout as the snapshot
+	std::vector<float> previousX, previousY, previousZ;
+	std::vector<float> speedX, speedY, speedZ;
+
+	// 1 for the users, that were already filtered in the previous frame, otherwise 0
+	std::vector<float> active;
+
+	// the timestamp of the previous frame
+	unsigned long long previousTimestamp = 0;
+};
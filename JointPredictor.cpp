@@ -0,0 +1,89 @@
+#include "JointPredictor.h"
+
+#include <algorithm>
+
+JointPredictor::JointPredictor(const int capacity) {
+	this->capacity = capacity;
+
+	previousX = previousY = std::vector<float>(NUM_JOINTS * capacity, 0.f);
+	velocityX = velocityY = std::vector<float>(NUM_JOINTS * capacity, 0.f);
+	active = std::vector<float>(capacity, 0.f);
+}
+
+void JointPredictor::update(const JointSnapshot& snapshot, const unsigned long long timestamp) {
+
+	if (snapshot.getCapacity() != capacity)
+		return;
+
+	float dt = (timestamp > previousTimestamp) ? (timestamp - previousTimestamp) / 1e6f : 0.f;
+	previousTimestamp = timestamp;
+
+	// after a gap (or at the start) every user starts again
+	bool restart = (dt <= 0 || dt > PREDICTION_MAX_GAP);
+
+	for (int slot = 0; slot < capacity; slot++) {
+		active[slot] = (!restart && active[slot] > 0 && snapshot.isValid(slot)) ? 1.f : 0.f;
+	}
+
+	const float invDt = restart ? 0.f : 1.f / dt;
+	const float a = PREDICTION_VELOCITY_SMOOTHING;
+
+	const float* x = snapshot.getAllDepthX();
+	const float* y = snapshot.getAllDepthY();
+
+	for (int j = 0; j < NUM_JOINTS; j++) {
+		const int begin = j * capacity;
+
+		for (int slot = 0; slot < capacity; slot++) {
+			const int i = begin + slot;
+			const float keep = active[slot];
+
+			float vx = velocityX[i] + a * ((x[i] - previousX[i]) * invDt - velocityX[i]);
+			float vy = velocityY[i] + a * ((y[i] - previousY[i]) * invDt - velocityY[i]);
+
+			// a new user doesn't move yet
+			velocityX[i] = keep * vx;
+			velocityY[i] = keep * vy;
+
+			previousX[i] = x[i];
+			previousY[i] = y[i];
+		}
+	}
+
+	// the users of this frame have a velocity from the next one on
+	for (int slot = 0; slot < capacity; slot++) {
+		active[slot] = snapshot.isValid(slot) ? 1.f : 0.f;
+	}
+}
+
+void JointPredictor::predict(JointSnapshot& snapshot, const float horizon) const {
+
+	if (snapshot.getCapacity() != capacity)
+		return;
+
+	const float h = (std::max)(0.f, (std::min)(horizon, PREDICTION_MAX_HORIZON));
+	const int count = NUM_JOINTS * capacity;
+
+	const float* x = snapshot.getAllDepthX();
+	const float* y = snapshot.getAllDepthY();
+
+	float* displayX = snapshot.getAllDisplayX();
+	float* displayY = snapshot.getAllDisplayY();
+
+	for (int i = 0; i < count; i++) {
+		displayX[i] = x[i] + velocityX[i] * h;
+		displayY[i] = y[i] + velocityY[i] * h;
+	}
+}
+
+cv::Point2f JointPredictor::getVelocity(const int slot, const nite::JointType type) const {
+	int i = (int)type * capacity + slot;
+	return cv::Point2f(velocityX[i], velocityY[i]);
+}
+
+void JointPredictor::reset() {
+	std::fill(active.begin(), active.end(), 0.f);
+	std::fill(velocityX.begin(), velocityX.end(), 0.f);
+	std::fill(velocityY.begin(), velocityY.end(), 0.f);
+	previousTimestamp = 0;
+}
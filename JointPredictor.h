@@ -0,0 +1,72 @@
+#pragma once
+
+#include "JointSnapshot.h"
+
+#define PREDICTION_VELOCITY_SMOOTHING 0.5f   // the weight of the newest velocity in the estimate (0..1)
+#define PREDICTION_MAX_HORIZON 0.2f          // the longest prediction, in seconds
+#define PREDICTION_MAX_GAP 0.5f              // the longest gap between two frames, in seconds; after a longer one the velocities restart
+
+/**
+	Predicts where the joints of all the users will be, at the moment the output frame is shown.
+
+	The skeletons and the instruments are drawn from the joints of the last tracked frame, which are
+	already several frames old when the frame reaches the screen, so the overlays lag behind the fast
+	moving hands. The predictor keeps the velocity of every joint of every user on the depth image
+	(in pixels per second, smoothed over the frames), and moves the drawn joints along it by the expected
+	latency (see JointSnapshot::getDisplayPosition()).
+
+	Like the JointFilter, it runs over the joint-major arrays of all the users at once.
+*/
+class JointPredictor {
+
+public:
+	/**
+		Create the predictor
+
+		@param capacity The maximum number of users (the capacity of the snapshot)
+	*/
+	JointPredictor(const int capacity = 0);
+
+	/**
+		Update the velocities from the projected joints of the new frame (see DepthProjection::projectAll())
+
+		@param snapshot The joints of the current frame
+		@param timestamp The timestamp of the frame, in microseconds
+	*/
+	void update(const JointSnapshot& snapshot, const unsigned long long timestamp);
+
+	/**
+		Move the display positions of the joints along their velocities (see JointSnapshot::getDisplayPosition())
+
+		@param snapshot The joints of the current frame, already projected
+		@param horizon How far to predict, in seconds. Limited to PREDICTION_MAX_HORIZON.
+	*/
+	void predict(JointSnapshot& snapshot, const float horizon) const;
+
+	/**
+		Get the velocity of the joint on the depth image, in pixels per second
+
+		@param slot The slot of the user
+		@param type The joint
+	*/
+	cv::Point2f getVelocity(const int slot, const nite::JointType type) const;
+
+	/**
+		Forget the velocities of all the users
+	*/
+	void reset();
+
+private:
+	// maximum number of users
+	int capacity;
+
+	// the projected positions of the previous frame, and the velocities, in the same layout as the snapshot
+	std::vector<float> previousX, previousY;
+	std::vector<float> velocityX, velocityY;
+
+	// 1 for the users, that were already tracked in the previous frame, otherwise 0
+	std::vector<float> active;
+
+	// the timestamp of the previous frame
+	unsigned long long previousTimestamp = 0;
+};
@@ -0,0 +1,124 @@
+#include "JointSnapshot.h"
+
+JointSnapshot::JointSnapshot(const int capacity) {
+	this->capacity = capacity;
+
+	x = std::vector<float>(NUM_JOINTS * capacity, 0.f);
+	y = std::vector<float>(NUM_JOINTS * capacity, 0.f);
+	z = std::vector<float>(NUM_JOINTS * capacity, 0.f);
+	depthX = std::vector<float>(NUM_JOINTS * capacity, 0.f);
+	depthY = std::vector<float>(NUM_JOINTS * capacity, 0.f);
+	displayX = std::vector<float>(NUM_JOINTS * capacity, 0.f);
+	displayY = std::vector<float>(NUM_JOINTS * capacity, 0.f);
+	confidence = std::vector<float>(NUM_JOINTS * capacity, 0.f);
+	valid = std::vector<unsigned char>(capacity, 0);
+}
+
+int JointSnapshot::getCapacity() const {
+	return this->capacity;
+}
+
+void JointSnapshot::capture(const int slot, const cv::Point3f* positions, const float* confidences) {
+
+	if (slot < 0 || slot >= capacity)
+		return;
+
+	for (int j = 0; j < NUM_JOINTS; j++) {
+		int i = offset(slot, (nite::JointType) j);
+
+		x[i] = positions[j].x;
+		y[i] = positions[j].y;
+		z[i] = positions[j].z;
+		confidence[i] = confidences[j];
+	}
+
+	valid[slot] = 1;
+}
+
+void JointSnapshot::setJoint(const int slot, const nite::JointType type, const cv::Point3f& position, const float confidence) {
+
+	if (slot < 0 || slot >= capacity)
+		return;
+
+	int i = offset(slot, type);
+
+	this->x[i] = position.x;
+	this->y[i] = position.y;
+	this->z[i] = position.z;
+	this->confidence[i] = confidence;
+
+	valid[slot] = 1;
+}
+
+void JointSnapshot::clear(const int slot) {
+
+	if (slot < 0 || slot >= capacity)
+		return;
+
+	for (int j = 0; j < NUM_JOINTS; j++) {
+		confidence[offset(slot, (nite::JointType) j)] = 0;
+	}
+
+	valid[slot] = 0;
+}
+
+bool JointSnapshot::isValid(const int slot) const {
+	return slot >= 0 && slot < capacity && valid[slot] != 0;
+}
+
+cv::Point3f JointSnapshot::getPosition(const int slot, const nite::JointType type) const {
+	int i = offset(slot, type);
+	return cv::Point3f(x[i], y[i], z[i]);
+}
+
+cv::Point2f JointSnapshot::getDepthPosition(const int slot, const nite::JointType type) const {
+	int i = offset(slot, type);
+	return cv::Point2f(depthX[i], depthY[i]);
+}
+
+cv::Point2f JointSnapshot::getDisplayPosition(const int slot, const nite::JointType type) const {
+	int i = offset(slot, type);
+	return cv::Point2f(displayX[i], displayY[i]);
+}
+
+float JointSnapshot::getConfidence(const int slot, const nite::JointType type) const {
+	return confidence[offset(slot, type)];
+}
+
+float JointSnapshot::getMinConfidence(const int slot, const nite::JointType first, const nite::JointType last) const {
+	float result = 1;
+
+	for (int j = (int)first; j <= (int)last; j++) {
+		result = (std::min)(result, confidence[offset(slot, (nite::JointType) j)]);
+	}
+
+	return result;
+}
+
+const float* JointSnapshot::getX(const nite::JointType type) const {
+	return &x[(int)type * capacity];
+}
+
+const float* JointSnapshot::getY(const nite::JointType type) const {
+	return &y[(int)type * capacity];
+}
+
+const float* JointSnapshot::getZ(const nite::JointType type) const {
+	return &z[(int)type * capacity];
+}
+
+const float* JointSnapshot::getConfidence(const nite::JointType type) const {
+	return &confidence[(int)type * capacity];
+}
+
+float* JointSnapshot::getX(const nite::JointType type) {
+	return &x[(int)type * capacity];
+}
+
+float* JointSnapshot::getY(const nite::JointType type) {
+	return &y[(int)type * capacity];
+}
+
+float* JointSnapshot::getZ(const nite::JointType type) {
+	return &z[(int)type * capacity];
+}
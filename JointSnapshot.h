@@ -0,0 +1,168 @@
+#pragma once
+
+#include "opencv2/core/core.hpp"
+
+#include <NiTE.h>
+
+#include <vector>
+
+#define NUM_JOINTS 15         // number of skeleton joints, provided by NiTE (JOINT_HEAD .. JOINT_RIGHT_FOOT)
+
+/**
+	The per-frame snapshot of the skeleton joints of all the tracked users.
+
+	The joints of every user are captured from NiTE exactly once per frame, and everything
+	else (feature extraction, confidence checks, drawing) reads them from here.
+
+	The data is stored in the SoA (structure of arrays) layout: there is a separate float array
+	for every coordinate and for the confidence, and the arrays are ordered joint-major, i.e.
+	the values of one joint for all the users lie next to each other:
+
+	x[ joint * capacity + slot ]
+
+	This way a batch operation over all the users (like projection or angle calculation)
+	is just a loop over a contiguous range of floats.
+*/
+class JointSnapshot {
+
+public:
+	/**
+		Create a new snapshot
+
+		@param capacity The maximum number of users (slots) in the snapshot
+	*/
+	JointSnapshot(const int capacity = 0);
+
+	/**
+		Get the maximum number of users in the snapshot
+	*/
+	int getCapacity() const;
+
+	/**
+		Copy all the joints of the skeleton into the specified slot
+
+		@param slot The slot of the user (normally the NiTE user id)
+		@param positions The real world positions of all NUM_JOINTS joints, in milimeters
+		@param confidences The confidences of all NUM_JOINTS joints (0..1)
+	*/
+	void capture(const int slot, const cv::Point3f* positions, const float* confidences);
+
+	/**
+		Set a single joint of the specified user
+
+		@param slot The slot of the user
+		@param type The joint
+		@param position The real world position of the joint, in milimeters
+		@param confidence The confidence of the joint position (0..1)
+	*/
+	void setJoint(const int slot, const nite::JointType type, const cv::Point3f& position, const float confidence);
+
+	/**
+		Mark the slot as empty (the user is no longer tracked)
+	*/
+	void clear(const int slot);
+
+	/**
+		Check if the slot contains the joints for the current frame
+	*/
+	bool isValid(const int slot) const;
+
+	/**
+		Get the real world position of the joint in milimeters
+
+		@param slot The slot of the user
+		@param type The joint
+	*/
+	cv::Point3f getPosition(const int slot, const nite::JointType type) const;
+
+	/**
+		Get the confidence of the joint position (0..1)
+
+		@param slot The slot of the user
+		@param type The joint
+	*/
+	float getConfidence(const int slot, const nite::JointType type) const;
+
+	/**
+		Get the position of the joint, projected on the depth image (in pixels).
+		Valid only after the snapshot was projected with DepthProjection::projectAll()
+
+		@param slot The slot of the user
+		@param type The joint
+	*/
+	cv::Point2f getDepthPosition(const int slot, const nite::JointType type) const;
+
+	/**
+		Get the position of the joint, where it's drawn on the output frame (in pixels): the projected
+		position, or the position predicted to the moment the frame is shown (see JointPredictor)
+
+		@param slot The slot of the user
+		@param type The joint
+	*/
+	cv::Point2f getDisplayPosition(const int slot, const nite::JointType type) const;
+
+	/**
+		Get the lowest confidence among the range of joints of the user
+
+		@param slot The slot of the user
+		@param first The first joint in the range
+		@param last The last joint in the range (inclusive)
+	*/
+	float getMinConfidence(const int slot, const nite::JointType first, const nite::JointType last) const;
+
+	/**
+		Direct access to the arrays of all the users for the specified joint.
+		Each array contains getCapacity() values.
+	*/
+	const float* getX(const nite::JointType type) const;
+	const float* getY(const nite::JointType type) const;
+	const float* getZ(const nite::JointType type) const;
+	const float* getConfidence(const nite::JointType type) const;
+
+	float* getX(const nite::JointType type);
+	float* getY(const nite::JointType type);
+	float* getZ(const nite::JointType type);
+
+	/**
+		Direct access to the real world and the projected coordinates of all the joints of all the users.
+		Each array contains NUM_JOINTS * getCapacity() values, in the same order as the real world coordinates.
+	*/
+	const float* getAllX() const { return x.data(); }
+	const float* getAllY() const { return y.data(); }
+	const float* getAllZ() const { return z.data(); }
+	float* getAllX() { return x.data(); }
+	float* getAllY() { return y.data(); }
+	float* getAllZ() { return z.data(); }
+	float* getAllDepthX() { return depthX.data(); }
+	float* getAllDepthY() { return depthY.data(); }
+	const float* getAllDepthX() const { return depthX.data(); }
+	const float* getAllDepthY() const { return depthY.data(); }
+	float* getAllDisplayX() { return displayX.data(); }
+	float* getAllDisplayY() { return displayY.data(); }
+
+private:
+	// maximum number of users
+	int capacity;
+
+	// joint coordinates, in milimeters
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+
+	// joint coordinates, projected on the depth image, in pixels
+	std::vector<float> depthX;
+	std::vector<float> depthY;
+
+	// joint coordinates on the output frame, in pixels (see getDisplayPosition())
+	std::vector<float> displayX;
+	std::vector<float> displayY;
+
+	// joint position confidences
+	std::vector<float> confidence;
+
+	// does the slot hold a captured skeleton?
+	std::vector<unsigned char> valid;
+
+	// the index of the joint value in the arrays
+	int offset(const int slot, const nite::JointType type) const { return (int)type * capacity + slot; }
+};
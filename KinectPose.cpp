@@ -1,14 +1,14 @@
 #include "KinectPose.h"
 
+#include <limits>
+
 KinectPose::KinectPose() {
 	this->poseIndex = 0;
-	featureVector = std::vector<FeatureString>(6);
 	poseName = "None";
 }
 
 KinectPose::KinectPose(const int index) {
 	this->poseIndex = index;
-	featureVector = std::vector<FeatureString>(6);
 	poseName = "None";
 }
 
@@ -21,6 +21,8 @@ KinectPose::KinectPose(const int index, const std::string & poseName, const std:
 	this->poseIndex = index;
 	this->poseName = poseName;
 	this->featureVector = featureVector;
+
+	prepareSamples();
 }
 
 void KinectPose::parsePoseDataFile(const std::string & fileName) {
@@ -28,6 +30,7 @@ void KinectPose::parsePoseDataFile(const std::string & fileName) {
 	this->fileName = fileName;
 
 	this->featureVector.clear();
+	this->embeddedSamples.clear();
 
 	std::ifstream ifs(fileName, std::ios::in);
 
@@ -50,17 +53,17 @@ void KinectPose::parsePoseDataFile(const std::string & fileName) {
 		this->referenceEstimate = std::stod(line);
 	}
 
-	int i = 0;
-
-	// now get the actual features
+	// now get the actual features. Every line of the file is one slot of the feature vector,
+	// and every column is one training sample
 
-	while (std::getline(ifs, line)) {
-		FeatureString featureString;
-		featureString.clear();
+	int slot = 0;
 
+	while (std::getline(ifs, line) && slot < FeatureSchema::size) {
 		std::stringstream sstream(line);
 		std::string substr;
 
+		int sample = 0;
+
 		// read the next cv::Point2f value
 
 		while (std::getline(sstream, substr, ';')) {
@@ -77,19 +80,28 @@ void KinectPose::parsePoseDataFile(const std::string & fileName) {
 			std::getline(ss2stream, val);
 			b = std::stof(val);
 
-			featureString.push_back(cv::Point2f(a, b));
+			if (sample >= this->featureVector.size())
+				this->featureVector.push_back(FeatureString());
+
+			this->featureVector[sample][slot] = cv::Point2f(a, b);
+			this->featureVector[sample].valid = true;
+
+			sample++;
 		}
-		this->featureVector.push_back(featureString);
+
+		slot++;
 	}
 
 	ifs.close();
+
+	prepareSamples();
 }
 
 std::vector<FeatureString> KinectPose::getFeatureVector() {
 	return this->featureVector;
 }
 
-std::string KinectPose::getPoseName() {
+std::string KinectPose::getPoseName() const {
 	return this->poseName;
 }
 
@@ -101,16 +113,16 @@ std::vector<double> KinectPose::getReferenceVector() {
 	return this->referenceVector;
 }
 
-double KinectPose::getReferenceEstimate() {
-	if (referenceEstimate <= 0) { 
-		double result = 0;
+double KinectPose::getReferenceEstimate() const {
+	if (referenceEstimate > 0)
+		return referenceEstimate;
 
-		std::for_each(std::begin(referenceVector), std::end(referenceVector), [&result](double& x) { result += std::pow(x, 2); });
+	// not in the file: calculate from the reference vector. Not cached, so the pose can be shared between threads
+	double result = 0;
 
-		referenceEstimate = std::sqrt(result);
-	}
+	std::for_each(std::begin(referenceVector), std::end(referenceVector), [&result](const double& x) { result += std::pow(x, 2); });
 
-	return referenceEstimate;
+	return std::sqrt(result);
 }
 
 std::string KinectPose::getFileName() {
@@ -121,86 +133,400 @@ void KinectPose::setFileName(const std::string & fileName) {
 	this->fileName = fileName;
 }
 
-int KinectPose::getPoseIndex() {
+int KinectPose::getPoseIndex() const {
 	return this->poseIndex;
 }
 
-std::vector<double> KinectPose::estimateLikelihood(const FeatureString & featureString) {
-	if (this->featureVector.size() == 0)
-		return std::vector<double>();
+std::vector<double> KinectPose::estimateLikelihood(const FeatureString & featureString) const {
+	return estimateLikelihood(embedFeatures(featureString));
+}
+
+std::vector<double> KinectPose::estimateLikelihood(const EmbeddedFeature & embedded) const {
 
 	std::vector<double> results;	
+	results.reserve(embeddedSamples.size());
+
+	for (const EmbeddedFeature& sample : embeddedSamples) {
+		results.push_back(EmbeddedMetric::distance(embedded, sample));
+	}
 
-	for (int j = 0; j < featureVector[0].size(); j++) {
-		std::vector<double> estimateVector;
+	return results;
+	
+}
 
-		// Calculate difference between the angles
-		for (int i = 0; i < 2; i++) {
+/**
+	The lower bound of the distance from the test sample to any sample inside the bounding sphere
+*/
+static double cascadeLowerBound(const EmbeddedFeature& embedded, const CascadeBound& bound) {
+	double result = 0;
 
-			double estimateX = 0;
-			double estimateY = 0;
+	for (int i = 0; i < CASCADE_DIMS; i++) {
+		double d = embedded.values[i] - bound.centroid[i];
+		result += d * d;
+	}
 
-			cv::Point2f angles = featureVector[i][j];
+	return std::sqrt(result) - bound.radius;
+}
 
-			// if it's an elbow angle
-			if (i == 0) {
-				estimateX = std::abs(angles.x - featureString[i].x);
-				estimateY = std::abs(angles.y - featureString[i].y);
-			}
-			else {	// if it's a direction angle
-				estimateX = angleDifference(angles.x, featureString[i].x);
-				estimateY = angleDifference(angles.y, featureString[i].y);
-			}
+template <class Metric>
+void KinectPose::findSimilarSamples(const EmbeddedFeature& embedded, const double threshold, std::vector<EstimationResult>& results) const {
 
-			estimateVector.push_back(estimateX);
-			estimateVector.push_back(estimateY);
+	if (embeddedSamples.size() == 0)
+		return;
+
+	double limit = threshold * (1 + CASCADE_BOUND_SLACK);
+
+	// the whole pose is too far
+	if (cascadeLowerBound(embedded, poseBound) > limit)
+		return;
+
+	for (const SampleBlock& block : sampleBlocks) {
+
+		// the whole block is too far
+		if (cascadeLowerBound(embedded, block.bound) > limit)
+			continue;
+
+		// the full metric, exactly as in estimateLikelihood()
+		for (int i = block.begin; i < block.end; i++) {
+			double distance = Metric::distance(embedded, embeddedSamples[i]);
+
+			if (distance <= threshold)
+				results.push_back(EstimationResult(poseIndex, distance));
 		}
+	}
+}
+
+// the metrics of the feature profiles (see ProfilePolicies)
+template void KinectPose::findSimilarSamples<EmbeddedMetric>(const EmbeddedFeature& embedded, const double threshold, std::vector<EstimationResult>& results) const;
+
+void KinectPose::buildCascade() {
 
-		// for the points (elbows and hands)
-		for (int i = 2; i < featureVector.size(); i++) {
-			double estimate = 0;
-			
-			estimate = calcDistance(featureString[i], featureVector[i][j]);			
-			
-			estimateVector.push_back(estimate);
+	int count = (int)embeddedSamples.size();
+
+	poseBound = calculateBound(0, count);
+
+	sampleBlocks.clear();
+
+	for (int begin = 0; begin < count; begin += CASCADE_BLOCK_SIZE) {
+		SampleBlock block;
+		block.begin = begin;
+		block.end = (std::min)(begin + CASCADE_BLOCK_SIZE, count);
+		block.bound = calculateBound(block.begin, block.end);
+
+		sampleBlocks.push_back(block);
+	}
+}
+
+void KinectPose::updateCascade(const int sample) {
+
+	int count = (int)embeddedSamples.size();
+
+	// the first sample
+	if (count == 1 || sampleBlocks.empty()) {
+		buildCascade();
+		return;
+	}
+
+	int blockIndex = sample / CASCADE_BLOCK_SIZE;
+
+	// a new block for the appended sample
+	if (blockIndex >= (int)sampleBlocks.size()) {
+		SampleBlock block;
+		block.begin = blockIndex * CASCADE_BLOCK_SIZE;
+		block.end = block.begin;
+
+		sampleBlocks.push_back(block);
+	}
+
+	SampleBlock& block = sampleBlocks[blockIndex];
+	block.end = (std::min)(block.begin + CASCADE_BLOCK_SIZE, count);
+	block.bound = calculateBound(block.begin, block.end);
+
+	// the bound of the pose only grows, so it stays valid without looking at the other samples
+	double result = 0;
+
+	for (int i = 0; i < CASCADE_DIMS; i++) {
+		double d = embeddedSamples[sample].values[i] - poseBound.centroid[i];
+		result += d * d;
+	}
+
+	poseBound.radius = (std::max)(poseBound.radius, std::sqrt(result));
+}
+
+CascadeBound KinectPose::calculateBound(const int begin, const int end) const {
+
+	CascadeBound bound;
+	std::fill(std::begin(bound.centroid), std::end(bound.centroid), 0.0);
+	bound.radius = 0;
+
+	if (end <= begin)
+		return bound;
+
+	for (int s = begin; s < end; s++) {
+		for (int i = 0; i < CASCADE_DIMS; i++) {
+			bound.centroid[i] += embeddedSamples[s].values[i];
 		}
+	}
 
+	for (int i = 0; i < CASCADE_DIMS; i++) {
+		bound.centroid[i] /= (end - begin);
+	}
 
-		// calculate the square root of the sum of every value to the power of 2:
-		// Result = sqrt( a^2 + b^2 + c^2 + ... )
+	for (int s = begin; s < end; s++) {
 		double result = 0;
 
-		for (double x : estimateVector) { 
-			result += std::pow(x, 2);
+		for (int i = 0; i < CASCADE_DIMS; i++) {
+			double d = embeddedSamples[s].values[i] - bound.centroid[i];
+			result += d * d;
 		}
-		result = std::sqrt(result);
 
-		results.push_back(result);
+		bound.radius = (std::max)(bound.radius, std::sqrt(result));
+	}
+
+	return bound;
+}
+
+const std::vector<EmbeddedFeature>& KinectPose::getEmbeddedSamples() const {
+	return this->embeddedSamples;
+}
+
+void KinectPose::calibrateThreshold(const bool enabled) {
+
+	thresholdScale = 1.0;
+
+	if (!enabled)
+		return;
+
+	std::vector<double> ratios;
 
+	for (int i = 0; i < featureVector.size(); i++) {
+		for (int j = i + 1; j < featureVector.size(); j++) {
+			double legacy = LegacyMetric::distance(featureVector[i], featureVector[j]);
+
+			if (legacy > 0)
+				ratios.push_back(EmbeddedMetric::distance(embeddedSamples[i], embeddedSamples[j]) / legacy);
+		}
 	}
 
-	return results;
-	
+	if (ratios.size() > 0) {
+		std::nth_element(std::begin(ratios), std::begin(ratios) + ratios.size() / 2, std::end(ratios));
+		thresholdScale = ratios[ratios.size() / 2];
+	}
+}
+
+double KinectPose::getDistanceThreshold() const {
+	return getReferenceEstimate() * thresholdScale;
+}
+
+bool KinectPose::addNewTrainingSample(const FeatureString & featureString) {
+
+	if (featureString.isEmpty())
+		return false;
+
+	EmbeddedFeature embedded = embedFeatures(featureString);
+
+	int count = (int)embeddedSamples.size();
+
+	offeredSamples = (std::max)(offeredSamples, (unsigned long long)count) + 1;
+
+	// the place of the new sample: the end, while there's space
+	int sample = count;
+
+	if (count >= capacity) {
+		if (eviction == EVICT_RESERVOIR) {
+			// keep the new sample with the probability capacity / offeredSamples, in place of a random one
+			unsigned long long slot = std::uniform_int_distribution<unsigned long long>(0, offeredSamples - 1)(random);
+
+			if (slot >= (unsigned long long)count)
+				return false;
+
+			sample = (int)slot;
+		}
+		else {
+			sample = -1;
+		}
+	}
+
+	std::vector<double> distances(count);
+
+	for (int i = 0; i < count; i++) {
+		distances[i] = EmbeddedMetric::distance(embedded, embeddedSamples[i]);
+	}
+
+	// the most redundant sample, with the new sample included: the one closest to its nearest neighbour
+	if (sample < 0) {
+		double nearest = std::numeric_limits<double>::max();
+
+		for (int i = 0; i < count; i++) {
+			double distance = (std::min)(neighbourDistances[i], distances[i]);
+
+			if (distance < nearest) {
+				nearest = distance;
+				sample = i;
+			}
+		}
+	}
+
+	placeSample(sample, featureString, embedded, distances);
+
+	saveSamples();
+
+	return true;
 }
 
-void KinectPose::addNewTrainingSample(const FeatureString & featureString) {
+void KinectPose::placeSample(const int sample, const FeatureString& featureString, const EmbeddedFeature& embedded, const std::vector<double>& distances) {
+
+	int count = (int)embeddedSamples.size();
 
-	if (this->featureVector.size() == 0) { 
-		this->featureVector = std::vector<FeatureString>(featureString.size());
+	if (sample == count) {
+		featureVector.push_back(featureString);
+		embeddedSamples.push_back(embedded);
+		neighbours.push_back(-1);
+		neighbourDistances.push_back(std::numeric_limits<double>::max());
+	}
+	else {
+		featureVector[sample] = featureString;
+		embeddedSamples[sample] = embedded;
 	}
 
-	for (int i = 0; i < featureString.size(); i++) {
-		this->featureVector[i].push_back(featureString[i]);
+	// the new sample is the nearest neighbour of the samples, that are closer to it than to their neighbour.
+	// The samples, whose neighbour was replaced, have to look again
+	neighbours[sample] = -1;
+	neighbourDistances[sample] = std::numeric_limits<double>::max();
+
+	for (int i = 0; i < count; i++) {
+		if (i == sample)
+			continue;
+
+		if (distances[i] < neighbourDistances[sample]) {
+			neighbours[sample] = i;
+			neighbourDistances[sample] = distances[i];
+		}
+
+		if (neighbours[i] == sample && sample < count)
+			findNeighbour(i);
+		else if (distances[i] < neighbourDistances[i]) {
+			neighbours[i] = sample;
+			neighbourDistances[i] = distances[i];
+		}
+	}
+
+	updateCascade(sample);
+}
+
+void KinectPose::setCapacity(const int capacity, const SampleEviction eviction) {
+	this->capacity = (std::max)(1, capacity);
+	this->eviction = eviction;
+
+	enforceCapacity();
+}
+
+int KinectPose::getCapacity() const {
+	return this->capacity;
+}
+
+int KinectPose::getSampleCount() const {
+	return (int)this->embeddedSamples.size();
+}
+
+void KinectPose::prepareSamples() {
+
+	// embed all the samples once, so they don't need to be converted on every comparison
+	embeddedSamples.clear();
+
+	for (const FeatureString& sample : featureVector) {
+		embeddedSamples.push_back(embedFeatures(sample));
 	}
 
+	offeredSamples = featureVector.size();
+
+	findNeighbours();
+	buildCascade();
+}
+
+void KinectPose::findNeighbours() {
+
+	int count = (int)embeddedSamples.size();
+
+	neighbours.assign(count, -1);
+	neighbourDistances.assign(count, std::numeric_limits<double>::max());
+
+	for (int i = 0; i < count; i++) {
+		for (int j = i + 1; j < count; j++) {
+			double distance = EmbeddedMetric::distance(embeddedSamples[i], embeddedSamples[j]);
+
+			if (distance < neighbourDistances[i]) {
+				neighbours[i] = j;
+				neighbourDistances[i] = distance;
+			}
+
+			if (distance < neighbourDistances[j]) {
+				neighbours[j] = i;
+				neighbourDistances[j] = distance;
+			}
+		}
+	}
+}
+
+void KinectPose::findNeighbour(const int sample) {
+
+	neighbours[sample] = -1;
+	neighbourDistances[sample] = std::numeric_limits<double>::max();
+
+	for (int i = 0; i < (int)embeddedSamples.size(); i++) {
+		if (i == sample)
+			continue;
+
+		double distance = EmbeddedMetric::distance(embeddedSamples[sample], embeddedSamples[i]);
+
+		if (distance < neighbourDistances[sample]) {
+			neighbours[sample] = i;
+			neighbourDistances[sample] = distance;
+		}
+	}
+}
+
+void KinectPose::enforceCapacity() {
+
+	if ((int)embeddedSamples.size() <= capacity)
+		return;
+
+	while ((int)embeddedSamples.size() > capacity) {
+
+		int sample = 0;
+
+		if (eviction == EVICT_RESERVOIR)
+			sample = std::uniform_int_distribution<int>(0, (int)embeddedSamples.size() - 1)(random);
+		else
+			sample = (int)std::distance(std::begin(neighbourDistances), std::min_element(std::begin(neighbourDistances), std::end(neighbourDistances)));
+
+		featureVector.erase(featureVector.begin() + sample);
+		embeddedSamples.erase(embeddedSamples.begin() + sample);
+		neighbours.erase(neighbours.begin() + sample);
+		neighbourDistances.erase(neighbourDistances.begin() + sample);
+
+		// the samples after the removed one have moved, and its neighbours have to look again
+		for (int i = 0; i < (int)neighbours.size(); i++) {
+			if (neighbours[i] == sample)
+				findNeighbour(i);
+			else if (neighbours[i] > sample)
+				neighbours[i]--;
+		}
+	}
+
+	buildCascade();
+}
+
+void KinectPose::saveSamples() const {
+
 	std::ofstream ofs(this->fileName, std::ios::out);
 	{ 
 		ofs << poseName << std::endl;
 		ofs << getReferenceEstimate() << std::endl;
 
-		for (int i = 0; i < featureVector.size(); i++) {
-			for (int j = 0; j < featureVector[i].size(); j++) {
-				ofs << featureVector[i][j].x << "," << featureVector[i][j].y << ";";
+		for (int i = 0; i < FeatureSchema::size; i++) {
+			for (const FeatureString& sample : featureVector) {
+				ofs << sample[i].x << "," << sample[i].y << ";";
 			}
 			ofs << std::endl;
 		}
@@ -212,24 +538,5 @@ void KinectPose::addNewTrainingSample(const FeatureString & featureString) {
 KinectPose::~KinectPose() {
 	poseName.clear();
 	featureVector.clear();
+	embeddedSamples.clear();
 }
-
-double KinectPose::angleDifference(const double alpha, const double beta) {
-	if (isInRange(alpha, 270, 360) && isInRange(beta, 0, 90)) {
-		return (360 - alpha) + beta;
-	}
-	else if (isInRange(beta, 270, 360) && isInRange(alpha, 0, 90)) {
-		return (360 - beta) + alpha;
-	}
-	else {
-		return std::abs(alpha - beta);
-	}
-}
-
-// check if the a value lies between two constrains
-bool KinectPose::isInRange(const double value, const double A, const double B) {
-	if (value >= fmin(A, B) && value <= fmax(A, B))
-		return true;
-	else
-		return false;
-}
\ No newline at end of file
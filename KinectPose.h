@@ -2,60 +2,11 @@
 
 #include "opencv2/highgui/highgui.hpp"
 #include <fstream>
+#include <random>
 #include <iostream>
 
 #include "Utils.h"
-
-/**
-	The vector of features, extracted from the current user in one frame.
-	The featues are the following 
-
-	Name:                    Type:           Description
-	Hand_Elbow_Angles        cv::Point2f     The angles between the upper arm and lower arm
-                                           for each hand (the elbow-angles) in Radians. Both
-                                           hands are recorded in a single cv::Point2f object,
-                                           with X being the left hand, and Y being the right hand
-                                           cv::Point2f::x = left_elbow_angle
-                                           cv::Point2f::y - right_hand_angle
-	
-	Hand_Direction_Angles    cv::Point2f     The angle between the position of the user's center of mass
-                                           and the positions of the left and right hands (wrists).
-                                           The "center of mass" in this case is the head position,
-                                           but it could also be the center of the torso.
-                                           The angles are given in the Descartes (Cartesian) coordinate system:
-                                                                  270
-                                                                   |
-                                                            180----0----360/0
-                                                                   |
-                                                                   90
-                                           Like in the previous case, the angles are stored in one
-                                           cv::Point2f object, with X and Y being left and right hands
-                                           respectively.
-
-	Left_Elbow_Position      cv::Point2f     The position of the user's left elbow relative to the center of mass
-
-	Left_Hand_Position       cv::Point2f     The position of the user's left wrist relative to the center of mass
-
-	Right_Elbow_Position     cv::Point2f     The position of the user's right elbow relative to the center of mass
-
-	Right_Hand_Position      cv::Point2f     The position of the user's right wrist relative to the center of mass
-
-	In the latter four cases the positions of the wrists and elbows are calculated relative to the center of mass 
-	(int this particular case - position of the head). Because positions are relative, the left hand will be a negative
-	value, and the right hand will be in most cases a positive value.
-	Note, that the positions are not only relative, but also scale invariant, as the X coordinates are divided by the 
-	distance between uses's shoulders and the Y is divided by the height of the uses's torso.
-
-	Thus, the feature vector in this case looks like this:
-	FeatureString[0] = cv::Point2f(left_elbow_angle, right_elbow_angle)
-	FeatureString[1] = cv::Point2f(left_hand_angle,  right_hand_angle)
-	FeatureString[2] = cv::Point2f(left_elbow.x, left_elbow.y)
-	FeatureString[3] = cv::Point2f(left_hand.x,  left_hand.y
-	FeatureString[4] = cv::Point2f(right_elbow.x, right_elbow.y)
-	FeatureString[5] = cv::Point2f(right_hand.x,  right_hand.y
-*/
-typedef std::vector<cv::Point2f> FeatureString;
-
+#include "FeatureSchema.h"
 
 /**
 	A temporary struct to store the estimation results for every training sample
@@ -75,6 +26,55 @@ struct EstimationResult {
 };
 
 
+// number of the embedded values, used by the first stage of the cascade (the elbow and the direction angles)
+#define CASCADE_DIMS 6
+
+// number of the training samples in a block of the cascade
+#define CASCADE_BLOCK_SIZE 16
+
+// the relative tolerance of the cascade bounds, so the float rounding of the full metric can never
+// make a pruned sample pass the threshold
+#define CASCADE_BOUND_SLACK 1e-4
+
+// the default maximum number of the training samples of a pose
+#define POSE_MAX_SAMPLES 128
+
+/**
+	How a new training sample gets its place, once the pose has reached its capacity
+*/
+enum SampleEviction {
+
+	// reservoir sampling: the new sample replaces a random one, with the probability capacity / (all the samples
+	// offered so far), so the samples stay a uniform selection of everything that was recorded
+	EVICT_RESERVOIR = 0,
+
+	// the new sample always stays, and replaces the most redundant sample (the one closest to its nearest
+	// neighbour), so the samples keep covering the whole pose
+	EVICT_REDUNDANT
+};
+
+/**
+	The bounding sphere of a group of training samples, in the first CASCADE_DIMS embedded values
+*/
+struct CascadeBound {
+
+	double centroid[CASCADE_DIMS];
+
+	double radius;
+};
+
+/**
+	A block of consecutive training samples with their bounding sphere
+*/
+struct SampleBlock {
+
+	// the range of the samples [begin, end)
+	int begin;
+	int end;
+
+	CascadeBound bound;
+};
+
 /**
 	The class, incapsulating the information about a position, that needs to be recognized
 */
@@ -87,7 +87,7 @@ public:
 	KinectPose(const int index, const std::string& fileName);
 
 	/**
-		Create a new pose object with the specified name, using a vector of feature vectors
+		Create a new pose object with the specified name, using a vector of feature vectors (one per training sample)
 	*/
 	KinectPose(const int index, const std::string& poseName, const std::vector<FeatureString>& featureVector);
 
@@ -105,14 +105,14 @@ public:
 	void parsePoseDataFile(const std::string& fileName);
 
 	/**
-		Get the entire training data of the pose.
+		Get the entire training data of the pose (one feature vector per training sample).
 	*/
 	std::vector<FeatureString> getFeatureVector();
 
 	/**
 		Get the name of the current pose
 	*/
-	std::string getPoseName();
+	std::string getPoseName() const;
 
 	/**
 		Set the new name for the current pose
@@ -127,7 +127,7 @@ public:
 		the position. Higher value means the user can derive more from the training samples
 	*/
 	std::vector<double> getReferenceVector();
-	double getReferenceEstimate();
+	double getReferenceEstimate() const;
 
 	/**
 		Get the name of the file that contains the tranining info for this pose
@@ -144,7 +144,7 @@ public:
 	/**
 		Get the id of the pose.
 	*/
-	int getPoseIndex();
+	int getPoseIndex() const;
 
 	/**
 		Calculate the distance vector between the provided test sample and the training samples
@@ -153,14 +153,93 @@ public:
 		@param featureString Feature vector for the current test sample
 		@return Returns a vector of distances, one for every training sample available
 	*/	
-	std::vector<double> estimateLikelihood(const FeatureString& featureString);
+	std::vector<double> estimateLikelihood(const FeatureString& featureString) const;
 
 	/**
-		This will add the provided feature vector as a new training sample for the current pose
+		Same as above, but for the already embedded feature vector (see EmbeddedFeature).
+		The distance is a plain Euclidean norm in the embedded space.
+
+		@param embedded The embedded feature vector of the current test sample
+		@return Returns a vector of distances, one for every training sample available
+	*/
+	std::vector<double> estimateLikelihood(const EmbeddedFeature& embedded) const;
+
+	/**
+		Find all the training samples within the distance threshold of the test sample. Gives exactly the same
+		results as comparing estimateLikelihood() with the threshold, but skips the samples, that can't pass it.
+
+		The search is a cascade: the first stage compares only the angles (the first CASCADE_DIMS embedded values)
+		with the bounding spheres of the whole pose and of the blocks of its samples. Since the distance in
+		a subset of the values is never larger than the full distance, the distance to the center of the sphere
+		minus its radius is a lower bound of the full distance to every sample inside. If the bound is above
+		the threshold, the whole pose (or the block) is skipped, and the full metric runs only on the rest.
+
+		@tparam Metric The metric of the pose library (see ProfilePolicies). It has to be the Euclidean norm
+		of the embedded values, or larger, so the bounds stay lower bounds. Default: EmbeddedMetric.
+
+		@param embedded The embedded feature vector of the current test sample
+		@param threshold The maximum distance
+		@param results The found samples are added here, as (pose index, distance), in the order of the samples
+	*/
+	template <class Metric = EmbeddedMetric>
+	void findSimilarSamples(const EmbeddedFeature& embedded, const double threshold, std::vector<EstimationResult>& results) const;
+
+	/**
+		Get the embedded training samples (see EmbeddedFeature), precomputed at load time
+	*/
+	const std::vector<EmbeddedFeature>& getEmbeddedSamples() const;
+
+	/**
+		Calibrate the distance threshold of the pose for the embedded metric.
+
+		The unit-circle embedding measures the direction angles by their chord, not by the arc, so the
+		embedded distances are slightly shorter than the original ones (and differ a lot, where the old
+		wrap-around at 0/360 was wrong). The calibration compares both metrics on all the pairs of the
+		training samples of the pose, and scales the threshold by the median ratio between them,
+		so the reference estimate from the file keeps its meaning.
+		Without the calibration the threshold is equal to the reference estimate.
+
+		@param enabled Set "true" to calibrate the threshold, "false" to reset it to the reference estimate
+	*/
+	void calibrateThreshold(const bool enabled = true);
+
+	/**
+		Get the maximum distance from a training sample, at which the test sample is still considered
+		to be similar to it. This is the reference estimate, scaled by the calibration (see calibrateThreshold()).
+	*/
+	double getDistanceThreshold() const;
+
+	/**
+		This will add the provided feature vector as a new training sample for the current pose.
+		Once the pose has reached its capacity (see setCapacity()), the new sample replaces one of the
+		old ones, or it's thrown away (only with EVICT_RESERVOIR). The cascade and the nearest neighbours
+		of the samples are updated incrementally, in O(number of samples).
 
 		@param featureString The feature vector from the current instance for the first user
+
+		@return Returns "true" if the sample was kept.
 	*/
-	void addNewTrainingSample(const FeatureString& featureString);
+	bool addNewTrainingSample(const FeatureString& featureString);
+
+	/**
+		Limit the number of the training samples, so the time to compare a test sample with the pose
+		can't grow with the online training. The samples loaded from the file are all kept, the limit
+		applies, when the training samples are added (or when the limit is set lower).
+
+		@param capacity The maximum number of the samples. Default: POSE_MAX_SAMPLES.
+		@param eviction How the new samples replace the old ones. Default: EVICT_REDUNDANT.
+	*/
+	void setCapacity(const int capacity = POSE_MAX_SAMPLES, const SampleEviction eviction = EVICT_REDUNDANT);
+
+	/**
+		Get the maximum number of the training samples
+	*/
+	int getCapacity() const;
+
+	/**
+		Get the number of the training samples
+	*/
+	int getSampleCount() const;
 
 	~KinectPose();
 
@@ -168,6 +247,78 @@ private:
 	// a vector of all traning samples
 	std::vector<FeatureString> featureVector;
 
+	// all the training samples, embedded into the Euclidean space
+	std::vector<EmbeddedFeature> embeddedSamples;
+
+	// the bounds of the cascade: of all the samples, and of the blocks of samples (see findSimilarSamples())
+	CascadeBound poseBound;
+	std::vector<SampleBlock> sampleBlocks;
+
+	/**
+		Recalculate the bounds of the cascade, after the samples have changed
+	*/
+	void buildCascade();
+
+	/**
+		Calculate the bounding sphere of the samples [begin, end)
+	*/
+	CascadeBound calculateBound(const int begin, const int end) const;
+
+	/**
+		Update the bounds of the cascade after the sample was replaced or appended
+	*/
+	void updateCascade(const int sample);
+
+	// the maximum number of the samples, and how the new samples replace the old ones
+	int capacity = POSE_MAX_SAMPLES;
+	SampleEviction eviction = EVICT_REDUNDANT;
+
+	// the number of all the samples offered to the pose (for the reservoir sampling), and the random numbers for it
+	unsigned long long offeredSamples = 0;
+	std::minstd_rand random;
+
+	// the nearest neighbour of every sample within the pose, and the distance to it (for EVICT_REDUNDANT)
+	std::vector<int> neighbours;
+	std::vector<double> neighbourDistances;
+
+	/**
+		Embed the loaded samples, and prepare the cascade and the neighbours
+	*/
+	void prepareSamples();
+
+	/**
+		Find the nearest neighbours of all the samples
+	*/
+	void findNeighbours();
+
+	/**
+		Find the nearest neighbour of the sample
+	*/
+	void findNeighbour(const int sample);
+
+	/**
+		Put the new sample on the place of the old one, or append it, if the place is the end
+
+		@param sample The place of the sample
+		@param featureString The new sample
+		@param embedded The new sample, embedded
+		@param distances The distances from the new sample to all the current samples
+	*/
+	void placeSample(const int sample, const FeatureString& featureString, const EmbeddedFeature& embedded, const std::vector<double>& distances);
+
+	/**
+		Remove the samples over the capacity
+	*/
+	void enforceCapacity();
+
+	/**
+		Save the training samples into the file of the pose
+	*/
+	void saveSamples() const;
+
+	// the scale of the reference estimate for the embedded metric (see calibrateThreshold())
+	double thresholdScale = 1.0;
+
 	// name of the pose
 	std::string poseName;
 
@@ -180,21 +331,5 @@ private:
 	// the reference vector, containing the optimal (minimal) distance vector for each feature
 	std::vector<double> referenceVector = { 0.3, 0.3, 15, 15, 0.2, 0.5, 0.2, 0.5 };
 	double referenceEstimate = 0;
-
-	/**
-		Get the difference between two angles in the Descartes (Cartesian) coordinate system (0..360)
-		@param alpha First angle
-		@param beta Second angle
-	*/
-	double angleDifference(const double alpha, const double beta);
-
-	/**
-		Determines if the provided value lies in the specified range
-
-		@param value The value in question
-		@param A The lower limit
-		@param B The upper limit
-	*/
-	bool isInRange(const double value, const double A, const double B);
 };
 
@@ -4,6 +4,9 @@
 
 #include "KinectPose.h"
 
+#include "JointSnapshot.h"
+#include "FeatureExtractor.h"
+
 #include "Utils.h"
 
 #include <OpenNI.h>
@@ -32,39 +35,12 @@ public:
 	void setSkeletonState(nite::SkeletonState state);
 
 	/**
-		Assign a new user tracker for the user
-		@param userTracker Reference to the user tracker object
-	*/
-	void setUserTracker(nite::UserTracker* userTracker);
-
-	/**
-		Get a reference to the user's skeleton
-	*/
-	const nite::Skeleton* getSkeleton() const;
-
-	/**
-		Get the reference to the user data
-	*/
-	const nite::UserData& getUserData() const;
-
-	/**
-		Assign new user data to the user
-		@param userData Reference to the user data object
-	*/
-	void setUserData(const nite::UserData& userData);
+		Assign the joint snapshot, from which the user reads his skeleton joints
 
-	/**
-		Assign a new skeleton to the user
-		@param rSkeleton Pointer to the skeleton object
+		@param jointSnapshot Pointer to the snapshot, shared by all the users
+		@param slot The slot of the user in the snapshot
 	*/
-	void setSkeleton(const nite::Skeleton* rSkeleton);
-
-	/**
-		Set a reference to the current frame, as viewed by the Kinect using the PrimeSensor SDK
-
-		@param userTrackerFrame Pointer to the frame reference
-	*/
-	void setTrackerFrameRef(nite::UserTrackerFrameRef* userTrackerFrame);
+	void setJointSnapshot(const JointSnapshot* jointSnapshot, const int slot);
 
 	/**
 		Get the current user's id
@@ -92,6 +68,24 @@ public:
 	*/
 	void setPoseName(const std::string& poseName);
 
+	/**
+		Get the confidence margin of the current pose: how far the nearest training sample
+		was inside the distance threshold of the pose, when the pose was recognized
+		(0 - right at the threshold, 1 - exactly the training sample)
+	*/
+	double getPoseMargin();
+
+	/**
+		Set the confidence margin of the current pose
+	*/
+	void setPoseMargin(const double margin);
+
+	/**
+		Forget the current pose and the history of the recent decisions (the pose tumbler),
+		e.g. when the user is switched to a different pose library
+	*/
+	void resetPose();
+
 	/**
 		Set the new pose
 
@@ -106,26 +100,48 @@ public:
 
 	/**
 		Extract the user's features from the current frame.
-		Refer to the KinectPose.h for details.
+		Refer to the FeatureSchema.h for details.
+
+		@param profile The feature profile of the current pose library (see FeatureExtractor.h)
+		@return The feature vector, or an empty one if the joints are not confident enough
 	*/
-	FeatureString extractUserFeatures();
+	FeatureString extractUserFeatures(const FeatureProfile profile = PROFILE_HEAD);
+
+	/**
+		Get the user's features from the batch, that was extracted for all users in the current frame.
+
+		@param batch The features of all users (see extractFeatures() in FeatureExtractor.h)
+		@return The feature vector, or an empty one if the joints are not confident enough
+	*/
+	FeatureString extractUserFeatures(const FeatureBatch& batch);
 
 	/**
 		Draw the user's skeleton On the image (only the upper body)
 
 		@param image Reference to the cv::Mat image, on which we need to draw the skeleton
+		@param offset The position of the image in the full frame, if the image is only a part (tile) of it
 	*/
-	void drawUserSkeleton(cv::Mat& image);
+	void drawUserSkeleton(cv::Mat& image, const cv::Point& offset = cv::Point(0, 0));
 
 	/**
 		Extract the 2D coordinates of the specified joint. The coordinates are given in the simples
 		Cartesian (Descartes) coordinated system, where the upper left corner is (0;0).
+		The joints are projected in one batch for all users every frame (see DepthProjection).
 
 		@param type The name of the joint. See nite::JOINT_XXXXX
 		@return Returns a cv::Point2f object with the point coordinates
 	*/
 	cv::Point2f extractJoint2D(const nite::JointType type);
 
+	/**
+		Get the position of the joint on the output frame: the projected position, or the position
+		predicted to the moment the frame is shown (see JointPredictor). Used for drawing.
+
+		@param type The name of the joint. See nite::JOINT_XXXXX
+		@return Returns a cv::Point2f object with the point coordinates
+	*/
+	cv::Point2f extractDisplayJoint2D(const nite::JointType type);
+
 	/**
 		Get the 2D coordinated of the specified joint. The coordinates are given as the "world coordinates",
 		relative to the Kinect's actual camera (which is 0;0;0). The coordinates are given in milimeters.
@@ -157,52 +173,29 @@ public:
 	~KinectUser();
 
 private:
-	// Pointer to the main UserTracker object
-	nite::UserTracker* userTracker;
-
-	// The current user data
-	nite::UserData userData;
-
 	// The pointer to the current pose of the user
-	KinectPose* userPose;
+	KinectPose* userPose = nullptr;
 
 	// The id of the user
-	nite::UserId userId;
+	nite::UserId userId = 0;
 
 	// The current skeleton state
 	nite::SkeletonState g_skeletonState = nite::SKELETON_NONE;
 
-	// The reference to the current frame extracted by NiTE from the Kinect
-	nite::UserTrackerFrameRef* userTrackerFrame;
-
-	// Is the user visible?
-	bool g_visibleUser = false;
-
 	// The current pose name
 	std::string poseName = "";
 
 	// current pose id
 	int poseIndex = -1;
 
-	// Pointer to the current skeleton object
-	const nite::Skeleton* rSkeleton;
+	// the confidence margin of the current pose (see getPoseMargin())
+	double poseMargin = 0;
 
-	// vector of salien points (most important joint coordinates)
-	std::vector<cv::Point3f> salientPoints;
+	// The joints of all the users in the current frame
+	const JointSnapshot* jointSnapshot = nullptr;
 
-	// distance between user's shoulders
-	double shoulderDist;
-
-	// the center of the body. (Deprecated).
-	cv::Point2f bodyCenter;
-
-	// Full lisr of the extracted joints
-	std::vector<nite::SkeletonJoint> aJoints;
-
-	/**
-		Extracts all the skeleton joints for the current user in the current frame
-	*/
-	void extractAllJoints();
+	// The slot of the user in the joint snapshot
+	int snapshotSlot = -1;
 
 	/**
 		The pose tumbler. This is basiaclly a queue of pose id's, which is kept below certain length.
@@ -0,0 +1,190 @@
+#include "MultiSourceHost.h"
+
+#pragma comment(lib, "psapi.lib")
+
+MultiSourceHost::MultiSourceHost(const std::shared_ptr<const PoseModel>& poseModel) : stopping(false) {
+	this->poseModel = poseModel;
+}
+
+std::unique_ptr<PoseRecognizer> MultiSourceHost::createRecognizer() {
+	std::unique_ptr<PoseRecognizer> recognizer(new PoseRecognizer());
+
+	recognizer->setPoseModel(std::atomic_load(&poseModel));
+
+	return recognizer;
+}
+
+void MultiSourceHost::selectPoseModel(const std::shared_ptr<const PoseModel>& poseModel) {
+
+	if (!poseModel)
+		return;
+
+	std::atomic_store(&this->poseModel, poseModel);
+
+	for (std::unique_ptr<Source>& source : sources) {
+		source->recognizer->selectPoseModel(poseModel);
+	}
+}
+
+bool MultiSourceHost::addSensor(const int deviceIndex) {
+
+	std::unique_ptr<Source> source(new Source());
+	source->recognizer = createRecognizer();
+	source->name = "device #" + std::to_string(deviceIndex);
+
+	if (!source->recognizer->initialize(deviceIndex)) {
+		std::cerr << "Couldn't initialize the " << source->name << std::endl;
+		return false;
+	}
+
+	sources.push_back(std::move(source));
+
+	return true;
+}
+
+bool MultiSourceHost::addReplay(const std::string& streamFile, const std::string& sessionFile, const bool realTime) {
+
+	std::unique_ptr<Source> source(new Source());
+	source->recognizer = createRecognizer();
+	source->name = streamFile;
+
+	if (!source->recognizer->startReplay(streamFile, sessionFile, realTime))
+		return false;
+
+	sources.push_back(std::move(source));
+
+	return true;
+}
+
+int MultiSourceHost::getSourceCount() const {
+	return (int)sources.size();
+}
+
+PoseRecognizer* MultiSourceHost::getRecognizer(const int source) {
+	return (source >= 0 && source < sources.size()) ? sources[source]->recognizer.get() : nullptr;
+}
+
+bool MultiSourceHost::startPublishing(const std::string& baseName) {
+
+	bool opened = true;
+
+	for (size_t i = 0; i < sources.size(); i++) {
+		opened = sources[i]->recognizer->startPublishing(getResultRingName(baseName, (int)i)) && opened;
+	}
+
+	return opened;
+}
+
+std::string MultiSourceHost::getResultRingName(const std::string& baseName, const int source) {
+	return baseName + "." + std::to_string(source);
+}
+
+void MultiSourceHost::start() {
+
+	stopping = false;
+	startTime = std::chrono::steady_clock::now();
+
+	for (std::unique_ptr<Source>& source : sources) {
+		if (source->thread.joinable())
+			continue;
+
+		source->frames = 0;
+		source->recognitions = 0;
+		source->running = true;
+		source->thread = std::thread(&MultiSourceHost::run, this, std::ref(*source));
+	}
+}
+
+void MultiSourceHost::run(Source& source) {
+
+	PoseRecognizer& recognizer = *source.recognizer;
+
+	bool replay = recognizer.isReplaying();
+
+	while (!stopping) {
+		std::vector<KinectUser*> users = recognizer.processNextFrame();
+
+		// the replay has reached the end
+		if (replay && !recognizer.isReplaying())
+			break;
+
+		source.frames++;
+		source.recognitions += users.size();
+	}
+
+	source.running = false;
+}
+
+void MultiSourceHost::wait() {
+	for (std::unique_ptr<Source>& source : sources) {
+		if (source->thread.joinable())
+			source->thread.join();
+	}
+}
+
+void MultiSourceHost::stop() {
+	stopping = true;
+
+	wait();
+}
+
+std::vector<SourceStatistics> MultiSourceHost::getStatistics() const {
+
+	std::vector<SourceStatistics> statistics;
+
+	for (const std::unique_ptr<Source>& source : sources) {
+		SourceStatistics stats;
+		stats.name = source->name;
+		stats.frames = source->frames;
+		stats.recognitions = source->recognitions;
+		stats.running = source->running;
+
+		statistics.push_back(stats);
+	}
+
+	return statistics;
+}
+
+double MultiSourceHost::getThroughput() const {
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	if (seconds <= 0)
+		return 0;
+
+	unsigned long long frames = 0;
+	for (const std::unique_ptr<Source>& source : sources) {
+		frames += source->frames;
+	}
+
+	return frames / seconds;
+}
+
+size_t MultiSourceHost::getMemoryUsage() const {
+
+	PROCESS_MEMORY_COUNTERS counters;
+	counters.cb = sizeof(counters);
+
+	if (!::GetProcessMemoryInfo(::GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+
+	return counters.WorkingSetSize;
+}
+
+void MultiSourceHost::printStatistics(std::ostream& os) const {
+
+	std::shared_ptr<const PoseModel> model = std::atomic_load(&poseModel);
+
+	for (const SourceStatistics& stats : getStatistics()) {
+		os << stats.name << ":\t" << stats.frames << " frames, " << stats.recognitions << " poses recognized"
+			<< (stats.running ? "" : " (finished)") << std::endl;
+	}
+
+	os << "Total: " << getThroughput() << " frames per second, "
+		<< getMemoryUsage() / (1024 * 1024) << " MB of memory (the shared pose model: "
+		<< (model ? model->getMemoryUsage() / 1024 : 0) << " KB)" << std::endl;
+}
+
+MultiSourceHost::~MultiSourceHost() {
+	stop();
+}
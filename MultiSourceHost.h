@@ -0,0 +1,177 @@
+#pragma once
+
+#include "PoseRecognizer.h"
+
+#include <Psapi.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+/**
+	The statistics of a single source of the MultiSourceHost
+*/
+struct SourceStatistics {
+
+	// the name of the source (the device index or the replayed file)
+	std::string name;
+
+	// the number of processed frames
+	unsigned long long frames = 0;
+
+	// the number of recognized poses (summed over the users)
+	unsigned long long recognitions = 0;
+
+	// is the source still running?
+	bool running = false;
+};
+
+/**
+	Runs several pose recognizers in the same process, every one on its own thread: one per Kinect
+	device, or per replayed recording (see PoseRecognizer::startReplay()), which can stand in for
+	the devices when testing. All the recognizers share the same immutable pose model, and the
+	NiTE is initialized once for all of them (see NiteRuntime).
+*/
+class MultiSourceHost {
+
+public:
+	/**
+		Create the host
+
+		@param poseModel The pose model, shared by all the recognizers
+	*/
+	MultiSourceHost(const std::shared_ptr<const PoseModel>& poseModel);
+
+	/**
+		Add a recognizer for the Kinect device
+
+		@param deviceIndex The index of the device
+
+		@return Returns "true" if the device was initialized
+	*/
+	bool addSensor(const int deviceIndex);
+
+	/**
+		Add a recognizer, that replays the recorded streams
+
+		@param streamFile The path to the stream file (see PoseRecognizer::startStreamRecording())
+		@param sessionFile The path to the skeleton session file, recorded at the same time. Optional.
+		@param realTime Replay at the original rate (true) or as fast as possible (false). Default: true.
+
+		@return Returns "true" if the files were opened
+	*/
+	bool addReplay(const std::string& streamFile, const std::string& sessionFile = "", const bool realTime = true);
+
+	/**
+		Get the number of sources
+	*/
+	int getSourceCount() const;
+
+	/**
+		Get the recognizer of the source, e.g. to start a recording. Shouldn't be used from
+		another thread while the host is running.
+	*/
+	PoseRecognizer* getRecognizer(const int source);
+
+	/**
+		Switch all the sources to another pose library, e.g. when the venue changes. Can be called
+		while the host is running: every recognizer switches between two of its frames
+		(see PoseRecognizer::selectPoseModel()).
+
+		@param poseModel The pose model, e.g. from the store (see PoseModelStore::get())
+	*/
+	void selectPoseModel(const std::shared_ptr<const PoseModel>& poseModel);
+
+	/**
+		Start publishing the results of every source into its own shared memory (see PoseRecognizer::startPublishing()),
+		named "<baseName>.<source>", e.g. "MusicalPoseRecognizer.Results.0". Call it after all the sources were added.
+
+		@param baseName The beginning of the names of the shared memories. Default: RESULT_RING_NAME.
+
+		@return Returns "true" if all the shared memories were created
+	*/
+	bool startPublishing(const std::string& baseName = RESULT_RING_NAME);
+
+	/**
+		Get the name of the shared memory of the source (see startPublishing())
+	*/
+	static std::string getResultRingName(const std::string& baseName, const int source);
+
+	/**
+		Start processing the frames of all the sources, every one on its own thread
+	*/
+	void start();
+
+	/**
+		Wait until all the sources are finished (the replays reach the end, the live sources are stopped)
+	*/
+	void wait();
+
+	/**
+		Stop all the sources and wait for their threads
+	*/
+	void stop();
+
+	/**
+		Get the statistics of all the sources
+	*/
+	std::vector<SourceStatistics> getStatistics() const;
+
+	/**
+		Get the total number of frames processed per second by all the sources since start()
+	*/
+	double getThroughput() const;
+
+	/**
+		Get the memory used by the whole process (the working set), in bytes
+	*/
+	size_t getMemoryUsage() const;
+
+	/**
+		Print the statistics of all the sources, the total throughput and the memory usage
+	*/
+	void printStatistics(std::ostream& os) const;
+
+	~MultiSourceHost();
+
+private:
+	/**
+		A single recognizer with its thread
+	*/
+	struct Source {
+		std::unique_ptr<PoseRecognizer> recognizer;
+
+		std::string name;
+
+		std::thread thread;
+
+		std::atomic<unsigned long long> frames;
+		std::atomic<unsigned long long> recognitions;
+		std::atomic<bool> running;
+
+		Source() : frames(0), recognitions(0), running(false) {}
+	};
+
+	// the shared pose model. Replaced by selectPoseModel() while the sources run, so it's only
+	// accessed with std::atomic_load() and std::atomic_store()
+	std::shared_ptr<const PoseModel> poseModel;
+
+	// all the sources
+	std::vector<std::unique_ptr<Source>> sources;
+
+	// signals the threads to stop
+	std::atomic<bool> stopping;
+
+	// when the sources were started
+	std::chrono::steady_clock::time_point startTime;
+
+	/**
+		The loop of the source thread
+	*/
+	void run(Source& source);
+
+	/**
+		Create a new recognizer with the shared pose model
+	*/
+	std::unique_ptr<PoseRecognizer> createRecognizer();
+};
@@ -0,0 +1,43 @@
+#include "NiteRuntime.h"
+
+std::mutex NiteRuntime::mutex;
+int NiteRuntime::users = 0;
+
+bool NiteRuntime::acquire() {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (users == 0) {
+		if (openni::OpenNI::initialize() != openni::STATUS_OK) {
+			std::cerr << "Couldn't initialize OpenNI" << std::endl;
+			return false;
+		}
+
+		if (nite::NiTE::initialize() != nite::STATUS_OK) {
+			std::cerr << "Couldn't initialize NiTE" << std::endl;
+			openni::OpenNI::shutdown();
+			return false;
+		}
+	}
+
+	users++;
+
+	return true;
+}
+
+void NiteRuntime::release() {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (users == 0)
+		return;
+
+	if (--users == 0) {
+		nite::NiTE::shutdown();
+		openni::OpenNI::shutdown();
+	}
+}
+
+int NiteRuntime::getUsers() {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	return users;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <NiTE.h>
+#include <OpenNI.h>
+
+#include <iostream>
+#include <mutex>
+
+/**
+	The process-wide lifecycle of the OpenNI and the NiTE. Both libraries can only be initialized
+	and shut down once per process, so with several recognizers in the same process, every one of
+	them acquires the runtime when it's initialized, and releases it when it's destroyed.
+	The libraries are initialized by the first acquire() and shut down by the last release().
+*/
+class NiteRuntime {
+
+public:
+	/**
+		Initialize the OpenNI and the NiTE, if this is the first user
+
+		@return Returns "true" if the libraries are initialized. Every successful acquire() must be paired with a release().
+	*/
+	static bool acquire();
+
+	/**
+		Shut down the OpenNI and the NiTE, if this is the last user
+	*/
+	static void release();
+
+	/**
+		Get the number of the current users of the runtime
+	*/
+	static int getUsers();
+
+private:
+	// guards the counter
+	static std::mutex mutex;
+
+	// the number of the users
+	static int users;
+};
@@ -0,0 +1,153 @@
+#include "OverlayRenderer.h"
+
+/**
+	Renders a range of tiles of the output frame. Used with the cv::parallel_for_
+*/
+class TileRenderer : public cv::ParallelLoopBody {
+
+public:
+	TileRenderer(cv::Mat& image, const std::vector<KinectUser*>& users, std::vector<cv::Mat>& sprites,
+		const std::vector<cv::Point>& locations, const int tileHeight)
+		: image(image), users(users), sprites(sprites), locations(locations), tileHeight(tileHeight) {
+	}
+
+	virtual void operator()(const cv::Range& range) const {
+		for (int t = range.start; t < range.end; t++) {
+
+			int top = t * tileHeight;
+			int bottom = (std::min)(top + tileHeight, image.rows);
+
+			if (top >= bottom)
+				continue;
+
+			// the tile shares the data with the full image
+			cv::Mat tile = image.rowRange(top, bottom);
+			cv::Point offset(0, top);
+
+			// first the skeletons...
+			for (KinectUser* user : users) {
+				user->drawUserSkeleton(tile, offset);
+			}
+
+			// ...then the instruments over them
+			for (int i = 0; i < sprites.size(); i++) {
+				if (sprites[i].empty())
+					continue;
+
+				// skip the pictures that don't touch this tile
+				if (locations[i].y >= bottom || locations[i].y + sprites[i].rows <= top)
+					continue;
+
+				overlayImage(tile, sprites[i], locations[i] - offset);
+			}
+		}
+	}
+
+private:
+	cv::Mat& image;
+	const std::vector<KinectUser*>& users;
+	std::vector<cv::Mat>& sprites;
+	const std::vector<cv::Point>& locations;
+	int tileHeight;
+};
+
+OverlayRenderer::OverlayRenderer(const std::string& spriteFolder) {
+	this->spriteFolder = spriteFolder;
+}
+
+void OverlayRenderer::setTileCount(const int tiles) {
+	this->tileCount = tiles;
+}
+
+void OverlayRenderer::render(cv::Mat& image, const std::vector<KinectUser*>& users) {
+
+	if (image.empty())
+		return;
+
+	// place the instruments first (sequentially, as the pictures may need to be loaded)
+	std::vector<cv::Mat> userSprites;
+	std::vector<cv::Point> locations;
+
+	for (KinectUser* user : users) {
+		if (user->getPoseIndex() < 0 || user->getPoseName() == "")
+			continue;
+
+		const cv::Mat& sprite = getSprite(user->getPoseName());
+
+		userSprites.push_back(sprite);
+		locations.push_back(getSpriteLocation(*user, sprite));
+	}
+
+	// split the frame into tiles
+	int tiles = (tileCount > 0) ? tileCount : cv::getNumThreads();
+	tiles = (std::max)(1, (std::min)(tiles, image.rows / minTileHeight));
+
+	int tileHeight = (image.rows + tiles - 1) / tiles;
+
+	cv::parallel_for_(cv::Range(0, tiles), TileRenderer(image, users, userSprites, locations, tileHeight));
+}
+
+const cv::Mat& OverlayRenderer::getSprite(const std::string& poseName) {
+
+	auto sprite = sprites.find(poseName);
+
+	if (sprite == sprites.end()) {
+		std::string fileName = spriteFolder + "/" + poseName + ".png";
+
+		sprite = sprites.insert(std::make_pair(poseName, cv::imread(fileName, cv::IMREAD_UNCHANGED))).first;
+	}
+
+	return sprite->second;
+}
+
+cv::Point OverlayRenderer::getSpriteLocation(KinectUser& user, const cv::Mat& instrument) {
+
+	cv::Point2f pt1 = user.extractDisplayJoint2D(nite::JOINT_LEFT_HAND);
+	cv::Point2f pt2 = user.extractDisplayJoint2D(nite::JOINT_RIGHT_HAND);
+
+	double handDist = calcDistance(pt1, pt2);
+
+	cv::Point location = pt1;
+
+	// make some adjustments so the pictures look nice-ish.
+	// flute
+	if (user.getPoseIndex() == 0) {
+		location.x -= instrument.cols / 4;
+		location.y -= instrument.rows / 2;
+	}
+
+	// clarinet
+	if (user.getPoseIndex() == 1) {
+		location.y -= instrument.rows / 4;
+	}
+
+	// violin
+	if (user.getPoseIndex() == 2) {
+		//location.y -= instrument.rows / 3;
+	}
+
+	// cello
+	if (user.getPoseIndex() == 3) {
+		location.x -= instrument.cols / 2;
+		location.y -= instrument.rows / 5;
+	}
+
+	// trombone
+	if (user.getPoseIndex() == 4) {
+		location.y -= instrument.rows / 2;
+	}
+
+	// conductor
+	if (user.getPoseIndex() == 6) {
+		location.y -= instrument.rows;
+		location.x -= instrument.cols;
+	}
+
+	// drums
+	if (user.getPoseIndex() == 5) {
+		location.y -= instrument.rows / 3;
+		location.x -= (instrument.cols - handDist) / 2;
+	}
+
+	return location;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "KinectUser.h"
+
+#include <map>
+
+/**
+	Draws the overlays (skeletons and instrument pictures) of all the users on the output frame.
+
+	The frame is split into horizontal tiles, which are rendered in parallel (cv::parallel_for_).
+	Every tile draws all the overlays that touch it, clipped to the tile, in the same order
+	as the full frame would be drawn: first all the skeletons, then all the instruments, each
+	in the order of the user ids. So the overlapping overlays look the same, no matter how many
+	tiles there are.
+
+	The pictures of the instruments are loaded from the disk only once.
+*/
+class OverlayRenderer {
+
+public:
+	/**
+		Create a new renderer
+
+		@param spriteFolder The folder with the pictures of the instruments (<pose name>.png)
+	*/
+	OverlayRenderer(const std::string& spriteFolder = "./instruments");
+
+	/**
+		Set the number of tiles, into which the frame is split
+
+		@param tiles The number of tiles. 0 means one tile per thread. Default: 0.
+	*/
+	void setTileCount(const int tiles = 0);
+
+	/**
+		Draw the overlays of the users on the image
+
+		@param image The output image
+		@param users The users to draw, in the order of drawing
+	*/
+	void render(cv::Mat& image, const std::vector<KinectUser*>& users);
+
+private:
+	/**
+		The instrument picture of a single user, placed on the frame
+	*/
+	struct Sprite {
+
+		cv::Mat image;
+
+		cv::Point location;
+
+		Sprite(const cv::Mat& img, const cv::Point& loc) {
+			image = img;
+			location = loc;
+		}
+	};
+
+	// the folder with the instrument pictures
+	std::string spriteFolder;
+
+	// the loaded instrument pictures, by the name of the pose
+	std::map<std::string, cv::Mat> sprites;
+
+	// the number of tiles (0 - one per thread)
+	int tileCount = 0;
+
+	// the minimal height of a tile in pixels, so the tiles are not too small to be worth a thread
+	int minTileHeight = 32;
+
+	/**
+		Get the picture of the instrument for the pose. Loads it on the first use.
+	*/
+	const cv::Mat& getSprite(const std::string& poseName);
+
+	/**
+		Calculate where the picture of the instrument should be placed for the user
+	*/
+	cv::Point getSpriteLocation(KinectUser& user, const cv::Mat& sprite);
+};
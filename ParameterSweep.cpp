@@ -0,0 +1,235 @@
+#include "ParameterSweep.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iomanip>
+#include <thread>
+
+/**
+	Run the jobs on the threads, every thread takes the next job, until there are none left
+*/
+static void runParallel(const int jobs, const int threads, const std::function<void(int)>& job) {
+
+	std::atomic<int> next(0);
+	std::vector<std::thread> workers;
+
+	int count = (threads > 0) ? threads : (int)std::thread::hardware_concurrency();
+	count = (std::max)(1, (std::min)(count, jobs));
+
+	for (int i = 0; i < count; i++) {
+		workers.push_back(std::thread([&] {
+			for (int index = next++; index < jobs; index = next++) {
+				job(index);
+			}
+		}));
+	}
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+/**
+	Add the results of a session to the results of the other sessions
+*/
+static void addResult(BenchmarkResult& total, const BenchmarkResult& result) {
+
+	unsigned long long frames = total.frames + result.frames;
+	unsigned long long userFrames = total.userFrames + result.userFrames;
+	int recognizedPoses = total.recognizedPoses + result.recognizedPoses;
+
+	// the averages are weighted by what they're averaged over
+	if (userFrames > 0)
+		total.accuracy = (total.accuracy * total.userFrames + result.accuracy * result.userFrames) / userFrames;
+
+	if (recognizedPoses > 0) {
+		total.framesToPose = (total.framesToPose * total.recognizedPoses + result.framesToPose * result.recognizedPoses) / recognizedPoses;
+		total.millisecondsToPose = (total.millisecondsToPose * total.recognizedPoses + result.millisecondsToPose * result.recognizedPoses) / recognizedPoses;
+	}
+
+	if (frames > 0)
+		total.millisecondsPerFrame = (total.millisecondsPerFrame * total.frames + result.millisecondsPerFrame * result.frames) / frames;
+
+	total.frames = frames;
+	total.userFrames = userFrames;
+	total.recognizedPoses = recognizedPoses;
+	total.referencePoses += result.referencePoses;
+	total.flickers += result.flickers;
+	total.minutes += result.minutes;
+
+	if (total.minutes > 0)
+		total.flickersPerMinute = total.flickers / total.minutes;
+}
+
+ParameterSweep::ParameterSweep(const std::shared_ptr<const PoseModel>& poseModel, const bool smoothing) {
+	this->poseModel = poseModel;
+	this->smoothing = smoothing;
+}
+
+bool ParameterSweep::addSession(const std::string& sessionFile) {
+
+	SkeletonSessionReader reader;
+
+	if (!reader.open(sessionFile))
+		return false;
+
+	SweepSession session;
+	session.projection = reader.getProjection();
+
+	SkeletonFrame frame;
+
+	while (reader.readNextFrame(frame)) {
+		session.frames.push_back(frame);
+	}
+
+	sessions.push_back(session);
+
+	return true;
+}
+
+std::vector<RecognizerParams> ParameterSweep::makeGrid(const SweepGrid& grid) {
+
+	const RecognizerParams defaults;
+
+	// the parameters, that aren't listed, keep the default value
+	const std::vector<int> nearestNeighbours = grid.nearestNeighbours.empty() ? std::vector<int>({ defaults.nearestNeighbours }) : grid.nearestNeighbours;
+	const std::vector<int> poseHolds = grid.poseHolds.empty() ? std::vector<int>({ defaults.poseHold }) : grid.poseHolds;
+	const std::vector<int> frameSkips = grid.frameSkips.empty() ? std::vector<int>({ defaults.frameSkip }) : grid.frameSkips;
+	const std::vector<double> nearDistances = grid.nearDistances.empty() ? std::vector<double>({ defaults.nearDistance }) : grid.nearDistances;
+	const std::vector<double> distanceSlopes = grid.distanceSlopes.empty() ? std::vector<double>({ defaults.distanceSlope }) : grid.distanceSlopes;
+	const std::vector<double> thresholdScales = grid.thresholdScales.empty() ? std::vector<double>({ defaults.thresholdScale }) : grid.thresholdScales;
+
+	std::vector<RecognizerParams> combinations;
+
+	for (int k : nearestNeighbours)
+		for (int hold : poseHolds)
+			for (int skip : frameSkips)
+				for (double distance : nearDistances)
+					for (double slope : distanceSlopes)
+						for (double scale : thresholdScales) {
+							RecognizerParams params;
+							params.nearestNeighbours = k;
+							params.poseHold = hold;
+							params.frameSkip = skip;
+							params.nearDistance = distance;
+							params.distanceSlope = slope;
+							params.thresholdScale = scale;
+
+							combinations.push_back(params);
+						}
+
+	return combinations;
+}
+
+std::vector<SweepResult> ParameterSweep::run(const std::vector<RecognizerParams>& combinations, const int threads) {
+
+	std::vector<SweepResult> results(combinations.size());
+
+	if (combinations.empty())
+		return results;
+
+	// the widest thresholds of all the combinations: the multiplier grows with the scale and the slope,
+	// and with a shorter near distance
+	RecognizerParams widest;
+	widest.nearDistance = combinations[0].nearDistance;
+	widest.distanceSlope = combinations[0].distanceSlope;
+	widest.thresholdScale = combinations[0].thresholdScale;
+
+	for (const RecognizerParams& params : combinations) {
+		widest.nearDistance = (std::min)(widest.nearDistance, params.nearDistance);
+		widest.distanceSlope = (std::max)(widest.distanceSlope, params.distanceSlope);
+		widest.thresholdScale = (std::max)(widest.thresholdScale, params.thresholdScale);
+	}
+
+	// compute the distances of every session once, estimating in every frame
+	runParallel((int)sessions.size(), threads, [&](int index) {
+		SweepSession& session = sessions[index];
+		session.distances = std::make_shared<DistanceTable>();
+
+		std::unique_ptr<PoseRecognizer> recognizer = createRecognizer(session, widest);
+		recognizer->setDistanceTable(session.distances, true);
+
+		for (const SkeletonFrame& frame : session.frames) {
+			recognizer->processSkeletonFrame(frame);
+		}
+	});
+
+	// and replay them with every combination
+	runParallel((int)combinations.size(), threads, [&](int index) {
+		SweepResult& result = results[index];
+		result.params = combinations[index];
+
+		for (const SweepSession& session : sessions) {
+			std::unique_ptr<PoseRecognizer> recognizer = createRecognizer(session, combinations[index]);
+			recognizer->setDistanceTable(session.distances);
+
+			BenchmarkResult sessionResult;
+			ReplayBenchmark::run(*recognizer, session.frames, sessionResult);
+
+			// the distances were computed only once, but every combination would compute them on its own
+			if (sessionResult.frames > 0)
+				sessionResult.millisecondsPerFrame += recognizer->getDistanceTableTime() / sessionResult.frames;
+
+			addResult(result.benchmark, sessionResult);
+		}
+
+		result.benchmark.settings.name = "k " + std::to_string(result.params.nearestNeighbours) + ", hold " + std::to_string(result.params.poseHold)
+			+ ", skip " + std::to_string(result.params.frameSkip);
+		result.benchmark.settings.smoothing = smoothing;
+		result.benchmark.settings.poseHold = result.params.poseHold;
+	});
+
+	return results;
+}
+
+const SweepResult* ParameterSweep::findFastest(const std::vector<SweepResult>& results, const double minAccuracy) {
+
+	const SweepResult* fastest = nullptr;
+
+	for (const SweepResult& result : results) {
+		if (result.benchmark.accuracy < minAccuracy)
+			continue;
+
+		if (fastest == nullptr || result.benchmark.millisecondsPerFrame < fastest->benchmark.millisecondsPerFrame)
+			fastest = &result;
+	}
+
+	return fastest;
+}
+
+void ParameterSweep::print(std::ostream& os, const std::vector<SweepResult>& results) {
+
+	os << std::right << std::setw(4) << "K" << std::setw(6) << "Hold" << std::setw(6) << "Skip"
+		<< std::setw(8) << "Near" << std::setw(8) << "Slope" << std::setw(8) << "Scale"
+		<< std::setw(10) << "Accuracy" << std::setw(12) << "Recognized"
+		<< std::setw(10) << "To pose" << std::setw(12) << "To pose ms"
+		<< std::setw(12) << "Flicker/min" << std::setw(10) << "ms/frame" << std::endl;
+
+	os << std::fixed << std::setprecision(2);
+
+	for (const SweepResult& result : results) {
+		const RecognizerParams& params = result.params;
+		const BenchmarkResult& benchmark = result.benchmark;
+
+		os << std::setw(4) << params.nearestNeighbours << std::setw(6) << params.poseHold << std::setw(6) << params.frameSkip
+			<< std::setw(8) << params.nearDistance << std::setw(8) << params.distanceSlope << std::setw(8) << params.thresholdScale
+			<< std::setw(10) << benchmark.accuracy * 100
+			<< std::setw(12) << (std::to_string(benchmark.recognizedPoses) + "/" + std::to_string(benchmark.referencePoses))
+			<< std::setw(10) << benchmark.framesToPose << std::setw(12) << benchmark.millisecondsToPose
+			<< std::setw(12) << benchmark.flickersPerMinute << std::setw(10) << benchmark.millisecondsPerFrame << std::endl;
+	}
+
+	os << std::defaultfloat;
+}
+
+std::unique_ptr<PoseRecognizer> ParameterSweep::createRecognizer(const SweepSession& session, const RecognizerParams& params) const {
+
+	std::unique_ptr<PoseRecognizer> recognizer(new PoseRecognizer());
+	recognizer->setPoseModel(poseModel);
+	recognizer->setDepthProjection(session.projection);
+	recognizer->setJointSmoothing(smoothing);
+	recognizer->setParams(params);
+
+	return recognizer;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "ReplayBenchmark.h"
+
+/**
+	The values of every parameter to try (see RecognizerParams). The sweep tries every combination.
+	A parameter, that isn't listed, keeps its default value.
+*/
+struct SweepGrid {
+
+	std::vector<int> nearestNeighbours;
+	std::vector<int> poseHolds;
+	std::vector<int> frameSkips;
+	std::vector<double> nearDistances;
+	std::vector<double> distanceSlopes;
+	std::vector<double> thresholdScales;
+};
+
+/**
+	The results of one combination of the parameters, over all the sessions
+*/
+struct SweepResult {
+
+	RecognizerParams params;
+
+	// the results, summed over the sessions (see BenchmarkResult)
+	BenchmarkResult benchmark;
+};
+
+/**
+	Replays the labelled skeleton sessions through the recognizer with a grid of its parameters, on all
+	the cores, to find the fastest parameters, that are still accurate enough.
+
+	The sessions are read into memory once. Before the grid is run, every session is replayed once with
+	the widest thresholds of the grid, and the distances to the training samples are stored in a
+	DistanceTable, so the combinations only filter and vote, instead of comparing the features again.
+	Every combination is then replayed on its own thread with its own recognizer, and scored the same way
+	as the ReplayBenchmark: the accuracy against the stored poses, the time to the pose, the flicker,
+	and the processing time per frame (measured on the thread of the combination, with the time of
+	the distances taken from the table added back, see PoseRecognizer::getDistanceTableTime()).
+*/
+class ParameterSweep {
+
+public:
+	/**
+		Create the sweep
+
+		@param poseModel The poses to recognize
+		@param smoothing Smooth the joints (see PoseRecognizer::setJointSmoothing()). The same for all the combinations.
+	*/
+	ParameterSweep(const std::shared_ptr<const PoseModel>& poseModel, const bool smoothing = false);
+
+	/**
+		Read a labelled session into memory
+
+		@param sessionFile The path to the skeleton session file (see PoseRecognizer::startRecording())
+
+		@return Returns "false" if the session couldn't be opened.
+	*/
+	bool addSession(const std::string& sessionFile);
+
+	/**
+		Get all the combinations of the values of the grid
+	*/
+	static std::vector<RecognizerParams> makeGrid(const SweepGrid& grid);
+
+	/**
+		Replay all the sessions with every combination of the parameters
+
+		@param combinations The combinations to try (see makeGrid())
+		@param threads The number of the threads. Default: 0, one per core.
+
+		@return The results, in the order of the combinations
+	*/
+	std::vector<SweepResult> run(const std::vector<RecognizerParams>& combinations, const int threads = 0);
+
+	/**
+		Find the combination with the shortest processing time per frame, that is at least as accurate as required
+
+		@param results The results of the sweep
+		@param minAccuracy The required accuracy (0..1)
+
+		@return Returns the result, or nullptr if no combination is accurate enough.
+	*/
+	static const SweepResult* findFastest(const std::vector<SweepResult>& results, const double minAccuracy);
+
+	/**
+		Print the results as a table
+	*/
+	static void print(std::ostream& os, const std::vector<SweepResult>& results);
+
+private:
+	/**
+		A session in memory, with its distances
+	*/
+	struct SweepSession {
+		DepthProjection projection;
+		std::vector<SkeletonFrame> frames;
+		std::shared_ptr<DistanceTable> distances;
+	};
+
+	// the poses to recognize
+	std::shared_ptr<const PoseModel> poseModel;
+
+	// smooth the joints?
+	bool smoothing;
+
+	// the sessions
+	std::vector<SweepSession> sessions;
+
+	/**
+		Create a recognizer for the session
+	*/
+	std::unique_ptr<PoseRecognizer> createRecognizer(const SweepSession& session, const RecognizerParams& params) const;
+};
@@ -0,0 +1,143 @@
+#include "PoseEvents.h"
+
+#include <algorithm>
+#include <cstring>
+
+PoseEventDispatcher::PoseEventDispatcher(const int queueSize) {
+	events.resize((std::max)(1, queueSize));
+}
+
+int PoseEventDispatcher::subscribe(const Callback& callback) {
+	(dispatching ? addedSubscribers : subscribers).push_back(std::make_pair(nextSubscription, callback));
+
+	return nextSubscription++;
+}
+
+void PoseEventDispatcher::unsubscribe(const int subscription) {
+
+	auto matches = [subscription](const std::pair<int, Callback>& s) {
+		return s.first == subscription;
+	};
+
+	addedSubscribers.erase(std::remove_if(std::begin(addedSubscribers), std::end(addedSubscribers), matches), std::end(addedSubscribers));
+
+	if (dispatching) {
+		// the callback may be running right now, so it's only marked as removed
+		for (std::pair<int, Callback>& subscriber : subscribers) {
+			if (matches(subscriber)) {
+				subscriber.first = -1;
+				removedSubscribers = true;
+			}
+		}
+
+		return;
+	}
+
+	subscribers.erase(std::remove_if(std::begin(subscribers), std::end(subscribers), matches), std::end(subscribers));
+}
+
+bool PoseEventDispatcher::hasSubscribers() const {
+	return !subscribers.empty() || !addedSubscribers.empty();
+}
+
+PoseEvent* PoseEventDispatcher::emit(const PoseEventType type, const nite::UserId userId, const unsigned long long timestamp) {
+
+	if (eventCount >= events.size()) {
+		droppedEvents++;
+		return nullptr;
+	}
+
+	PoseEvent* event = &events[eventCount++];
+	event->type = type;
+	event->userId = userId;
+	event->poseIndex = -1;
+	event->poseName[0] = 0;
+	event->timestamp = timestamp;
+	event->margin = 0;
+
+	return event;
+}
+
+void PoseEventDispatcher::userAppeared(const nite::UserId userId, const unsigned long long timestamp) {
+	emit(EVENT_USER_APPEARED, userId, timestamp);
+}
+
+void PoseEventDispatcher::userLost(const nite::UserId userId, const unsigned long long timestamp) {
+	emit(EVENT_USER_LOST, userId, timestamp);
+}
+
+void PoseEventDispatcher::poseEntered(const nite::UserId userId, const int poseIndex, const std::string& poseName, const unsigned long long timestamp, const double margin) {
+
+	PoseEvent* event = emit(EVENT_POSE_ENTERED, userId, timestamp);
+
+	if (event == nullptr)
+		return;
+
+	event->poseIndex = poseIndex;
+	event->margin = margin;
+
+	setName(event, poseName);
+}
+
+void PoseEventDispatcher::poseLeft(const nite::UserId userId, const int poseIndex, const std::string& poseName, const unsigned long long timestamp) {
+
+	PoseEvent* event = emit(EVENT_POSE_LEFT, userId, timestamp);
+
+	if (event == nullptr)
+		return;
+
+	event->poseIndex = poseIndex;
+
+	setName(event, poseName);
+}
+
+void PoseEventDispatcher::gesturePerformed(const nite::UserId userId, const int gestureIndex, const std::string& gestureName, const unsigned long long timestamp, const double margin) {
+
+	PoseEvent* event = emit(EVENT_GESTURE, userId, timestamp);
+
+	if (event == nullptr)
+		return;
+
+	event->poseIndex = gestureIndex;
+	event->margin = margin;
+
+	setName(event, gestureName);
+}
+
+void PoseEventDispatcher::setName(PoseEvent* event, const std::string& name) {
+	size_t length = (std::min)(name.size(), (size_t)EVENT_POSE_NAME_LENGTH - 1);
+	std::memcpy(event->poseName, name.c_str(), length);
+	event->poseName[length] = 0;
+}
+
+void PoseEventDispatcher::dispatch() {
+
+	dispatching = true;
+
+	for (int e = 0; e < eventCount; e++) {
+		for (const std::pair<int, Callback>& subscriber : subscribers) {
+			if (subscriber.first >= 0)
+				subscriber.second(events[e]);
+		}
+	}
+
+	eventCount = 0;
+
+	dispatching = false;
+
+	// apply the changes made by the callbacks
+	if (removedSubscribers) {
+		subscribers.erase(std::remove_if(std::begin(subscribers), std::end(subscribers), [](const std::pair<int, Callback>& s) {
+			return s.first < 0;
+		}), std::end(subscribers));
+
+		removedSubscribers = false;
+	}
+
+	subscribers.insert(std::end(subscribers), std::begin(addedSubscribers), std::end(addedSubscribers));
+	addedSubscribers.clear();
+}
+
+unsigned int PoseEventDispatcher::getDroppedEvents() const {
+	return this->droppedEvents;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <NiTE.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#define EVENT_POSE_NAME_LENGTH 32   // maximum length of the pose name in the event, including the terminating zero
+#define EVENT_QUEUE_SIZE 64         // default number of preallocated events per frame
+
+/**
+	The types of the pose events
+*/
+enum PoseEventType {
+	EVENT_USER_APPEARED,   // a new user was detected
+	EVENT_USER_LOST,       // the user left the scene
+	EVENT_POSE_ENTERED,    // the user assumed a pose (the pose was recognized)
+	EVENT_POSE_LEFT,       // the user no longer holds the pose
+	EVENT_GESTURE          // the user has performed a gesture (see GestureRecognizer)
+};
+
+/**
+	A single pose event
+*/
+struct PoseEvent {
+
+	PoseEventType type;
+
+	// the NiTE id of the user
+	nite::UserId userId;
+
+	// the index of the pose, that was entered or left (or of the gesture), or -1 for the user events
+	int poseIndex;
+
+	// the name of the pose or the gesture (zero-terminated), or an empty string for the user events
+	char poseName[EVENT_POSE_NAME_LENGTH];
+
+	// the timestamp of the frame, in which the decision changed, in microseconds
+	unsigned long long timestamp;
+
+	// the confidence margin of the pose at the moment it was entered (see KinectUser::getPoseMargin()),
+	// or of the gesture (see GestureMatch), or 0 for the other events
+	double margin;
+};
+
+/**
+	Collects the pose events of a frame and delivers them to all the subscribers, at the end of
+	the frame, in the order they happened. The events are kept in a preallocated queue, so no
+	memory is allocated while the events are emitted.
+*/
+class PoseEventDispatcher {
+
+public:
+	typedef std::function<void(const PoseEvent&)> Callback;
+
+	/**
+		Create the dispatcher
+
+		@param queueSize The maximum number of events per frame. Default: EVENT_QUEUE_SIZE.
+	*/
+	PoseEventDispatcher(const int queueSize = EVENT_QUEUE_SIZE);
+
+	/**
+		Register a new subscriber
+
+		@param callback The function, that is called for every event. It's called on the thread,
+		that processes the frames, so it should return quickly. A subscriber added by a callback
+		receives the events from the next dispatch().
+
+		@return The id of the subscription, used to unsubscribe
+	*/
+	int subscribe(const Callback& callback);
+
+	/**
+		Remove the subscriber. Can be called from a callback, the subscriber then receives no more events.
+
+		@param subscription The id, returned by subscribe()
+	*/
+	void unsubscribe(const int subscription);
+
+	/**
+		Check if there are any subscribers. If not, the events don't need to be emitted at all:
+		PoseRecognizer checks this before it builds an event.
+	*/
+	bool hasSubscribers() const;
+
+	/**
+		Emit the user events
+	*/
+	void userAppeared(const nite::UserId userId, const unsigned long long timestamp);
+	void userLost(const nite::UserId userId, const unsigned long long timestamp);
+
+	/**
+		Emit the pose events
+	*/
+	void poseEntered(const nite::UserId userId, const int poseIndex, const std::string& poseName, const unsigned long long timestamp, const double margin);
+	void poseLeft(const nite::UserId userId, const int poseIndex, const std::string& poseName, const unsigned long long timestamp);
+
+	/**
+		Emit the gesture event
+	*/
+	void gesturePerformed(const nite::UserId userId, const int gestureIndex, const std::string& gestureName, const unsigned long long timestamp, const double margin);
+
+	/**
+		Deliver all the emitted events to the subscribers, and clear the queue
+	*/
+	void dispatch();
+
+	/**
+		Get the number of the events, that didn't fit into the queue
+	*/
+	unsigned int getDroppedEvents() const;
+
+private:
+	// the preallocated events, and the number of the emitted ones
+	std::vector<PoseEvent> events;
+	int eventCount = 0;
+
+	// the subscribers with their ids
+	std::vector<std::pair<int, Callback>> subscribers;
+	int nextSubscription = 0;
+
+	// while the events are dispatched, the subscribers aren't changed: the new ones wait here, and
+	// the removed ones are only marked with the id -1 (and erased after the dispatch)
+	bool dispatching = false;
+	std::vector<std::pair<int, Callback>> addedSubscribers;
+	bool removedSubscribers = false;
+
+	// the number of the events, that didn't fit into the queue
+	unsigned int droppedEvents = 0;
+
+	/**
+		Take the next free event from the queue
+
+		@return Returns nullptr, if the queue is full
+	*/
+	PoseEvent* emit(const PoseEventType type, const nite::UserId userId, const unsigned long long timestamp);
+
+	/**
+		Copy the name of the pose or the gesture into the event
+	*/
+	static void setName(PoseEvent* event, const std::string& name);
+};
@@ -0,0 +1,119 @@
+#include "PoseModel.h"
+
+PoseModel::PoseModel(const std::vector<KinectPose>& poses, const FeatureProfile featureProfile, const std::string& folder) {
+	for (const KinectPose& pose : poses) {
+		this->poses.push_back(std::make_shared<const KinectPose>(pose));
+	}
+
+	this->featureProfile = featureProfile;
+	this->folder = folder;
+}
+
+std::shared_ptr<const PoseModel> PoseModel::load(const std::string& folder, const FeatureProfile featureProfile, const bool calibrateThresholds) {
+	std::vector<std::string> fileList = get_all_files_names_within_folder(folder);
+	std::vector<KinectPose> poses;
+	int i = 0;
+	for (std::string fileName : fileList) {
+		poses.push_back(KinectPose(i++, fileName));
+		poses.back().calibrateThreshold(calibrateThresholds);
+	}
+
+	if (poses.size() == 0)
+		return nullptr;
+
+	return std::make_shared<PoseModel>(poses, featureProfile, folder);
+}
+
+const std::vector<std::shared_ptr<const KinectPose>>& PoseModel::getPoses() const {
+	return this->poses;
+}
+
+const KinectPose& PoseModel::getPose(const int poseIndex) const {
+	return *this->poses[poseIndex];
+}
+
+int PoseModel::size() const {
+	return (int)this->poses.size();
+}
+
+FeatureProfile PoseModel::getFeatureProfile() const {
+	return this->featureProfile;
+}
+
+const std::string& PoseModel::getFolder() const {
+	return this->folder;
+}
+
+void PoseModel::findSimilarSamples(const EmbeddedFeature& embedded, const double distanceMultiplier, std::vector<EstimationResult>& results) const {
+	switch (featureProfile) {
+	case PROFILE_BELT:
+		findSimilarSamplesWith<ProfilePolicies<PROFILE_BELT>::Metric>(embedded, distanceMultiplier, results);
+		break;
+	case PROFILE_TORSO:
+		findSimilarSamplesWith<ProfilePolicies<PROFILE_TORSO>::Metric>(embedded, distanceMultiplier, results);
+		break;
+	case PROFILE_HEAD:
+	default:
+		findSimilarSamplesWith<ProfilePolicies<PROFILE_HEAD>::Metric>(embedded, distanceMultiplier, results);
+		break;
+	}
+}
+
+template <class Metric>
+void PoseModel::findSimilarSamplesWith(const EmbeddedFeature& embedded, const double distanceMultiplier, std::vector<EstimationResult>& results) const {
+	for (const std::shared_ptr<const KinectPose>& pose : poses) {
+		pose->findSimilarSamples<Metric>(embedded, pose->getDistanceThreshold() * distanceMultiplier, results);
+	}
+}
+
+size_t PoseModel::getMemoryUsage() const {
+	size_t bytes = sizeof(PoseModel) + poses.capacity() * (sizeof(std::shared_ptr<const KinectPose>) + sizeof(KinectPose));
+
+	for (const std::shared_ptr<const KinectPose>& pose : poses) {
+		bytes += pose->getEmbeddedSamples().capacity() * (sizeof(EmbeddedFeature) + sizeof(FeatureString) + sizeof(int) + sizeof(double));
+	}
+
+	return bytes;
+}
+
+std::shared_ptr<const PoseModel> PoseModel::withTrainingSample(const int poseIndex, const FeatureString& featureString, bool& accepted) const {
+	// copies only the pointers to the poses
+	std::shared_ptr<PoseModel> copy = std::make_shared<PoseModel>(*this);
+
+	accepted = false;
+
+	if (poseIndex >= 0 && poseIndex < copy->size()) {
+		std::shared_ptr<KinectPose> pose = std::make_shared<KinectPose>(*poses[poseIndex]);
+		accepted = pose->addNewTrainingSample(featureString);
+
+		copy->poses[poseIndex] = pose;
+	}
+
+	return copy;
+}
+
+std::shared_ptr<const PoseModel> PoseModel::withSampleCapacity(const int capacity, const SampleEviction eviction) const {
+	std::shared_ptr<PoseModel> copy = std::make_shared<PoseModel>(*this);
+
+	for (std::shared_ptr<const KinectPose>& pose : copy->poses) {
+		std::shared_ptr<KinectPose> changed = std::make_shared<KinectPose>(*pose);
+		changed->setCapacity(capacity, eviction);
+
+		pose = changed;
+	}
+
+	return copy;
+}
+
+std::shared_ptr<const PoseModel> PoseModel::withThresholdCalibration(const bool enabled) const {
+	std::shared_ptr<PoseModel> copy = std::make_shared<PoseModel>(*this);
+
+	for (std::shared_ptr<const KinectPose>& pose : copy->poses) {
+		std::shared_ptr<KinectPose> changed = std::make_shared<KinectPose>(*pose);
+		changed->calibrateThreshold(enabled);
+
+		pose = changed;
+	}
+
+	return copy;
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "KinectPose.h"
+#include "FeatureExtractor.h"
+
+#include <memory>
+
+/**
+	The pose data, loaded from the files in a folder: all the poses with their training samples,
+	and how the features are extracted for them.
+
+	The model is immutable once loaded, so a single instance can be shared (as a
+	std::shared_ptr<const PoseModel>) between any number of recognizers on any number of threads.
+	The operations that change the pose data (adding a training sample, calibrating the thresholds)
+	return a modified copy instead, which the recognizer then uses on its own. The poses themselves
+	are immutable and shared between the copies: a copy only duplicates the poses it changes, so
+	adding a training sample copies one pose, not the whole model.
+*/
+class PoseModel {
+
+public:
+	/**
+		Create the model from already loaded poses
+
+		@param poses The poses. The index of every pose must be equal to its position in the vector.
+		@param featureProfile How the features are extracted for these poses
+		@param folder The folder, the poses were loaded from
+	*/
+	PoseModel(const std::vector<KinectPose>& poses, const FeatureProfile featureProfile, const std::string& folder);
+
+	/**
+		Read the position data from the files in the provided folder. Every files has to have
+		the .txt file extension and needs to have the following contents:
+
+		Pose_name
+		Degree_of_freedom
+		Left_elbow_angle,Right_elbow_angle;
+		Left_hand_direction,Right_hand_direction;
+		Left_elbow_position;
+		Left_wrist_position;
+		Right_elbow_position;
+		Right_wrist_position;
+
+		here, "Pose_name" is just the name of the pose, like "Flute", "Violin" or "Conducting"
+		"Degree_of_freedom" is the value that determines how much freedom is given to the recognition
+		algorithm when trying to recognize this particular pose. The bigger the value, the more precise
+		the user needs to be when emulating the pose. Values from 15 to 20 are optimal.
+
+		You can easily add new positions to the system, by adding a new file with only
+		the first two lines present. To record completely new data for existing pose, remove
+		everything except the first two lines.
+
+		@param folder The name of the folder that contains the pose data.
+		@param featureProfile How the training samples in the folder were recorded (see FeatureProfile)
+		@param calibrateThresholds Calibrate the distance thresholds (see KinectPose::calibrateThreshold()). Default: true.
+
+		@return Returns the new model, or nullptr if there are no poses in the folder.
+	*/
+	static std::shared_ptr<const PoseModel> load(const std::string& folder, const FeatureProfile featureProfile, const bool calibrateThresholds = true);
+
+	/**
+		Get all the poses (shared with the copies of the model, see withTrainingSample())
+	*/
+	const std::vector<std::shared_ptr<const KinectPose>>& getPoses() const;
+
+	/**
+		Get the pose by its index
+	*/
+	const KinectPose& getPose(const int poseIndex) const;
+
+	/**
+		Get the number of poses
+	*/
+	int size() const;
+
+	/**
+		Get the feature profile of the poses (see FeatureProfile)
+	*/
+	FeatureProfile getFeatureProfile() const;
+
+	/**
+		Get the folder, the poses were loaded from
+	*/
+	const std::string& getFolder() const;
+
+	/**
+		Find the training samples of all the poses within their distance thresholds, with the metric
+		of the feature profile (see ProfilePolicies and KinectPose::findSimilarSamples())
+
+		@param embedded The embedded feature vector of the current test sample
+		@param distanceMultiplier The thresholds of the poses are multiplied by this value
+		@param results The found samples are added here, as (pose index, distance)
+	*/
+	void findSimilarSamples(const EmbeddedFeature& embedded, const double distanceMultiplier, std::vector<EstimationResult>& results) const;
+
+	/**
+		Get the approximate amount of memory used by the training samples, in bytes. The poses
+		shared with other copies of the model are counted too.
+	*/
+	size_t getMemoryUsage() const;
+
+	/**
+		Make a copy of the model with a new training sample added to one of the poses.
+		The sample is also saved to the file of the pose (see KinectPose::addNewTrainingSample()).
+		Only the changed pose is copied, the other poses are shared with this model.
+
+		@param poseIndex The index of the pose
+		@param featureString The new training sample
+		@param accepted Set to "false", if the pose didn't keep the sample (e.g. a full pose with EVICT_RESERVOIR)
+
+		@return The modified copy of the model
+	*/
+	std::shared_ptr<const PoseModel> withTrainingSample(const int poseIndex, const FeatureString& featureString, bool& accepted) const;
+
+	/**
+		Make a copy of the model with the distance thresholds calibrated or reset (see KinectPose::calibrateThreshold())
+
+		@param enabled Set "true" to calibrate the thresholds
+
+		@return The modified copy of the model
+	*/
+	std::shared_ptr<const PoseModel> withThresholdCalibration(const bool enabled) const;
+
+	/**
+		Make a copy of the model with the number of the training samples of every pose limited (see KinectPose::setCapacity())
+
+		@param capacity The maximum number of the samples of a pose
+		@param eviction How the new samples replace the old ones
+
+		@return The modified copy of the model
+	*/
+	std::shared_ptr<const PoseModel> withSampleCapacity(const int capacity, const SampleEviction eviction) const;
+
+private:
+	// the poses, shared with the copies of the model. Never modified after they're added
+	std::vector<std::shared_ptr<const KinectPose>> poses;
+
+	// how the features are extracted for the poses
+	FeatureProfile featureProfile;
+
+	// the folder with the pose files
+	std::string folder;
+
+	/**
+		Find the similar samples with the specified metric (see findSimilarSamples())
+	*/
+	template <class Metric>
+	void findSimilarSamplesWith(const EmbeddedFeature& embedded, const double distanceMultiplier, std::vector<EstimationResult>& results) const;
+};
@@ -0,0 +1,111 @@
+#include "PoseModelStore.h"
+
+PoseModelStore::PoseModelStore(const bool calibrateThresholds) {
+	this->calibrateThresholds = calibrateThresholds;
+}
+
+std::shared_ptr<PoseModelStore> PoseModelStore::getDefault() {
+	static std::shared_ptr<PoseModelStore> store = std::make_shared<PoseModelStore>();
+
+	return store;
+}
+
+std::shared_ptr<const PoseModel> PoseModelStore::load(const std::string& folder, const FeatureProfile featureProfile) {
+
+	std::string name = normalize(folder);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = models.find(name);
+		if (it != models.end())
+			return it->second;
+	}
+
+	// read the files without holding the lock, so the lookups of the other threads don't wait
+	std::shared_ptr<const PoseModel> model = PoseModel::load(folder, featureProfile, calibrateThresholds);
+
+	if (!model) {
+		std::cerr << "No poses in the folder " << folder << std::endl;
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// somebody else may have loaded the same library meanwhile, then his copy is kept
+	return models.insert(std::make_pair(name, model)).first->second;
+}
+
+int PoseModelStore::loadAll(const std::vector<std::pair<std::string, FeatureProfile>>& libraries) {
+
+	int loaded = 0;
+
+	for (const std::pair<std::string, FeatureProfile>& library : libraries) {
+		if (load(library.first, library.second))
+			loaded++;
+	}
+
+	return loaded;
+}
+
+std::shared_ptr<const PoseModel> PoseModelStore::get(const std::string& folder) const {
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = models.find(normalize(folder));
+
+	return (it != models.end()) ? it->second : nullptr;
+}
+
+void PoseModelStore::replace(const std::string& folder, const std::shared_ptr<const PoseModel>& model) {
+
+	if (!model)
+		return;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	models[normalize(folder)] = model;
+}
+
+std::vector<std::string> PoseModelStore::getLibraries() const {
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::vector<std::string> result;
+
+	for (const auto& entry : models) {
+		result.push_back(entry.first);
+	}
+
+	return result;
+}
+
+bool PoseModelStore::getThresholdCalibration() const {
+	return this->calibrateThresholds;
+}
+
+size_t PoseModelStore::getMemoryUsage() const {
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	size_t bytes = 0;
+
+	for (const auto& entry : models) {
+		bytes += entry.second->getMemoryUsage();
+	}
+
+	return bytes;
+}
+
+std::string PoseModelStore::normalize(const std::string& folder) {
+
+	std::string name = folder;
+
+	while (name.size() >= 2 && name[0] == '.' && (name[1] == '/' || name[1] == '\\'))
+		name = name.substr(2);
+
+	while (!name.empty() && (name.back() == '/' || name.back() == '\\'))
+		name.pop_back();
+
+	return name;
+}
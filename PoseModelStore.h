@@ -0,0 +1,102 @@
+#pragma once
+
+#include "PoseModel.h"
+
+#include <map>
+#include <mutex>
+
+/**
+	All the pose libraries (e.g. "poses", "poses_belt_level", "poses_from_head"), loaded once and
+	kept in memory for the whole run. Every library is loaded only once, however many times and
+	under whichever spelling of the folder ("./poses", "poses/") it's requested, and the same
+	immutable model is handed out to every recognizer.
+
+	Switching the library of a recognizer (see PoseRecognizer::selectPoseModel()) or of a single user
+	(see PoseRecognizer::selectUserPoseModel()) is then just a swap of the shared pointer, without
+	reading any files. The store can be used from any thread.
+*/
+class PoseModelStore {
+
+public:
+	/**
+		Create an empty store
+
+		@param calibrateThresholds Calibrate the distance thresholds of the loaded poses (see PoseModel::load()). Default: true.
+	*/
+	PoseModelStore(const bool calibrateThresholds = true);
+
+	/**
+		Get the store, shared by all the recognizers of the process, unless they're given another one
+		(see PoseRecognizer::setPoseModelStore())
+	*/
+	static std::shared_ptr<PoseModelStore> getDefault();
+
+	/**
+		Get the library from the store, loading it from the folder if it wasn't loaded yet
+
+		@param folder The name of the folder that contains the pose data
+		@param featureProfile How the training samples of the library were recorded (see FeatureProfile).
+		Used only when the library is loaded, an already loaded library keeps its profile. Default: PROFILE_HEAD.
+
+		@return Returns the model, or nullptr if there are no poses in the folder.
+	*/
+	std::shared_ptr<const PoseModel> load(const std::string& folder, const FeatureProfile featureProfile = PROFILE_HEAD);
+
+	/**
+		Load several libraries at once, e.g. all of them at the start
+
+		@param libraries The names of the folders, with the feature profiles of the libraries
+
+		@return The number of the libraries, that were loaded (or were already in the store)
+	*/
+	int loadAll(const std::vector<std::pair<std::string, FeatureProfile>>& libraries);
+
+	/**
+		Get an already loaded library. Never reads any files.
+
+		@param folder The name of the folder, the library was loaded from
+
+		@return Returns the model, or nullptr if the library is not in the store.
+	*/
+	std::shared_ptr<const PoseModel> get(const std::string& folder) const;
+
+	/**
+		Replace a library with its new version, e.g. with a copy with a new training sample, so the
+		library keeps the change when it's selected again. The recognizers, that already use the
+		old version, keep it until they switch the library.
+
+		@param folder The name of the folder, the library was loaded from
+		@param model The new version of the library
+	*/
+	void replace(const std::string& folder, const std::shared_ptr<const PoseModel>& model);
+
+	/**
+		Get the names of all the loaded libraries
+	*/
+	std::vector<std::string> getLibraries() const;
+
+	/**
+		Check if the thresholds of the loaded poses are calibrated
+	*/
+	bool getThresholdCalibration() const;
+
+	/**
+		Get the approximate amount of memory used by all the libraries, in bytes
+	*/
+	size_t getMemoryUsage() const;
+
+	/**
+		Get the name of the library from the folder: without the leading "./" and the trailing slashes
+	*/
+	static std::string normalize(const std::string& folder);
+
+private:
+	// the libraries by their normalized names
+	std::map<std::string, std::shared_ptr<const PoseModel>> models;
+
+	// calibrate the thresholds of the loaded poses?
+	bool calibrateThresholds;
+
+	// guards the map. The files are read outside of the lock
+	mutable std::mutex mutex;
+};
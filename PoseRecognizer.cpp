@@ -1,41 +1,6 @@
 #include "PoseRecognizer.h"
 
-std::vector<KinectPose> PoseRecognizer::initPoseData(const std::string path) {
-	std::vector<std::string> fileList = get_all_files_names_within_folder(path);
-	std::vector<KinectPose> poseVector;
-	int i = 0;
-	for (std::string fileName : fileList) {
-		poseVector.push_back(KinectPose(i++, fileName));
-	}
-	return poseVector;
-}
-
-std::vector<std::string> PoseRecognizer::get_all_files_names_within_folder(std::string folder) {
-	std::vector<std::string> names;
-	std::string s = folder + "/*.txt";
-	std::wstring search_path = std::wstring(s.begin(), s.end());
-
-	WIN32_FIND_DATA fd;
-	HANDLE hFind = ::FindFirstFile(search_path.c_str(), &fd);
-	if (hFind != INVALID_HANDLE_VALUE) {
-		do {
-			if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-
-				std::string fullPath = folder + "/";
-
-				std::wstring fname(std::wstring(fullPath.begin(), fullPath.end()) + fd.cFileName);
-
-				fullPath = std::string(fname.begin(), fname.end());
-
-				names.push_back(fullPath);
-			}
-		} while (::FindNextFile(hFind, &fd));
-		::FindClose(hFind);
-	}
-	return names;
-}
-
-void PoseRecognizer::updateUserState(const nite::UserData & user, unsigned long long ts) {
+void PoseRecognizer::updateUserState(const SkeletonUser & user, unsigned long long ts) {
 	if (user.isNew())
 		USER_MESSAGE("New")
 	else if (user.isVisible() && !g_visibleUsers[user.getId()])
@@ -47,8 +12,8 @@ void PoseRecognizer::updateUserState(const nite::UserData & user, unsigned long
 
 		g_visibleUsers[user.getId()] = user.isVisible();
 
-	if (g_skeletonStates[user.getId()] != user.getSkeleton().getState()) {
-		switch (g_skeletonStates[user.getId()] = user.getSkeleton().getState()) {
+	if (g_skeletonStates[user.getId()] != user.skeletonState) {
+		switch (g_skeletonStates[user.getId()] = user.skeletonState) {
 		case nite::SKELETON_NONE:
 			USER_MESSAGE("Stopped tracking.")
 				break;
@@ -69,74 +34,132 @@ void PoseRecognizer::updateUserState(const nite::UserData & user, unsigned long
 	}
 }
 
-void PoseRecognizer::fillUserList(const nite::Array<nite::UserData>& users) {
+void PoseRecognizer::fillUserList(const SkeletonFrame& frame) {
+
+	for (const SkeletonUser& user : frame.users) {
 
-	for (int u = 0; u < users.getSize(); ++u) {
-		const nite::UserData& user = users[u];
-		const nite::Skeleton& rSkeleton = user.getSkeleton();
+		if (!userList.isValidId(user.getId())) {
+			if (user.isNew())
+				std::cerr << "User id " << user.getId() << " exceeds the maximum number of users" << std::endl;
+			continue;
+		}
 
 		if (displayDebug)
-			updateUserState(user, userTrackerFrame.getTimestamp());
+			updateUserState(user, frame.timestamp);
+
+		// if it's an already existing user, find him in the list
+		KinectUser* existingUser = userList.find(user.getId());
 
-		if (user.isNew()) {			// if this is a new user, add him to the list
-			userTracker.startSkeletonTracking(user.getId());
+		if (user.isNew() || (existingUser == nullptr && !user.isLost())) {		// if this is a new user, add him to the list
+			// (a replayed session may also start in the middle, after the user was already new)
+			if (user.isNew() && liveMode)
+				userTracker.startSkeletonTracking(user.getId());
 
-			KinectUser kinectUser(user.getId());
-			kinectUser.setSkeleton(&rSkeleton);
-			kinectUser.setUserTracker(&userTracker);
-			kinectUser.setUserData(user);
-			kinectUser.setTrackerFrameRef(&userTrackerFrame);
+			if (existingUser == nullptr) {
+				existingUser = userList.insert(user.getId(), KinectUser(user.getId()));
+				existingUser->setJointSnapshot(&jointSnapshot, user.getId());
+				gestureRecognizer.reset(user.getId());
+				classificationScheduler.reset(user.getId());
+
+				if (poseEvents.hasSubscribers())
+					poseEvents.userAppeared(user.getId(), frame.timestamp);
+			}
 
-			userList.push_back(kinectUser);
+			existingUser->setSkeletonState(user.skeletonState);
+
+			jointSnapshot.capture(user.getId(), user.positions, user.confidences);
 		}
-		else {
-			// if it's an already existing user, find him in the list
-			auto existingUser = std::find_if(userList.begin(), userList.end(), [&user](KinectUser& u) { return u.getUserId() == user.getId(); });
-
-			// it is really in the list
-			if (existingUser != userList.end()) {
-				if (user.isLost()) {		// if he's lost (no longer visible), remove him
-					userList.erase(existingUser);
-				}
-				else {		// update the user's skeleton data
-					(*existingUser).setUserData(user);
-					(*existingUser).setSkeleton(&rSkeleton);
-				}
+		else if (existingUser != nullptr) {		// it is really in the list
+			if (user.isLost()) {		// if he's lost (no longer visible), remove him
+				removeUser(user.getId(), frame.timestamp);
+			}
+			else {		// update the user's skeleton data
+				existingUser->setSkeletonState(user.skeletonState);
+				jointSnapshot.capture(user.getId(), user.positions, user.confidences);
 			}
 		}
 	}
 }
 
-int PoseRecognizer::estimatePose(KinectUser & user, const FeatureString & featureString, const int nearestNeighbours) {
+void PoseRecognizer::removeMissingUsers(const SkeletonFrame& frame) {
 
-	int poseIndex = -1;
+	std::vector<nite::UserId> missing;
 
-	double distanceToUser = user.extractJoint3D(nite::JOINT_TORSO).z / 1000;	// distance to user in meters
+	userList.forEach([&frame, &missing](KinectUser& user) {
+		if (frame.findUser(user.getUserId()) == nullptr)
+			missing.push_back(user.getUserId());
+	});
+
+	for (nite::UserId userId : missing) {
+		removeUser(userId, frame.timestamp);
+	}
+}
+
+void PoseRecognizer::removeUser(const nite::UserId userId, const unsigned long long timestamp) {
 
-	double distanceMultiplier = 1.0;
+	KinectUser* user = userList.find(userId);
+
+	if (user == nullptr)
+		return;
 
-	if (distanceToUser > 2.0) { 
-		distanceMultiplier += (distanceToUser - 2.0) / 2;
+	if (poseEvents.hasSubscribers()) {
+		if (user->getPoseIndex() >= 0)
+			poseEvents.poseLeft(userId, user->getPoseIndex(), user->getPoseName(), timestamp);
+
+		poseEvents.userLost(userId, timestamp);
 	}
 
+	userList.erase(userId);
+	jointSnapshot.clear(userId);
+	gestureRecognizer.reset(userId);
+	classificationScheduler.reset(userId);
+	userPoseModels[userId].reset();
+}
+
+int PoseRecognizer::estimatePose(KinectUser & user, const PoseModel & model, const FeatureString & featureString) {
+
+	int poseIndex = -1;
+
+	const int nearestNeighbours = params.nearestNeighbours;
+
+	double distanceToUser = user.extractJoint3D(nite::JOINT_TORSO).z / 1000;	// distance to user in meters
+
+	// the further the user, the less precise the joints, so the thresholds grow
+	double distanceMultiplier = params.getThresholdMultiplier(distanceToUser);
+
 	std::vector<EstimationResult> estimationResults;
-	
-	// calculate the difference between extracted features and training samples
-	for (KinectPose pose : poseVector) {
-		std::vector<double> likelihoods = pose.estimateLikelihood(featureString);
 
-		for (double x : likelihoods) {
-			if (x <= (pose.getReferenceEstimate() * distanceMultiplier) )
-				estimationResults.push_back(EstimationResult(pose.getPoseIndex(), x));
+	const DistanceTable::Entry* precomputed = (distanceTable && !recordDistances) ? distanceTable->find(frameNumber, user.getUserId()) : nullptr;
+
+	if (precomputed != nullptr) {
+		// the table is already sorted, and has the samples within wider thresholds
+		for (const EstimationResult& estimation : precomputed->samples) {
+			if (estimation.distance <= model.getPose(estimation.index).getDistanceThreshold() * distanceMultiplier)
+				estimationResults.push_back(estimation);
 		}
+
+		distanceTableTime += precomputed->duration;
 	}
+	else {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-	// sort the distance vector
-	std::sort(std::begin(estimationResults), std::end(estimationResults), [](EstimationResult a, EstimationResult b) { 
-		return a.distance < b.distance; 
-	});
+		// embed the features once for all the poses
+		EmbeddedFeature embedded = embedFeatures(featureString);
+
+		// find the training samples within the threshold of every pose (skipping the poses and
+		// the samples, that are obviously too far, see KinectPose::findSimilarSamples())
+		model.findSimilarSamples(embedded, distanceMultiplier, estimationResults);
 
-	std::vector<int> neigbours(poseVector.size());
+		// sort the distance vector
+		std::sort(std::begin(estimationResults), std::end(estimationResults), [](EstimationResult a, EstimationResult b) { 
+			return a.distance < b.distance; 
+		});
+
+		if (distanceTable && recordDistances)
+			distanceTable->add(frameNumber, user.getUserId(), estimationResults, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	std::vector<int> neigbours(model.size());
 
 	// get the first N estimations and fill a "histogram" with them
 	if (estimationResults.size() >= nearestNeighbours) {
@@ -151,14 +174,27 @@ int PoseRecognizer::estimatePose(KinectUser & user, const FeatureString & featur
 	// the index of the most likely pose
 	int result = neigbours[minResultIndex];
 
+	// how far inside the threshold is the nearest sample of the most likely pose
+	double margin = 0;
+
+	for (const EstimationResult& estimation : estimationResults) {
+		if (estimation.index == minResultIndex) {
+			margin = 1.0 - estimation.distance / (model.getPose(minResultIndex).getDistanceThreshold() * distanceMultiplier);
+			break;
+		}
+	}
+
+	// the hold has to be an odd number of estimations, so the tumbler has a middle
+	const int holdLength = (params.poseHold % 2) ? params.poseHold : params.poseHold + 1;
+
+	// the pose voted for in this frame
+	const int candidate = (result > (nearestNeighbours-1) && estimationResults.size() >= nearestNeighbours) ? minResultIndex : -1;
+
 	// check for how long the pose is held before recognizing it
-	if (result > (nearestNeighbours-1) && estimationResults.size() >= nearestNeighbours)
-		user.addPoseTumbler(minResultIndex);
-	else
-		user.addPoseTumbler(-1);
+	user.addPoseTumbler(candidate, holdLength);
 
-	// now check if this pose is held for at least 3 consecuitive instances
-	if (user.getPoseTumbler().size() == (HOLD_POSE % 2) ? HOLD_POSE : HOLD_POSE + 1) {
+	// now check if this pose is held for at least holdLength consecuitive instances
+	if (user.getPoseTumbler().size() == holdLength) {
 
 		int mid = (0 + user.getPoseTumbler().size()) / 2;
 
@@ -166,84 +202,215 @@ int PoseRecognizer::estimatePose(KinectUser & user, const FeatureString & featur
 
 			poseIndex = user.getPoseTumbler()[mid];
 
-			user.setPoseName( (poseIndex >= 0) ? poseVector[poseIndex].getPoseName() : "" );
+			user.setPoseName( (poseIndex >= 0) ? model.getPose(poseIndex).getPoseName() : "" );
 			user.setPoseIndex( poseIndex );
+			user.setPoseMargin( (poseIndex >= 0) ? margin : 0 );
+		}
+	}
+
+	if (recognitionLog.isOpen()) {
+		// filled in place; if the writer thread is behind, the record is dropped
+		RecognitionRecord* record = recognitionLog.beginRecord();
+
+		if (record != nullptr) {
+			record->frameNumber = frameNumber;
+			record->timestamp = frameTimestamp;
+			record->userId = user.getUserId();
+			record->candidate = candidate;
+			record->decision = user.getPoseIndex();
+			record->sampleCount = (int)estimationResults.size();
+			record->margin = (candidate >= 0) ? (float)margin : 0;
+			record->thresholdMultiplier = (float)distanceMultiplier;
+
+			record->topCount = (int)(std::min)(estimationResults.size(), (size_t)RECOGNITION_LOG_TOP_K);
+
+			for (int i = 0; i < record->topCount; i++) {
+				record->topPoses[i] = estimationResults[i].index;
+				record->topDistances[i] = (float)estimationResults[i].distance;
+			}
+
+			for (int i = 0; i < FeatureSchema::size; i++) {
+				record->features[i][0] = featureString[i].x;
+				record->features[i][1] = featureString[i].y;
+			}
+
+			recognitionLog.commitRecord();
 		}
 	}
 
 	return poseIndex;
 }
 
-void PoseRecognizer::drawInstrument(KinectUser & user, cv::Mat& image) {
+void PoseRecognizer::classifyUser(KinectUser& user, const PoseModel& model, const FeatureString& featureString, const unsigned long long timestamp, std::vector<KinectUser*>& recognitionResult) {
 
-	if (user.getPoseIndex() < 0 || user.getPoseName() == "")
-		return;
+	int previousPose = user.getPoseIndex();
 
-	std::string fileName = "./instruments/" + user.getPoseName() + ".png";
+	if (estimatePose(user, model, featureString) >= 0) {
+		recognitionResult.push_back(&user);
+	}
+
+	// the decision has changed
+	if (user.getPoseIndex() != previousPose && poseEvents.hasSubscribers()) {
+		if (previousPose >= 0)
+			poseEvents.poseLeft(user.getUserId(), previousPose, model.getPose(previousPose).getPoseName(), timestamp);
 
-	cv::Mat instrument = cv::imread(fileName, cv::IMREAD_UNCHANGED);
+		if (user.getPoseIndex() >= 0)
+			poseEvents.poseEntered(user.getUserId(), user.getPoseIndex(), user.getPoseName(), timestamp, user.getPoseMargin());
+	}
+}
 
-	cv::Point2f pt1 = user.extractJoint2D(nite::JOINT_LEFT_HAND);
-	cv::Point2f pt2 = user.extractJoint2D(nite::JOINT_RIGHT_HAND);
+void PoseRecognizer::trackGestures(KinectUser& user, const FeatureString& featureString, const unsigned long long timestamp) {
 
-	double handDist = calcDistance(pt1, pt2);
-	
-	cv::Point location = pt1;
+	if (recordingGesture && !featureString.isEmpty()) {
+		if (gestureUser < 0)
+			gestureUser = user.getUserId();
 
-	// make some adjustments so the pictures look nice-ish.
-	// flute
-	if (user.getPoseIndex() == 0) { 
-		location.x -= instrument.cols / 4;
-		location.y -= instrument.rows / 2;
+		if (user.getUserId() == gestureUser && recordedGesture.size() < GESTURE_HISTORY)
+			recordedGesture.push_back(featureString);
 	}
 
-	// clarinet
-	if (user.getPoseIndex() == 1) { 
-		location.y -= instrument.rows / 4;
-	}
+	if (!gestureRecognizer.hasGestures())
+		return;
 
-	// violin
-	if (user.getPoseIndex() == 2) {
-		//location.y -= instrument.rows / 3;
-	}
+	gestureMatches.clear();
+
+	if (gestureRecognizer.update(user.getUserId(), featureString, gestureMatches) == 0)
+		return;
 
-	// cello
-	if (user.getPoseIndex() == 3) {
-		location.x -= instrument.cols / 2;
-		location.y -= instrument.rows / 5;
+	for (const GestureMatch& match : gestureMatches) {
+		const std::string& name = gestureRecognizer.getGestures()[match.gestureIndex].getName();
+
+		if (displayDebug)
+			std::cout << "User #" << user.getUserId() << ":\t" << name << std::endl;
+
+		if (poseEvents.hasSubscribers())
+			poseEvents.gesturePerformed(user.getUserId(), match.gestureIndex, name, timestamp, match.margin);
 	}
+}
+
+void PoseRecognizer::switchPoseModels(const unsigned long long timestamp) {
+
+	if (poseModelPending.exchange(false)) {
+		std::shared_ptr<const PoseModel> model = std::atomic_load(&pendingPoseModel);
 
-	// trombone
-	if (user.getPoseIndex() == 4) {
-		location.y -= instrument.rows / 2;
+		if (model && model != poseModel) {
+			// the poses of the users, that follow the library of the recognizer, mean something else now
+			userList.forEach([&](KinectUser& user) {
+				if (!userPoseModels[user.getUserId()])
+					resetUserPose(user, timestamp);
+			});
+
+			poseModel = model;
+			currentPoseNumber = (std::min)(currentPoseNumber, poseModel->size() - 1);
+		}
 	}
 
-	// conductor
-	if (user.getPoseIndex() == 6) {
-		location.y -= instrument.rows;
-		location.x -= instrument.cols;
+	for (int i = 0; i < USER_SLOTS; i++) {
+		if (!userPoseModelPending[i].load(std::memory_order_relaxed) || !userPoseModelPending[i].exchange(false))
+			continue;
+
+		std::shared_ptr<const PoseModel> model = std::atomic_load(&pendingUserPoseModels[i]);
+
+		KinectUser* user = userList.find(i);
+
+		if (user != nullptr && (model ? model : poseModel) != getUserPoseModel(*user))
+			resetUserPose(*user, timestamp);
+
+		userPoseModels[i] = model;
 	}
+}
 
-	// drums
-	if (user.getPoseIndex() == 5) {
-		location.y -= instrument.rows / 3;
-		location.x -= (instrument.cols - handDist) / 2;
+void PoseRecognizer::resetUserPose(KinectUser& user, const unsigned long long timestamp) {
+
+	if (user.getPoseIndex() >= 0 && poseEvents.hasSubscribers())
+		poseEvents.poseLeft(user.getUserId(), user.getPoseIndex(), user.getPoseName(), timestamp);
+
+	user.resetPose();
+}
+
+std::shared_ptr<const PoseModel>& PoseRecognizer::getUserPoseModel(KinectUser& user) {
+	std::shared_ptr<const PoseModel>& userModel = userPoseModels[user.getUserId()];
+
+	return userModel ? userModel : poseModel;
+}
+
+std::shared_ptr<const PoseModel> PoseRecognizer::loadPoseModel(const std::string& folder, const FeatureProfile featureProfile) {
+
+	std::shared_ptr<const PoseModel> stored = poseModelStore->load(folder, featureProfile);
+
+	if (!stored)
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(adjustedPoseModelsMutex);
+
+	// the adjustment goes through all the samples, so it's done only once per version of the library
+	std::pair<std::shared_ptr<const PoseModel>, std::shared_ptr<const PoseModel>>& adjusted = adjustedPoseModels[PoseModelStore::normalize(folder)];
+
+	if (adjusted.first == stored)
+		return adjusted.second;
+
+	std::shared_ptr<const PoseModel> model = stored;
+
+	// the libraries in the store may be calibrated differently, than this recognizer wants
+	if (poseModelStore->getThresholdCalibration() != calibrateThresholds)
+		model = model->withThresholdCalibration(calibrateThresholds);
+
+	if (sampleCapacity != POSE_MAX_SAMPLES || sampleEviction != EVICT_REDUNDANT)
+		model = model->withSampleCapacity(sampleCapacity, sampleEviction);
+
+	adjusted = std::make_pair(stored, model);
+
+	return model;
+}
+
+bool PoseRecognizer::addTrainingSample(std::shared_ptr<const PoseModel>& model, const int poseIndex, const FeatureString& featureString) {
+
+	std::shared_ptr<const PoseModel> stored = poseModelStore->get(model->getFolder());
+
+	// the model may be shared, so the sample is added to a copy. The copy is kept even if the sample
+	// was thrown away, it has counted the sample (see EVICT_RESERVOIR)
+	bool accepted;
+	std::shared_ptr<const PoseModel> trained = model->withTrainingSample(poseIndex, featureString, accepted);
+
+	// the library in the store is either the same, or differs only in the calibration and the capacity
+	bool storeAccepted;
+
+	if (stored == model)
+		stored = trained;
+	else if (stored)
+		stored = stored->withTrainingSample(poseIndex, featureString, storeAccepted);
+
+	if (stored) {
+		poseModelStore->replace(model->getFolder(), stored);
+
+		std::lock_guard<std::mutex> lock(adjustedPoseModelsMutex);
+		adjustedPoseModels[PoseModelStore::normalize(model->getFolder())] = std::make_pair(stored, trained);
 	}
 
-	overlayImage(image, instrument, location);
+	model = trained;
+
+	return accepted;
 }
 
-PoseRecognizer::PoseRecognizer() {
+PoseRecognizer::PoseRecognizer() : capturing(false), failedCaptures(0), poseModelPending(false) {
+	poseModelStore = PoseModelStore::getDefault();
+
+	for (int i = 0; i < USER_SLOTS; i++) {
+		userPoseModelPending[i] = false;
+	}
 }
 
-bool PoseRecognizer::initialize() {
+bool PoseRecognizer::initialize(const int deviceIndex) {
+
+	// the capture thread can't grab from the old device
+	stopCapture();
 
 	// close the previous open cv capture, if necessary
 	if (cap.isOpened())
 		cap.release();
 
 	// open new video capture from Kinect
-	cap = cv::VideoCapture(CV_CAP_OPENNI2);
+	cap = cv::VideoCapture(CV_CAP_OPENNI2 + deviceIndex);
 
 	if (!cap.isOpened()) {
 		std::cerr << "Error while opening the capture device!" << std::endl;
@@ -254,35 +421,139 @@ bool PoseRecognizer::initialize() {
 	// we should shift them so they show roughly the same viewpoint
 	cap.set(CV_CAP_PROP_OPENNI_REGISTRATION, 1);
 
-	// init NiTE
-	niteRc = nite::NiTE::initialize();
+	// init NiTE (once per process, shared with the other recognizers)
+	if (!niteAcquired) {
+		if (!NiteRuntime::acquire()) {
+			std::cerr << "Couldn't initialize" << std::endl;
+			return false;
+		}
 
-	if (niteRc != nite::STATUS_OK) {
-		std::cerr << "Couldn't initialize" << std::endl;
+		niteAcquired = true;
+	}
+
+	// open the same device for the NiTE
+	openni::Array<openni::DeviceInfo> devices;
+	openni::OpenNI::enumerateDevices(&devices);
+
+	if (deviceIndex < 0 || deviceIndex >= devices.getSize() || device.open(devices[deviceIndex].getUri()) != openni::STATUS_OK) {
+		std::cerr << "Couldn't open the device #" << deviceIndex << std::endl;
 		return false;
 	}
 	
 	// create a nite::UserTracker
-	niteRc = userTracker.create();
+	niteRc = userTracker.create(&device);
 
 	if (niteRc != nite::STATUS_OK) {
 		std::cerr << "Couldn't create user tracker" << std::endl;
 		return false;
 	}
 
-	// read the pose data from the files
-	poseVector = initPoseData("./poses");
-	if (poseVector.size() == 0) { 
+	// capture the parameters of the depth camera, to project the joints without NiTE
+	if (!depthProjection.calibrate(userTracker)) {
+		std::cerr << "Couldn't capture the depth projection, using the default one" << std::endl;
+	}
+
+	// load all the pose libraries once, so switching between them doesn't read any files
+	poseModelStore->loadAll({ { "./poses", PROFILE_HEAD }, { "./poses_belt_level", PROFILE_BELT }, { "./poses_from_head", PROFILE_HEAD } });
+
+	// use the selected library, or the default one, unless it's shared
+	switchPoseModels(0);
+
+	if (!poseModel)
+		poseModel = loadPoseModel("./poses");
+
+	if (!poseModel) { 
 		std::cerr << "Failed to load the pose data!" << std::endl;
 		return false;
 	}
+
+	// the gestures are optional
+	if (!gestureRecognizer.hasGestures())
+		gestureRecognizer.loadGestures("./gestures");
+
+	return true;
 }
 
-bool PoseRecognizer::reloadPoseData(const std::string folder) {
+bool PoseRecognizer::reloadPoseData(const std::string folder, const FeatureProfile featureProfile) {
+
+	std::shared_ptr<const PoseModel> model = loadPoseModel(folder, featureProfile);
+
+	if (!model)
+		return false;
+
+	selectPoseModel(model);
+
+	return true;
+}
+
+void PoseRecognizer::setPoseModelStore(const std::shared_ptr<PoseModelStore>& store) {
+	if (store)
+		this->poseModelStore = store;
+}
+
+std::shared_ptr<PoseModelStore> PoseRecognizer::getPoseModelStore() const {
+	return this->poseModelStore;
+}
+
+void PoseRecognizer::selectPoseModel(const std::shared_ptr<const PoseModel>& poseModel) {
+	std::atomic_store(&pendingPoseModel, poseModel);
+	poseModelPending = true;
+}
+
+void PoseRecognizer::selectUserPoseModel(const nite::UserId userId, const std::shared_ptr<const PoseModel>& poseModel) {
+
+	if (!userList.isValidId(userId))
+		return;
+
+	std::atomic_store(&pendingUserPoseModels[userId], poseModel);
+	userPoseModelPending[userId] = true;
+}
+
+bool PoseRecognizer::loadGestures(const std::string folder) {
+	return gestureRecognizer.loadGestures(folder);
+}
+
+void PoseRecognizer::startGestureRecording() {
+	recordedGesture.clear();
+	gestureUser = -1;
+	recordingGesture = true;
+}
+
+bool PoseRecognizer::stopGestureRecording(const std::string& name, const std::string& fileName, const double threshold) {
+
+	recordingGesture = false;
+
+	if (recordedGesture.empty()) {
+		std::cerr << "No frames were recorded for the gesture " << name << std::endl;
+		return false;
+	}
+
+	// create the folder of the gesture, if it doesn't exist yet
+	const size_t separator = fileName.find_last_of("/\\");
+
+	if (separator != std::string::npos && separator > 0) {
+		const std::string folder = fileName.substr(0, separator);
 
-	poseVector = this->initPoseData(folder);
+		if (!CreateDirectoryA(folder.c_str(), NULL) && GetLastError() != ERROR_ALREADY_EXISTS) {
+			std::cerr << "Couldn't create the gesture folder " << folder << std::endl;
+			return false;
+		}
+	}
+
+	GestureTemplate gesture(name, threshold, recordedGesture);
+
+	if (!gesture.save(fileName))
+		return false;
+
+	return gestureRecognizer.addGesture(gesture) >= 0;
+}
 
-	return (poseVector.size() > 0);
+void PoseRecognizer::setPoseModel(const std::shared_ptr<const PoseModel>& poseModel) {
+	this->poseModel = poseModel;
+}
+
+std::shared_ptr<const PoseModel> PoseRecognizer::getPoseModel() const {
+	return this->poseModel;
 }
 
 void PoseRecognizer::displayDebugInformation(bool flag) {
@@ -291,7 +562,15 @@ void PoseRecognizer::displayDebugInformation(bool flag) {
 
 void PoseRecognizer::start() {
 
-	skipFrames = true;
+	// spread the pose estimations over the frames, every user at least every FRAME_SKIP frames,
+	// unless another frame skip or schedule was set
+	bool ownSchedule = (params.frameSkip <= 1) && !scheduleClassification;
+
+	if (ownSchedule)
+		setClassificationSchedule(true, SCHEDULER_FRAME_BUDGET, FRAME_SKIP);
+
+	// keep only the newest frame, so the shown frames don't lag behind, when the display is slow
+	bool ownCapture = !isCapturing() && !isReplaying() && startCapture(BACKPRESSURE_LATEST_WINS);
 
 	std::thread mainThread([&] {
 
@@ -302,16 +581,46 @@ void PoseRecognizer::start() {
 				break;
 			else if (ch == KEY_PGDN) {
 				declim(currentPoseNumber, 0);
-				std::cout << "Learning pose: " << poseVector[currentPoseNumber].getPoseName() << std::endl;
+				std::cout << "Learning pose: " << poseModel->getPose(currentPoseNumber).getPoseName() << std::endl;
 			}
 			else if (ch == KEY_PGUP) {
-				inclim(currentPoseNumber, poseVector.size() - 1);
-				std::cout << "Learning pose: " << poseVector[currentPoseNumber].getPoseName() << std::endl;
+				inclim(currentPoseNumber, poseModel->size() - 1);
+				std::cout << "Learning pose: " << poseModel->getPose(currentPoseNumber).getPoseName() << std::endl;
 			}
 			else if (ch == KEY_TRAIN) {
 				rememberPose = true;
 				frameSkip = -1;
 			}
+			else if (ch == KEY_LIBRARY) {
+				std::vector<std::string> libraries = poseModelStore->getLibraries();
+
+				// find the current library by its folder (the model may be a modified copy), and take the next one
+				const std::string currentName = poseModel ? PoseModelStore::normalize(poseModel->getFolder()) : "";
+
+				int current = -1;
+				for (int i = 0; i < (int)libraries.size(); i++) {
+					if (libraries[i] == currentName)
+						current = i;
+				}
+
+				if (!libraries.empty()) {
+					const std::string& next = libraries[(current + 1) % libraries.size()];
+					selectPoseModel(loadPoseModel(next));
+					std::cout << "Pose library: " << next << std::endl;
+				}
+			}
+			else if (ch == KEY_GESTURE) {
+				if (!recordingGesture) {
+					startGestureRecording();
+					std::cout << "Recording a new gesture..." << std::endl;
+				}
+				else {
+					int number = (int)gestureRecognizer.getGestures().size() + 1;
+
+					if (stopGestureRecording("Gesture " + std::to_string(number), "./gestures/gesture" + std::to_string(number) + ".txt"))
+						std::cout << "New gesture added: " << recordedGesture.size() << " frames" << std::endl;
+				}
+			}
 
 			processNextFrame();
 
@@ -321,26 +630,130 @@ void PoseRecognizer::start() {
 
 	mainThread.join();
 
-	skipFrames = false;
+	if (ownCapture)
+		stopCapture();
+
+	if (ownSchedule)
+		setClassificationSchedule(false);
 
 }
 
+void PoseRecognizer::setSampleCapacity(const int capacity, const SampleEviction eviction) {
+	this->sampleCapacity = (std::max)(1, capacity);
+	this->sampleEviction = eviction;
+
+	// the adjusted libraries have the old capacity
+	{
+		std::lock_guard<std::mutex> lock(adjustedPoseModelsMutex);
+		adjustedPoseModels.clear();
+	}
+
+	// the model may be shared, so limit a copy
+	if (poseModel)
+		poseModel = poseModel->withSampleCapacity(sampleCapacity, sampleEviction);
+}
+
+void PoseRecognizer::setJointSmoothing(const bool flag) {
+	this->smoothJoints = flag;
+
+	if (!flag)
+		jointFilter.reset();
+}
+
+JointFilter& PoseRecognizer::getJointFilter() {
+	return this->jointFilter;
+}
+
+void PoseRecognizer::setJointPrediction(const bool flag, const double displayLatency) {
+	this->predictJoints = flag;
+	this->displayLatency = displayLatency / 1000.0;
+
+	if (!flag) {
+		jointPredictor.reset();
+		predictionLatency = 0;
+	}
+}
+
+double PoseRecognizer::getPredictionLatency() const {
+	return this->predictionLatency * 1000.0;
+}
+
+void PoseRecognizer::setPoseHold(const int estimations) {
+	this->params.poseHold = (std::max)(1, estimations);
+}
+
 void PoseRecognizer::setNearestNeighbours(const int nNeighbours) {
-	this->nearestNeighbours = nNeighbours;
+	this->params.nearestNeighbours = (std::max)(1, nNeighbours);
+}
+
+void PoseRecognizer::setParams(const RecognizerParams& params) {
+	this->params = params;
+
+	this->params.nearestNeighbours = (std::max)(1, params.nearestNeighbours);
+	this->params.poseHold = (std::max)(1, params.poseHold);
+	this->params.frameSkip = (std::max)(1, params.frameSkip);
+	this->params.distanceSlope = (std::max)(0.0, params.distanceSlope);
+	this->params.thresholdScale = (std::max)(0.0, params.thresholdScale);
+}
+
+RecognizerParams PoseRecognizer::getParams() const {
+	return this->params;
+}
+
+void PoseRecognizer::setClassificationSchedule(const bool enabled, const double budget, const int maxStaleness) {
+
+	if (enabled && !scheduleClassification)
+		classificationScheduler.reset();
+
+	classificationScheduler.setLimits(budget, maxStaleness);
+	scheduleClassification = enabled;
+}
+
+bool PoseRecognizer::isClassificationScheduled() const {
+	return this->scheduleClassification;
+}
+
+SchedulerStatistics PoseRecognizer::getSchedulerStatistics() const {
+	return classificationScheduler.getStatistics();
+}
+
+void PoseRecognizer::setDistanceTable(const std::shared_ptr<DistanceTable>& table, const bool record) {
+	this->distanceTable = table;
+	this->recordDistances = record;
+	this->distanceTableTime = 0;
+}
+
+double PoseRecognizer::getDistanceTableTime() const {
+	return this->distanceTableTime;
+}
+
+void PoseRecognizer::setThresholdCalibration(const bool flag) {
+	this->calibrateThresholds = flag;
+
+	// the adjusted libraries have the old calibration
+	{
+		std::lock_guard<std::mutex> lock(adjustedPoseModelsMutex);
+		adjustedPoseModels.clear();
+	}
+
+	// the model may be shared, so calibrate a copy
+	if (poseModel)
+		poseModel = poseModel->withThresholdCalibration(flag);
 }
 
 // public
 std::vector<KinectUser*> PoseRecognizer::processNextFrame() {
 
-	// how many frames to skip every time? default: 4
-	if (skipFrames)
-		frameSkip = ++frameSkip % FRAME_SKIP;
+	if (streamReader.isOpen())
+		return processReplayFrame();
 
+	if (isCapturing())
+		return processCapturedFrame();
 
-	// frab the frames from Kinect
+	// grab the frames from Kinect. They are decoded later, only if somebody needs them
 	cap.grab();
-	cap.retrieve(depthMap, CV_16UC1);
-	cap.retrieve(bgrImage, CV_32FC1);
+	depthRetrieved = false;
+	colorRetrieved = false;
 	
 	// grab the frame to the NiTE
 	niteRc = userTracker.readFrame(&userTrackerFrame);	
@@ -350,78 +763,556 @@ std::vector<KinectUser*> PoseRecognizer::processNextFrame() {
 		return std::vector<KinectUser*>();
 	}
 
-	// get te list of users from the current frame
-	const nite::Array<nite::UserData>& users = userTrackerFrame.getUsers();
+	std::chrono::steady_clock::time_point arrival = std::chrono::steady_clock::now();
+
+	// copy the users from the current frame
+	liveFrame.capture(userTrackerFrame);
+
+	// record the raw images. They are only queued, the recorder compresses them on its own thread
+	if (streamWriter.isOpen()) {
+		retrieveDepth();
+		retrieveColor();
+		streamWriter.write(liveFrame.timestamp, depthMap, bgrImage);
+	}
+
+	liveMode = true;
+	std::vector<KinectUser*> recognitionResult = recognizeFrame(liveFrame, arrival);
+	liveMode = false;
+
+	return recognitionResult;
+}
+
+std::vector<KinectUser*> PoseRecognizer::processCapturedFrame() {
+
+	CapturedFrame captured;
+
+	// the capture was stopped
+	if (!captureMailbox.take(captured))
+		return std::vector<KinectUser*>();
+
+	// the images were already decoded on the capture thread
+	depthMap = captured.depth;
+	bgrImage = captured.color;
+	depthRetrieved = true;
+	colorRetrieved = true;
+
+	std::swap(liveFrame, captured.skeletons);
+
+	if (streamWriter.isOpen())
+		streamWriter.write(liveFrame.timestamp, depthMap, bgrImage);
+
+	// the frames, in which the users were lost, may have been dropped
+	removeMissingUsers(liveFrame);
+
+	// the new users were already passed to the skeleton tracking on the capture thread
+	std::vector<KinectUser*> recognitionResult = recognizeFrame(liveFrame, captured.arrival);
+
+	double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - captured.arrival).count();
+	averageCaptureLatency = (averageCaptureLatency > 0) ? averageCaptureLatency + 0.1 * (latency - averageCaptureLatency) : latency;
+	maxCaptureLatency = (std::max)(maxCaptureLatency, latency);
+
+	return recognitionResult;
+}
+
+void PoseRecognizer::runCapture() {
+
+	// the size of the previous images, so the buffers from the pools fit
+	cv::Size depthSize(640, 480);
+	cv::Size colorSize(640, 480);
+
+	// the failed frames in a row, and the wait before the next attempt
+	int failures = 0;
+	int retryDelay = CAPTURE_RETRY_DELAY;
+
+	while (capturing) {
+
+		CapturedFrame captured;
+
+		cap.grab();
+
+		if (userTracker.readFrame(&userTrackerFrame) != nite::STATUS_OK) {
+			failedCaptures++;
+
+			if (++failures >= CAPTURE_MAX_FAILURES) {
+				std::cerr << "Capture: the NiTE failed to deliver " << failures << " frames in a row, the capture is stopped" << std::endl;
+				captureMailbox.close();
+				break;
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(retryDelay));
+			retryDelay = (std::min)(2 * retryDelay, CAPTURE_MAX_RETRY_DELAY);
+			continue;
+		}
+
+		failures = 0;
+		retryDelay = CAPTURE_RETRY_DELAY;
+
+		captured.arrival = std::chrono::steady_clock::now();
+		captured.skeletons.capture(userTrackerFrame);
+
+		// start the tracking right away, the frame with the new user may never be processed
+		for (const SkeletonUser& user : captured.skeletons.users) {
+			if (user.isNew())
+				userTracker.startSkeletonTracking(user.getId());
+		}
+
+		// the images have to be decoded here, before the next frame is grabbed
+		captured.depth = depthPool.acquire(depthSize.height, depthSize.width, CV_16UC1);
+		if (cap.retrieve(captured.depth, CV_CAP_OPENNI_DEPTH_MAP))
+			depthSize = captured.depth.size();
+		else
+			captured.depth.release();
+
+		captured.color = colorPool.acquire(colorSize.height, colorSize.width, CV_8UC3);
+		if (cap.retrieve(captured.color, CV_CAP_OPENNI_BGR_IMAGE))
+			colorSize = captured.color.size();
+		else
+			captured.color.release();
+
+		// blocks with BACKPRESSURE_BLOCK, until the frame can be taken
+		if (!captureMailbox.post(std::move(captured)))
+			break;
+	}
+}
+
+bool PoseRecognizer::startCapture(const BackpressurePolicy policy, const int queueSize) {
+
+	if (isCapturing())
+		return false;
+
+	if (!niteAcquired || !cap.isOpened()) {
+		std::cerr << "The capture can't be started without the Kinect" << std::endl;
+		return false;
+	}
+
+	captureMailbox.reset(policy, queueSize);
+	failedCaptures = 0;
+	averageCaptureLatency = 0;
+	maxCaptureLatency = 0;
+
+	// from now on only the capture thread touches the device, the images come with the frames
+	depthRetrieved = true;
+	colorRetrieved = true;
+
+	capturing = true;
+	captureThread = std::thread(&PoseRecognizer::runCapture, this);
+
+	return true;
+}
+
+void PoseRecognizer::stopCapture() {
+
+	if (!captureThread.joinable())
+		return;
+
+	capturing = false;
+	captureMailbox.close();
+
+	captureThread.join();
+
+	CaptureStatistics statistics = getCaptureStatistics();
+
+	if (statistics.frames.dropped > 0 || statistics.frames.coalesced > 0)
+		std::cerr << "Capture: " << statistics.frames.dropped << " frames were dropped, " << statistics.frames.coalesced << " coalesced" << std::endl;
+}
+
+bool PoseRecognizer::isCapturing() const {
+	return captureThread.joinable();
+}
+
+CaptureStatistics PoseRecognizer::getCaptureStatistics() const {
+
+	CaptureStatistics statistics;
+	statistics.policy = captureMailbox.getPolicy();
+	statistics.frames = captureMailbox.getStatistics();
+	statistics.failedFrames = failedCaptures;
+	statistics.averageLatency = averageCaptureLatency;
+	statistics.maxLatency = maxCaptureLatency;
+
+	return statistics;
+}
+
+std::vector<KinectUser*> PoseRecognizer::processReplayFrame() {
+
+	StreamFrame streamFrame;
+
+	if (!streamReader.readNextFrame(streamFrame)) {
+		std::cerr << "End of the replay" << std::endl;
+		stopReplay();
+		return std::vector<KinectUser*>();
+	}
+
+	// the images are already decoded
+	depthMap = streamFrame.depth;
+	bgrImage = streamFrame.color;
+	depthRetrieved = true;
+	colorRetrieved = true;
+
+	// find the skeletons with the same timestamp. Frames without skeletons only update the images
+	liveFrame.timestamp = streamFrame.timestamp;
+	liveFrame.users.clear();
+
+	const SkeletonFrame* skeletons = &liveFrame;
+
+	while (replaySession.isOpen()) {
+		if (!replayFramePending && !(replayFramePending = replaySession.readNextFrame(replayFrame)))
+			break;
+
+		// the skeletons are ahead of the images
+		if (replayFrame.timestamp > streamFrame.timestamp)
+			break;
+
+		replayFramePending = false;
+
+		if (replayFrame.timestamp == streamFrame.timestamp) {
+			skeletons = &replayFrame;
+			break;
+		}
+	}
+
+	return recognizeFrame(*skeletons, std::chrono::steady_clock::now());
+}
+
+std::vector<KinectUser*> PoseRecognizer::processSkeletonFrame(const SkeletonFrame& frame) {
+	return recognizeFrame(frame, std::chrono::steady_clock::now());
+}
+
+std::vector<KinectUser*> PoseRecognizer::recognizeFrame(const SkeletonFrame& frame, const std::chrono::steady_clock::time_point arrival) {
+
+	frameArrival = arrival;
+	frameTimestamp = frame.timestamp;
+
+	// how many frames to skip every time? default: none, 4 in start()
+	frameSkip = (frameSkip + 1) % params.frameSkip;
+
+	frameNumber++;
 
 	// fill the list of users
-	fillUserList(users);
+	fillUserList(frame);
+
+	// switch the pose libraries, selected since the last frame
+	switchPoseModels(frame.timestamp);
+
+	// smooth the joints of all the users at once, before anything reads them
+	if (smoothJoints)
+		jointFilter.apply(jointSnapshot, frame.timestamp);
+
+	// project the joints of all users on the image at once
+	depthProjection.projectAll(jointSnapshot);
+
+	// follow the movement of the joints on the image, to predict where they're drawn
+	if (predictJoints)
+		jointPredictor.update(jointSnapshot, frame.timestamp);
 
 	std::vector<KinectUser*> recognitionResult;
 
+	// the poses are estimated only every few frames (or for some of the users in every frame, when
+	// they're scheduled), but the gestures need every frame
+	bool estimatePoses = scheduleClassification || (frameSkip == 0);
+	bool trackMotion = gestureRecognizer.hasGestures() || recordingGesture;
+
 	// for every user: extract features and estimate pose:
-	if (frameSkip == 0) {		
+	if ((estimatePoses || trackMotion) && poseModel) {		
+
+		// calculate the features for all the users at once, for every feature profile in use
+		bool profileUsed[NUM_FEATURE_PROFILES] = { false };
 
-		for (KinectUser& user : userList) {
+		userList.forEach([&](KinectUser& user) {
+			profileUsed[getUserPoseModel(user)->getFeatureProfile()] = true;
+		});
 
-			FeatureString featureString = user.extractUserFeatures();
+		for (int profile = 0; profile < NUM_FEATURE_PROFILES; profile++) {
+			if (profileUsed[profile])
+				extractFeatures((FeatureProfile)profile, jointSnapshot, featureBatches[profile]);
+		}
+
+		if (scheduleClassification)
+			classificationScheduler.beginFrame();
+
+		userList.forEach([&](KinectUser& user) {
+
+			std::shared_ptr<const PoseModel>& model = getUserPoseModel(user);
+
+			FeatureString featureString = user.extractUserFeatures(featureBatches[model->getFeatureProfile()]);
+
+			if (trackMotion)
+				trackGestures(user, featureString, frame.timestamp);
+
+			if (!estimatePoses)
+				return;
 			
-			if (featureString.size() > 0 && !rememberPose) {
-				
-				if (estimatePose(user, featureString, nearestNeighbours) >= 0) {
-					recognitionResult.push_back(&user);
-				}
+			if (!featureString.isEmpty() && !rememberPose) {
+
+				if (scheduleClassification) {
+					// the change of the features is compared to the tightest pose
+					double threshold = 0;
+
+					for (const std::shared_ptr<const KinectPose>& pose : model->getPoses()) {
+						if (threshold <= 0 || pose->getDistanceThreshold() < threshold)
+							threshold = pose->getDistanceThreshold();
+					}
 
+					classificationScheduler.addCandidate(user.getUserId(), featureString, user.extractJoint3D(nite::JOINT_TORSO).z / 1000, threshold);
+				}
+				else
+					classifyUser(user, *model, featureString, frame.timestamp, recognitionResult);
 			}
 
 			// add the feature string as a new training sample, if the key 'b' was pressed
 			if (rememberPose) { 		
 			
-				if (featureString.size() > 0) {
-					poseVector[currentPoseNumber].addNewTrainingSample(featureString);
-					std::cout << "New training sample added for " << poseVector[currentPoseNumber].getPoseName() << "!" << std::endl;
+				if (!featureString.isEmpty() && currentPoseNumber < model->size()) {
+					if (addTrainingSample(model, currentPoseNumber, featureString))
+						std::cout << "New training sample added for " << model->getPose(currentPoseNumber).getPoseName() << "!" << std::endl;
+					else
+						std::cout << "The training sample for " << model->getPose(currentPoseNumber).getPoseName() << " was rejected, the pose is full (see setSampleCapacity())" << std::endl;
 				}
 
 				rememberPose = false;
 			
 			}
+		});
+
+		// estimate the users with the highest priority, that fit into the budget of this frame
+		int userId;
+
+		while (scheduleClassification && classificationScheduler.next(userId)) {
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			KinectUser& user = *userList.find(userId);
+			const PoseModel& model = *getUserPoseModel(user);
+
+			classifyUser(user, model, user.extractUserFeatures(featureBatches[model.getFeatureProfile()]), frame.timestamp, recognitionResult);
+
+			classificationScheduler.finish(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
 		}
 	}
+
+	// record the frame together with the current poses of the users
+	if (sessionWriter.isOpen()) {
+		recordedFrame = frame;
+
+		for (SkeletonUser& user : recordedFrame.users) {
+			KinectUser* kinectUser = userList.isValidId(user.getId()) ? userList.find(user.getId()) : nullptr;
+			user.poseIndex = (kinectUser != nullptr) ? kinectUser->getPoseIndex() : -1;
+		}
+
+		sessionWriter.write(recordedFrame);
+	}
+
+	// publish the results of all the users
+	if (resultPublisher.isOpen()) {
+		std::vector<KinectUser*> users;
+		userList.forEach([&users](KinectUser& usr) {
+			users.push_back(&usr);
+		});
+
+		resultPublisher.publish(frame.timestamp, users);
+	}
+
+	// deliver the events of this frame
+	poseEvents.dispatch();
+
 	return recognitionResult;
 }
 
+void PoseRecognizer::setDepthProjection(const DepthProjection& projection) {
+	this->depthProjection = projection;
+}
+
+bool PoseRecognizer::startRecording(const std::string& fileName) {
+	return sessionWriter.open(fileName, depthProjection);
+}
+
+void PoseRecognizer::stopRecording() {
+	sessionWriter.close();
+}
+
+bool PoseRecognizer::startStreamRecording(const std::string& fileName) {
+	return streamWriter.open(fileName);
+}
+
+void PoseRecognizer::stopStreamRecording() {
+	streamWriter.close();
+}
+
+bool PoseRecognizer::startVideoRecording(const std::string& fileName, const double fps) {
+	return videoRecorder.open(fileName, fps);
+}
+
+void PoseRecognizer::stopVideoRecording() {
+	videoRecorder.close();
+}
+
+const VideoRecorder& PoseRecognizer::getVideoRecorder() const {
+	return this->videoRecorder;
+}
+
+bool PoseRecognizer::startRecognitionLog(const std::string& fileName) {
+	return recognitionLog.open(fileName);
+}
+
+void PoseRecognizer::stopRecognitionLog() {
+	recognitionLog.close();
+}
+
+bool PoseRecognizer::startReplay(const std::string& streamFile, const std::string& sessionFile, const bool realTime) {
+
+	stopReplay();
+
+	if (!streamReader.open(streamFile, realTime))
+		return false;
+
+	if (sessionFile != "") {
+		if (!replaySession.open(sessionFile)) {
+			streamReader.close();
+			return false;
+		}
+
+		// draw the skeletons the same way they were drawn during the recording
+		depthProjection = replaySession.getProjection();
+	}
+
+	return true;
+}
+
+bool PoseRecognizer::startPublishing(const std::string& name) {
+	return resultPublisher.open(name);
+}
+
+void PoseRecognizer::stopPublishing() {
+	resultPublisher.close();
+}
+
+int PoseRecognizer::subscribePoseEvents(const PoseEventDispatcher::Callback& callback) {
+	return poseEvents.subscribe(callback);
+}
+
+void PoseRecognizer::unsubscribePoseEvents(const int subscription) {
+	poseEvents.unsubscribe(subscription);
+}
+
+bool PoseRecognizer::isReplaying() const {
+	return streamReader.isOpen();
+}
+
+void PoseRecognizer::stopReplay() {
+	streamReader.close();
+	replaySession.close();
+	replayFramePending = false;
+}
+
+void PoseRecognizer::retrieveDepth() {
+
+	if (depthRetrieved)
+		return;
+
+	// decode into a buffer nobody else is using, of the same size as the previous frame
+	depthMap = depthPool.acquire(depthMap.empty() ? 480 : depthMap.rows, depthMap.empty() ? 640 : depthMap.cols, CV_16UC1);
+	if (!cap.retrieve(depthMap, CV_CAP_OPENNI_DEPTH_MAP))
+		depthMap.release();
+
+	depthRetrieved = true;
+}
+
+void PoseRecognizer::retrieveColor() {
+
+	if (colorRetrieved)
+		return;
+
+	// decode into a buffer nobody else is using, of the same size as the previous frame
+	bgrImage = colorPool.acquire(bgrImage.empty() ? 480 : bgrImage.rows, bgrImage.empty() ? 640 : bgrImage.cols, CV_8UC3);
+	if (!cap.retrieve(bgrImage, CV_CAP_OPENNI_BGR_IMAGE))
+		bgrImage.release();
+
+	colorRetrieved = true;
+}
+
 cv::Mat PoseRecognizer::getOriginalFrame() {
+	retrieveColor();
+
 	return this->bgrImage;
 }
 
+cv::Mat PoseRecognizer::getDepthMap() {
+	retrieveDepth();
+
+	return this->depthMap;
+}
+
 cv::Mat PoseRecognizer::getModifiedFrame() {
 
+	// this frame was already rendered
+	if (outputFrameNumber == frameNumber && !outputFrame.empty())
+		return outputFrame;
+
+	retrieveColor();
+
 	if (this->bgrImage.empty())
 		return cv::Mat(480, 640, CV_8U);
 	
-	cv::Mat image = this->bgrImage.clone();
+	// render into a back buffer, that no reader is holding
+	cv::Mat image = outputPool.acquire(bgrImage.rows, bgrImage.cols, bgrImage.type());
+	this->bgrImage.copyTo(image);
 	
-	// draw skeletons;	
-	for (KinectUser usr : userList) {
-		usr.drawUserSkeleton(image);
-	}		
+	std::chrono::steady_clock::time_point renderStart = std::chrono::steady_clock::now();
 
-	// add some effects for interactivity
-	for (KinectUser usr : userList) { 
-		// either just write the name of the pose near the user's head:
-		// cv::putText(image, usr.getPoseName(), usr.extractJoint2D(nite::JOINT_HEAD) + cv::Point2f(20, 10), CV_FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 0, 255), 3);
-
-		// or just overlay the pictures of instruments near the user's hands
-		drawInstrument(usr, image);
+	// draw the joints where they will be, when the frame is shown: the frame is already this old,
+	// the rendering and the display add the rest
+	if (predictJoints) {
+		predictionLatency = std::chrono::duration<double>(renderStart - frameArrival).count() + renderDuration + displayLatency;
+		jointPredictor.predict(jointSnapshot, (float)predictionLatency);
 	}
+
+	// draw the skeletons and overlay the pictures of instruments near the user's hands
+	std::vector<KinectUser*> users;
+	userList.forEach([&users](KinectUser& usr) {
+		users.push_back(&usr);
+	});
+
+	overlayRenderer.render(image, users);
+
+	// the average time of the rendering
+	double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - renderStart).count();
+	renderDuration = (renderDuration > 0) ? renderDuration + 0.1 * (duration - renderDuration) : duration;
+
+	// publish the new frame
+	outputFrame = image;
+	outputFrameNumber = frameNumber;
+
+	// the recorder encodes a copy, so the caller may draw on the frame
+	if (videoRecorder.isOpen())
+		videoRecorder.write(frameTimestamp, outputFrame);
 	
-	return image;
+	return outputFrame;
+}
+
+UserHandle PoseRecognizer::getUserHandle(const nite::UserId userId) const {
+	return userList.getHandle(userId);
+}
+
+KinectUser* PoseRecognizer::getUser(const UserHandle& handle) {
+	return userList.resolve(handle);
 }
 
 
 PoseRecognizer::~PoseRecognizer() {
 
-	nite::NiTE::shutdown();
+	stopCapture();
+
+	sessionWriter.close();
+	streamWriter.close();
+	videoRecorder.close();
+	recognitionLog.close();
 
 	cap.release();
 
+	if (niteAcquired) {
+		userTracker.destroy();
+		device.close();
+
+		NiteRuntime::release();
+	}
+
 }
@@ -1,22 +1,109 @@
 #pragma once
 #include "KinectUser.h"
+#include "UserSlotMap.h"
+#include "DepthProjection.h"
+#include "FramePool.h"
+#include "OverlayRenderer.h"
+#include "SkeletonFrame.h"
+#include "SkeletonSession.h"
+#include "StreamSession.h"
+#include "PoseModel.h"
+#include "PoseModelStore.h"
+#include "NiteRuntime.h"
+#include "ResultRing.h"
+#include "PoseEvents.h"
+#include "GestureRecognizer.h"
+#include "JointFilter.h"
+#include "JointPredictor.h"
+#include "FrameMailbox.h"
+#include "DistanceTable.h"
+#include "VideoRecorder.h"
+#include "RecognitionLog.h"
+#include "ClassificationScheduler.h"
 #include <iterator>
 
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
 #include <thread>
 
 #define KEY_PGUP 2228224      // the key code for the PageUp button
 #define KEY_PGDN 2162688      // the key code for the PageDown button
 #define KEY_TRAIN 'b'         // the key that is pressed for adding a training sample
+#define KEY_GESTURE 'g'       // the key that starts and stops the recording of a new gesture
+#define KEY_LIBRARY 'l'       // the key that switches to the next pose library
 
 #define FRAME_SKIP 4          // how many frames to skip
 
 #define MAX_USERS 10          // maximum number of users in the frame at the same time
+#define USER_SLOTS (MAX_USERS + 1)  // the per-user arrays are indexed by the NiTE user id, which starts at 1
+
+#define CAPTURE_RETRY_DELAY 5        // the wait after the first failed frame on the capture thread, in milliseconds; doubles with every next failure
+#define CAPTURE_MAX_RETRY_DELAY 500  // the longest wait between two attempts to read a frame, in milliseconds
+#define CAPTURE_MAX_FAILURES 50      // after this many failed frames in a row, the capture thread gives up and closes the mailbox
+
+#define DISPLAY_LATENCY 33    // the time from the end of the rendering until the frame is on the screen, in milliseconds. Default: 33 (one frame)
 
 #define HOLD_POSE	3           // how long the pose needs to be held before it's recognized. Should be odd number. Default: 3
 
+#define NEAR_DISTANCE 2.0     // up to this distance from the Kinect (in meters) the distance thresholds of the poses are not scaled
+#define DISTANCE_SLOPE 0.5    // how much the distance thresholds grow with every meter beyond NEAR_DISTANCE
+
 #define USER_MESSAGE(msg) \
 	{printf("[%08llu] User #%d:\t%s\n",ts, user.getId(),msg);}
 
+/**
+	The tunable parameters of the pose estimation (see PoseRecognizer::setParams() and ParameterSweep)
+*/
+struct RecognizerParams {
+
+	// the number of nearest neighbours, that vote for the pose
+	int nearestNeighbours = 7;
+
+	// for how many estimations the pose needs to be held (see PoseRecognizer::setPoseHold())
+	int poseHold = HOLD_POSE;
+
+	// the poses are estimated every frameSkip frames (1 = every frame)
+	int frameSkip = 1;
+
+	// the distance thresholds of the poses grow with the distance of the user from the Kinect:
+	// beyond nearDistance (in meters) by distanceSlope per meter
+	double nearDistance = NEAR_DISTANCE;
+	double distanceSlope = DISTANCE_SLOPE;
+
+	// scales the distance threshold (the reference estimate) of every pose
+	double thresholdScale = 1.0;
+
+	/**
+		Get the factor of the distance thresholds for a user
+
+		@param distance The distance of the user from the Kinect, in meters
+	*/
+	double getThresholdMultiplier(const double distance) const {
+		return thresholdScale * (1.0 + (std::max)(0.0, distance - nearDistance) * distanceSlope);
+	}
+};
+
+/**
+	The counters of the capture thread (see PoseRecognizer::startCapture())
+*/
+struct CaptureStatistics {
+
+	// the policy of the capture
+	BackpressurePolicy policy = BACKPRESSURE_LATEST_WINS;
+
+	// the grabbed, the processed, the dropped and the coalesced frames
+	MailboxStatistics frames;
+
+	// the frames, that the NiTE failed to deliver
+	unsigned long long failedFrames = 0;
+
+	// the time from grabbing the frame to the end of its recognition, in milliseconds: the average and the maximum
+	double averageLatency = 0;
+	double maxLatency = 0;
+};
+
 /**
 	The main class, that initializes the OpenCV, OpenNI and NiTE, and performs the
 	pose recognition process.
@@ -35,20 +122,106 @@ public:
 		Does things like: read pose data from file, initialize OpenCV,
 		initialize NiTE and OpenNI.
 
+		All the pose libraries ("./poses", "./poses_belt_level", "./poses_from_head") are loaded
+		into the pose model store, with their feature profiles (PROFILE_BELT for "./poses_belt_level",
+		PROFILE_HEAD for the others), and the "./poses" library is used, unless a shared pose model
+		was already set with setPoseModel().
+
+		@param deviceIndex The index of the Kinect device, if several are connected. Default: 0.
+
 		@return Returns "true" if initialization was successful.
 	*/
-	bool initialize();
+	bool initialize(const int deviceIndex = 0);
 
 	/**
 		Reload the pose information from the files in a different folder.
-		See the description of the initPoseData() method for details on how 
+		See the description of the PoseModel::load() method for details on how 
 		the files should be formatted.
 
+		The files are read only once: the library is kept in the pose model store (see setPoseModelStore()),
+		and switching back to it later doesn't read anything. The new poses are used from the next frame on.
+
 		@param folder The name of the folder that contains the pose data.
+		@param featureProfile How the training samples in the folder were recorded, if the library
+		isn't loaded yet (see PoseModelStore::load()). Default: PROFILE_HEAD.
 
 		@return Returns "true" if the reinitialization of the pose data was successful.
 	*/
-	bool reloadPoseData(const std::string folder);
+	bool reloadPoseData(const std::string folder, const FeatureProfile featureProfile = PROFILE_HEAD);
+
+	/**
+		Use another store of the pose libraries. By default all the recognizers share
+		the same store (see PoseModelStore::getDefault()).
+
+		@param store The pose model store
+	*/
+	void setPoseModelStore(const std::shared_ptr<PoseModelStore>& store);
+
+	/**
+		Get the store of the pose libraries
+	*/
+	std::shared_ptr<PoseModelStore> getPoseModelStore() const;
+
+	/**
+		Switch to another pose library between two frames. Can be called from any thread, e.g. while
+		the recognizer is running in start(). The switch happens at the beginning of the next frame;
+		the users, that held a pose of the previous library, leave it (see EVENT_POSE_LEFT).
+
+		@param poseModel The pose model, e.g. from the store (see PoseModelStore::get())
+	*/
+	void selectPoseModel(const std::shared_ptr<const PoseModel>& poseModel);
+
+	/**
+		Switch a single user to another pose library between two frames, like selectPoseModel().
+		The selection is forgotten when the user is lost.
+
+		@param userId The NiTE id of the user
+		@param poseModel The pose model, or nullptr to use the library of the recognizer again
+	*/
+	void selectUserPoseModel(const nite::UserId userId, const std::shared_ptr<const PoseModel>& poseModel);
+
+	/**
+		Load the gestures from the files in the folder. See GestureTemplate for the format of the files.
+		The gestures are recognized in every frame, together with the poses, and are reported as
+		the pose events (EVENT_GESTURE, see subscribePoseEvents()).
+
+		The gestures are loaded from the "./gestures" folder during the initialization, if it exists.
+
+		@param folder The name of the folder that contains the gestures.
+
+		@return Returns "true" if at least one gesture was loaded.
+	*/
+	bool loadGestures(const std::string folder);
+
+	/**
+		Start recording a new gesture: the features of the first tracked user in every frame,
+		for at most GESTURE_HISTORY frames.
+	*/
+	void startGestureRecording();
+
+	/**
+		Stop recording the gesture, save it and start recognizing it
+
+		@param name The name of the gesture
+		@param fileName The path to the gesture file
+		@param threshold The maximum average distance per frame. Default: GESTURE_DEFAULT_THRESHOLD.
+
+		@return Returns "true" if the gesture was recorded and saved.
+	*/
+	bool stopGestureRecording(const std::string& name, const std::string& fileName, const double threshold = GESTURE_DEFAULT_THRESHOLD);
+
+	/**
+		Use the already loaded pose model. The model is not copied, so the same model can be
+		shared by several recognizers (see MultiSourceHost).
+
+		@param poseModel The pose model
+	*/
+	void setPoseModel(const std::shared_ptr<const PoseModel>& poseModel);
+
+	/**
+		Get the current pose model
+	*/
+	std::shared_ptr<const PoseModel> getPoseModel() const;
 
 	/**
 		Toggles displaying debug information on/off. The Debug information includes
@@ -60,12 +233,72 @@ public:
 
 	/**
 		Starts the entire pose recognition process. The process will run in a separate thread.
-		Every 4 frames the pose estimation will be performed. At the end of each cycle
+		Every user's pose is estimated at least every 4 frames (FRAME_SKIP), spread over the frames by the
+		classification schedule (unless a frame skip was set with setParams(), or a schedule with
+		setClassificationSchedule()). At the end of each cycle
 		the image with overlayed skeletons will be shown along with the name of every detected
 		pose near the head of each user.
 	*/
 	void start();
 
+	/**
+		Set all the parameters of the pose estimation at once. The invalid values are clamped.
+
+		@param params The new parameters
+	*/
+	void setParams(const RecognizerParams& params);
+
+	/**
+		Get the parameters of the pose estimation
+	*/
+	RecognizerParams getParams() const;
+
+	/**
+		Take the distances to the training samples from a precomputed table, instead of comparing
+		the features of the users in every frame. The table belongs to one replayed session, and
+		the frames are identified by their order, so the recognizer has to replay the same frames
+		from the start (see ParameterSweep).
+
+		In the recording mode, the distances computed by the recognizer are added to the table. The
+		table then contains the samples within the thresholds of the recording parameters, so it can
+		be used with any parameters, that don't have wider thresholds (see RecognizerParams::getThresholdMultiplier()).
+
+		@param table The table, or nullptr to compare the features again
+		@param record Set "true" to fill the table instead of reading it
+	*/
+	void setDistanceTable(const std::shared_ptr<DistanceTable>& table, const bool record = false);
+
+	/**
+		Get the time, that the distances taken from the table took to compute, when the table was
+		recorded (in milliseconds, since setDistanceTable()). Add it to the processing time, to get
+		the time the recognizer would take without the table.
+	*/
+	double getDistanceTableTime() const;
+
+	/**
+		Spread the pose estimations of the users over the frames within a time budget, instead of
+		estimating all the users every frameSkip frames (see ClassificationScheduler). The poses are
+		then estimated in every frame, for the users with the highest priority (the new users, the
+		users, whose features changed the most, and the users nearest to the Kinect), and the frame
+		skip is ignored. The gestures are still tracked in every frame.
+
+		@param enabled Set "true" to schedule the pose estimations
+		@param budget The time for the pose estimations in one frame, in milliseconds. Default: SCHEDULER_FRAME_BUDGET.
+		@param maxStaleness Every user is estimated at least every maxStaleness frames, even over the budget. Default: SCHEDULER_MAX_STALENESS.
+	*/
+	void setClassificationSchedule(const bool enabled, const double budget = SCHEDULER_FRAME_BUDGET, const int maxStaleness = SCHEDULER_MAX_STALENESS);
+
+	/**
+		Check if the pose estimations are scheduled (see setClassificationSchedule())
+	*/
+	bool isClassificationScheduled() const;
+
+	/**
+		Get the counters of the classification schedule: the estimated, the forced and the deferred
+		users, and the time of the estimations per frame
+	*/
+	SchedulerStatistics getSchedulerStatistics() const;
+
 	/**
 		Set the number of nearest neighbours for the algorithm. 
 
@@ -73,6 +306,66 @@ public:
 	*/
 	void setNearestNeighbours(const int nNeighbours = 3);
 
+	/**
+		Toggles the calibration of the distance thresholds of the poses. The poses are compared
+		in the embedded space (see EmbeddedFeature), and the calibration scales the reference
+		estimate of every pose, so it keeps the same meaning as with the original metric.
+		See KinectPose::calibrateThreshold() for details.
+
+		@param flag Set "true" to calibrate the thresholds. Default: true.
+	*/
+	void setThresholdCalibration(const bool flag = true);
+
+	/**
+		Limit the number of the training samples of every pose, so the online training (see KEY_TRAIN)
+		can't make the recognition slower and slower. Once a pose is full, the new samples replace
+		the old ones (see KinectPose::setCapacity()). Applies to the current library, and to the libraries
+		selected later.
+
+		@param capacity The maximum number of the samples of a pose. Default: POSE_MAX_SAMPLES.
+		@param eviction How the new samples replace the old ones. Default: EVICT_REDUNDANT.
+	*/
+	void setSampleCapacity(const int capacity = POSE_MAX_SAMPLES, const SampleEviction eviction = EVICT_REDUNDANT);
+
+	/**
+		Toggles the smoothing of the skeleton joints (see JointFilter). The joints of all the users
+		are filtered once per frame, before the features are extracted and the skeletons are drawn,
+		so the pose estimation jitters less, and a shorter hold (see setPoseHold()) is enough.
+
+		@param flag Set "true" to smooth the joints. Default: true.
+	*/
+	void setJointSmoothing(const bool flag = true);
+
+	/**
+		Get the joint filter, e.g. to tune the individual joints (see JointFilter::setParams())
+	*/
+	JointFilter& getJointFilter();
+
+	/**
+		Toggles the prediction of the drawn joints (see JointPredictor). The skeletons and the instruments
+		are drawn where the joints are expected to be, when the frame is shown: the joints are moved along
+		their velocities by the measured latency from the arrival of the frame until the end of the
+		rendering, plus the latency of the display.
+
+		@param flag Set "true" to predict the joints. Default: true.
+		@param displayLatency The time from the end of the rendering until the frame is on the screen,
+		in milliseconds. Default: DISPLAY_LATENCY.
+	*/
+	void setJointPrediction(const bool flag = true, const double displayLatency = DISPLAY_LATENCY);
+
+	/**
+		Get the latency, the joints were predicted by in the last rendered frame, in milliseconds
+	*/
+	double getPredictionLatency() const;
+
+	/**
+		Set for how many consecutive estimations the pose needs to be held before it's recognized.
+		An even number is rounded up to the next odd one.
+
+		@param estimations The number of the estimations. Default: HOLD_POSE.
+	*/
+	void setPoseHold(const int estimations = HOLD_POSE);
+
 	/**
 		Grabs the next frame from the Kinect device, locates every visible user in the image,
 		performs the pose estimation and returns the list of each user, for whom a pose was 
@@ -82,26 +375,254 @@ public:
 		of each cycle.
 
 		@return Returns a vector of pointers to users, for whom in the current frame a pose was 
-		recognized.
+		recognized. The pointers stay valid for as long as the user is tracked.
 	*/
 	std::vector<KinectUser*> processNextFrame();
 
+	/**
+		Grab the frames from the Kinect on a separate capture thread. Without it, the frames wait inside
+		the OpenNI until processNextFrame() asks for them, so when the caller (or the display) falls behind,
+		the recognized frames get older and older. With the capture thread, processNextFrame() takes
+		the frames from the thread instead, and the policy decides what happens with the frames that
+		arrive in the meantime:
+
+		- BACKPRESSURE_LATEST_WINS keeps only the newest frame, so the latency never exceeds one frame
+		  plus the processing,
+		- BACKPRESSURE_DROP_OLDEST keeps up to queueSize newest frames,
+		- BACKPRESSURE_BLOCK stops grabbing until the frames are taken (the old behaviour).
+
+		The users lost in the dropped frames are still removed (see removeMissingUsers()).
+		start() runs with BACKPRESSURE_LATEST_WINS, unless the capture was already started.
+
+		When the NiTE fails to deliver a frame, the capture thread waits before the next attempt
+		(from CAPTURE_RETRY_DELAY up to CAPTURE_MAX_RETRY_DELAY). After CAPTURE_MAX_FAILURES failures
+		in a row, it closes the mailbox, and processNextFrame() returns no more users.
+
+		@param policy What to do with the frames, when processNextFrame() falls behind. Default: BACKPRESSURE_LATEST_WINS.
+		@param queueSize The maximum number of waiting frames (not for BACKPRESSURE_LATEST_WINS). Default: MAILBOX_DEFAULT_CAPACITY.
+
+		@return Returns "false" if the Kinect isn't initialized, or the capture is already running.
+	*/
+	bool startCapture(const BackpressurePolicy policy = BACKPRESSURE_LATEST_WINS, const int queueSize = MAILBOX_DEFAULT_CAPACITY);
+
+	/**
+		Stop the capture thread. processNextFrame() grabs the frames itself again.
+	*/
+	void stopCapture();
+
+	/**
+		Check if the frames are grabbed on the capture thread
+	*/
+	bool isCapturing() const;
+
+	/**
+		Get the counters of the capture thread, since it was started. Call from the thread, that
+		calls processNextFrame().
+	*/
+	CaptureStatistics getCaptureStatistics() const;
+
+	/**
+		Performs the pose estimation on an already captured frame of skeletons, e.g. a frame
+		replayed from a session file (see SkeletonSessionReader). Does the same as processNextFrame(),
+		except grabbing the frame from the Kinect, so it also works without the Kinect and the NiTE.
+		To draw the replayed skeletons correctly, use setDepthProjection() with the projection from
+		the session file.
+
+		@param frame The frame with all the users
+
+		@return Returns a vector of pointers to users, for whom in the current frame a pose was
+		recognized. The pointers stay valid for as long as the user is tracked.
+	*/
+	std::vector<KinectUser*> processSkeletonFrame(const SkeletonFrame& frame);
+
+	/**
+		Set the projection of the joints on the depth image. Normally it's captured from
+		the NiTE during the initialization.
+
+		@param projection The new projection
+	*/
+	void setDepthProjection(const DepthProjection& projection);
+
+	/**
+		Start recording every processed frame (the skeletons, the states and the recognized poses
+		of all the users) into a compact session file. See SkeletonSession.h for the format.
+
+		@param fileName The path to the session file
+
+		@return Returns "true" if the recording was started.
+	*/
+	bool startRecording(const std::string& fileName);
+
+	/**
+		Stop the recording and finalize the session file
+	*/
+	void stopRecording();
+
+	/**
+		Start recording the raw depth maps and color images of every grabbed frame, compressed
+		losslessly (see StreamSession.h). The frames are compressed and written on a background
+		thread; if it can't keep up, the frames are dropped instead of stalling the capture.
+		Use together with startRecording() to also keep the tracked skeletons.
+
+		@param fileName The path to the stream file
+
+		@return Returns "true" if the recording was started.
+	*/
+	bool startStreamRecording(const std::string& fileName);
+
+	/**
+		Stop the recording of the camera streams, after all the queued frames are written
+	*/
+	void stopStreamRecording();
+
+	/**
+		Start recording the annotated frames (see getModifiedFrame()) into a video file. Only the
+		frames, that are rendered, are recorded: a copy of the frame is queued when it's rendered,
+		and encoded on a background thread (see VideoRecorder). If the encoder can't keep up, the frames
+		are dropped instead of stalling the frame loop.
+
+		@param fileName The path to the video file
+		@param fps The frame rate of the video. Default: VIDEO_DEFAULT_FPS.
+
+		@return Returns "true" if the recording was started.
+	*/
+	bool startVideoRecording(const std::string& fileName, const double fps = VIDEO_DEFAULT_FPS);
+
+	/**
+		Stop the video recording, after all the queued frames are encoded
+	*/
+	void stopVideoRecording();
+
+	/**
+		Get the video recorder, e.g. for its counters
+	*/
+	const VideoRecorder& getVideoRecorder() const;
+
+	/**
+		Start logging every pose estimation (the features, the nearest training samples, the candidate
+		and the recognized pose of every user in every frame) into a binary log (see RecognitionLogWriter).
+		The recognition thread only fills a record in memory, the file is written on a background thread.
+
+		@param fileName The path to the log file. An existing log is appended to.
+
+		@return Returns "true" if the log was opened.
+	*/
+	bool startRecognitionLog(const std::string& fileName);
+
+	/**
+		Stop logging the pose estimations, after all the staged records are written
+	*/
+	void stopRecognitionLog();
+
+	/**
+		Replay the recorded camera streams instead of the Kinect. After this, processNextFrame()
+		takes the images from the stream file, and the skeletons from the session file (if provided),
+		so the recognition and the rendering can be reproduced offline. The Kinect and the NiTE
+		are not needed for the replay, but the pose data still has to be loaded (see reloadPoseData()).
+
+		@param streamFile The path to the stream file (see startStreamRecording())
+		@param sessionFile The path to the skeleton session file, recorded at the same time (see startRecording()). Optional.
+		@param realTime Replay at the original rate (true) or as fast as possible (false). Default: true.
+
+		@return Returns "true" if the files were opened.
+	*/
+	bool startReplay(const std::string& streamFile, const std::string& sessionFile = "", const bool realTime = true);
+
+	/**
+		Stop the replay and go back to the Kinect
+	*/
+	void stopReplay();
+
+	/**
+		Start publishing the results of every processed frame (the ids, the recognized poses and the
+		key joints of all the users) into the named shared memory, so other processes can read them
+		with the ResultSubscriber. See ResultRing.h for details.
+
+		@param name The name of the shared memory. Default: RESULT_RING_NAME.
+
+		@return Returns "true" if the shared memory was created.
+	*/
+	bool startPublishing(const std::string& name = RESULT_RING_NAME);
+
+	/**
+		Stop publishing the results
+	*/
+	void stopPublishing();
+
+	/**
+		Subscribe to the pose events: a user appeared or was lost, a pose was entered or left.
+		The events are delivered at the end of processNextFrame() (or processSkeletonFrame()),
+		in the same frame, in which the decision changed, on the same thread.
+
+		@param callback The function, that is called for every event
+
+		@return The id of the subscription
+	*/
+	int subscribePoseEvents(const PoseEventDispatcher::Callback& callback);
+
+	/**
+		Remove the subscription to the pose events. Must not be called from the callback itself.
+
+		@param subscription The id, returned by subscribePoseEvents()
+	*/
+	void unsubscribePoseEvents(const int subscription);
+
+	/**
+		Check if the recognizer is replaying the recorded streams (see startReplay()).
+		Turns "false" at the end of the replay.
+	*/
+	bool isReplaying() const;
+
 	/**
 		Gets the original unmodified frame from the Kinect's RGB camera.
+		The frame is decoded only when it's requested for the first time after the grab.
 
 		@return An OpenCV Mat image, in the RGB format.
 	*/
 	cv::Mat getOriginalFrame();
 
+	/**
+		Gets the depth map from the Kinect's depth camera.
+		The depth map is decoded only when it's requested for the first time after the grab.
+
+		@return An OpenCV Mat image (CV_16UC1), with the depth in milimeters.
+	*/
+	cv::Mat getDepthMap();
+
 	/**
 		Gets the modified frame from the Kinect's camera. The image has the skeletons
 		of every user displayed (only the upper body), as well as the name of every 
 		recognized pose near the user's head.
 
+		The frame is rendered at most once per grabbed frame, into one of the reused output
+		buffers, and every caller gets the same image without copying. The recognizer never
+		modifies the image after it was returned, so it can be kept. The caller may draw on it,
+		the video recorder (see startVideoRecording()) encodes its own copy, but the later calls
+		for the same frame return the image with the drawings.
+
 		@return An OpenCV Mat image, in the RGB format
 	*/
 	cv::Mat getModifiedFrame();
 
+	/**
+		Get a handle to the currently tracked user. Unlike the raw pointer, the handle
+		can be kept across frames: once the user leaves the scene, the handle stops resolving.
+
+		@param userId The NiTE id of the user
+
+		@return A handle to the user, or a null handle if the user is not tracked.
+	*/
+	UserHandle getUserHandle(const nite::UserId userId) const;
+
+	/**
+		Resolve a handle, previously obtained with getUserHandle(), back to the user.
+
+		@param handle The handle of the user
+
+		@return Returns a pointer to the user, or nullptr if the user is no longer tracked.
+	*/
+	KinectUser* getUser(const UserHandle& handle);
+
 	~PoseRecognizer();
 
 
@@ -113,79 +634,225 @@ private:
 	cv::Mat depthMap;
 	cv::Mat bgrImage;
 
+	// were the images of the last grabbed frame already retrieved?
+	bool depthRetrieved = false;
+	bool colorRetrieved = false;
+
+	// the preallocated buffers for the images, recycled between frames
+	FramePool depthPool;
+	FramePool colorPool;
+
+	// the number of the last grabbed frame
+	unsigned long long frameNumber = 0;
+
+	// the last rendered output frame (see getModifiedFrame()) and the number of the frame it was rendered for
+	cv::Mat outputFrame;
+	unsigned long long outputFrameNumber = 0;
+
+	// draws the skeletons and the instruments on the output frame
+	OverlayRenderer overlayRenderer;
+
+	// the output buffers. At least two, so the next frame can be rendered while the previous one is still shown
+	FramePool outputPool = FramePool(4);
+
+	// records the output frames into a video file
+	VideoRecorder videoRecorder;
+
+	// the timestamp of the last processed frame, in microseconds
+	unsigned long long frameTimestamp = 0;
+
+	// logs the pose estimations
+	RecognitionLogWriter recognitionLog;
+
+	/**
+		Decode the depth map / the RGB image of the last grabbed frame, if it wasn't decoded yet
+	*/
+	void retrieveDepth();
+	void retrieveColor();
+
+	// the OpenNI device, that the NiTE tracks the users on
+	openni::Device device;
+
 	// NiTE user tracker, that tracks users on the frame
 	nite::UserTracker userTracker;
 
+	// was the NiTE runtime acquired (see NiteRuntime)?
+	bool niteAcquired = false;
+
 	// status for the NiTE functions
 	nite::Status niteRc;
 
 	// the reference to a frame from the UserTracker
 	nite::UserTrackerFrameRef userTrackerFrame;
 
-	// the visibility status for the users in the frame
-	bool g_visibleUsers[MAX_USERS] = { false };
+	// the frame of skeletons, captured from the user tracker
+	SkeletonFrame liveFrame;
 
-	// the skeleton states for the users
-	nite::SkeletonState g_skeletonStates[MAX_USERS] = { nite::SKELETON_NONE };
+	// the frame, that is being recorded (with the recognized poses)
+	SkeletonFrame recordedFrame;
 
-	// user list
-	std::vector<KinectUser> userList;
+	// records the processed frames into a session file
+	SkeletonSessionWriter sessionWriter;
 
-	// pose data from the files
-	std::vector<KinectPose> poseVector;
+	// is the frame processed live from the Kinect (or replayed)?
+	bool liveMode = false;
 
-	// the number of the current frame. Used for the frame skipping
-	int frameSkip = 0;
+	// records the raw camera streams
+	StreamSessionWriter streamWriter;
 
-	// the flag that says whether we need to skip every few frames or not
-	bool skipFrames = false;
+	// publishes the results to other processes
+	ResultPublisher resultPublisher;
 
-	// current pose number, for which we can add new taining samples.
-	int currentPoseNumber = 0;
+	// delivers the pose events to the subscribers
+	PoseEventDispatcher poseEvents;
 
-	// diplsy debug info about the kikect users or not?
-	bool displayDebug = false;
+	// the replayed camera streams and skeletons
+	StreamSessionReader streamReader;
+	SkeletonSessionReader replaySession;
 
-	// number of nearest neighbours
-	int nearestNeighbours = 7;
+	// the replayed frame of skeletons, and whether it was read ahead of the images
+	SkeletonFrame replayFrame;
+	bool replayFramePending = false;
 
 	/**
-		Read the position data from the files in the provided folder. Every files has to have
-		the .txt file extension and needs to have the following contents:
+		Take the next frame from the replayed files instead of the Kinect
+	*/
+	std::vector<KinectUser*> processReplayFrame();
 
-		Pose_name
-		Degree_of_freedom
-		Left_elbow_angle,Right_elbow_angle;
-		Left_hand_direction,Right_hand_direction;
-		Left_elbow_position;
-		Left_wrist_position;
-		Right_elbow_position;
-		Right_wrist_position;
+	/**
+		A frame, grabbed on the capture thread: the skeletons, the decoded images and when it was grabbed
+	*/
+	struct CapturedFrame {
+		SkeletonFrame skeletons;
+		cv::Mat depth;
+		cv::Mat color;
+		std::chrono::steady_clock::time_point arrival;
+	};
+
+	// passes the grabbed frames from the capture thread to processNextFrame()
+	FrameMailbox<CapturedFrame> captureMailbox;
 
-		here, "Pose_name" is just the name of the pose, like "Flute", "Violin" or "Conducting"
-		"Degree_of_freedom" is the value that determines how much freedom is given to the recognition
-		algorithm when trying to recognize this particular pose. The bigger the value, the more precise
-		the user needs to be when emulating the pose. Values from 15 to 20 are optimal.
+	// grabs the frames, while the capture is on (see startCapture())
+	std::thread captureThread;
+	std::atomic<bool> capturing;
 
-		You can easily add new positions to the system, by adding a new file with only 
-		the first two lines present. To record completely new data for existing pose, remove
-		everything except the first two lines.
+	// the frames, that the NiTE failed to deliver on the capture thread
+	std::atomic<unsigned long long> failedCaptures;
 
-		@param path The name of the folder that contains the pose data.
+	// the latency of the captured frames (see CaptureStatistics), in milliseconds
+	double averageCaptureLatency = 0;
+	double maxCaptureLatency = 0;
 
-		@return Returns the vector of new poses, that were parsed from the files in the folder.
+	/**
+		The loop of the capture thread
 	*/
-	std::vector<KinectPose> initPoseData(const std::string path);
+	void runCapture();
 
 	/**
-		Gets the list of files in the folder. Uses Windows API, so it needs to be reworked
-		for other operating systems
+		Take the next frame from the capture thread instead of the Kinect
+	*/
+	std::vector<KinectUser*> processCapturedFrame();
 
-		@param folder The folder that contains files
+	// the visibility status for the users in the frame
+	bool g_visibleUsers[USER_SLOTS] = { false };
 
-		@return A string vector with the names of files in the folder.
-	*/
-	std::vector<std::string> get_all_files_names_within_folder(std::string folder);
+	// the skeleton states for the users
+	nite::SkeletonState g_skeletonStates[USER_SLOTS] = { nite::SKELETON_NONE };
+
+	// user list. The users are stored in fixed slots indexed by their ids, so the 
+	// pointers returned from processNextFrame() stay valid while the user is tracked
+	UserSlotMap<KinectUser, USER_SLOTS> userList;
+
+	// the skeleton joints of all the users in the current frame, captured once per frame
+	JointSnapshot jointSnapshot = JointSnapshot(USER_SLOTS);
+
+	// the features of all the users, extracted in one batch per feature profile in use
+	FeatureBatch featureBatches[NUM_FEATURE_PROFILES] = { FeatureBatch(USER_SLOTS), FeatureBatch(USER_SLOTS), FeatureBatch(USER_SLOTS) };
+
+	// the projection of the joints on the depth image, captured from the NiTE at initialization
+	DepthProjection depthProjection;
+
+	// pose data from the files. Immutable, possibly shared with other recognizers
+	std::shared_ptr<const PoseModel> poseModel;
+
+	// all the loaded pose libraries
+	std::shared_ptr<PoseModelStore> poseModelStore;
+
+	// the libraries of the store, adjusted to the calibration and the sample capacity of this recognizer,
+	// by their normalized names, with the version from the store they were adjusted from
+	std::map<std::string, std::pair<std::shared_ptr<const PoseModel>, std::shared_ptr<const PoseModel>>> adjustedPoseModels;
+	std::mutex adjustedPoseModelsMutex;
+
+	// the libraries of the users, that don't use the library of the recognizer (or nullptr), indexed by the user id
+	std::shared_ptr<const PoseModel> userPoseModels[USER_SLOTS];
+
+	// the libraries, selected from other threads, and whether they're waiting for the next frame
+	std::shared_ptr<const PoseModel> pendingPoseModel;
+	std::atomic<bool> poseModelPending;
+	std::shared_ptr<const PoseModel> pendingUserPoseModels[USER_SLOTS];
+	std::atomic<bool> userPoseModelPending[USER_SLOTS];
+
+	// recognizes the gestures in the motion of every user
+	GestureRecognizer gestureRecognizer = GestureRecognizer(USER_SLOTS);
+
+	// the gestures, recognized for the current user, reused between the users
+	std::vector<GestureMatch> gestureMatches;
+
+	// the gesture, that is being recorded, and the user who performs it (or -1 until the first frame)
+	bool recordingGesture = false;
+	std::vector<FeatureString> recordedGesture;
+	nite::UserId gestureUser = -1;
+
+	// smooths the joints of all the users
+	JointFilter jointFilter = JointFilter(USER_SLOTS);
+
+	// smooth the joints?
+	bool smoothJoints = false;
+
+	// predicts the drawn joints of all the users
+	JointPredictor jointPredictor = JointPredictor(USER_SLOTS);
+
+	// predict the drawn joints?
+	bool predictJoints = false;
+
+	// the latency of the display, the average time of the rendering and the whole latency of the last
+	// rendered frame, in seconds
+	double displayLatency = DISPLAY_LATENCY / 1000.0;
+	double renderDuration = 0;
+	double predictionLatency = 0;
+
+	// when the last frame arrived
+	std::chrono::steady_clock::time_point frameArrival;
+
+	// the parameters of the pose estimation
+	RecognizerParams params;
+
+	// the precomputed distances to the training samples (or nullptr), and whether they're recorded or read
+	std::shared_ptr<DistanceTable> distanceTable;
+	bool recordDistances = false;
+
+	// the time of computing the distances, that were taken from the table, in milliseconds
+	double distanceTableTime = 0;
+
+	// the number of the current frame. Used for the frame skipping
+	int frameSkip = 0;
+
+	// spreads the pose estimations over the frames, if enabled (see setClassificationSchedule())
+	ClassificationScheduler classificationScheduler = ClassificationScheduler(USER_SLOTS);
+	bool scheduleClassification = false;
+
+	// current pose number, for which we can add new taining samples.
+	int currentPoseNumber = 0;
+
+	// diplsy debug info about the kikect users or not?
+	bool displayDebug = false;
+
+	// calibrate the distance thresholds of the poses for the embedded metric?
+	bool calibrateThresholds = true;
+
+	// the maximum number of the training samples of a pose, and how the new samples replace the old ones
+	int sampleCapacity = POSE_MAX_SAMPLES;
+	SampleEviction sampleEviction = EVICT_REDUNDANT;
 
 	/**
 		Function used for debugging purposes. Displays the information about newly detected
@@ -194,15 +861,42 @@ private:
 		@param user The reference to the current user
 		@param ts The current timestamp
 	*/
-	void updateUserState(const nite::UserData& user, unsigned long long ts);
+	void updateUserState(const SkeletonUser& user, unsigned long long ts);
 	
 	/**
-		Detect all the new and old users in the NiTE-frame and add/update/remove them from the
+		Detect all the new and old users in the frame and add/update/remove them from the
 		user list
 
-		@param users A NiTE Array of NiTE users
+		@param frame The frame with all the users
+	*/
+	void fillUserList(const SkeletonFrame& frame);
+
+	/**
+		Remove the users, that are no longer in the frame. The NiTE reports a lost user only in a single
+		frame, so if that frame was dropped by the capture (see startCapture()), the user would stay forever.
+
+		@param frame The frame with all the users, grabbed from the Kinect
+	*/
+	void removeMissingUsers(const SkeletonFrame& frame);
+
+	/**
+		Remove the user from the user list, and emit the events
+
+		@param userId The id of the user
+		@param timestamp The timestamp of the current frame
+	*/
+	void removeUser(const nite::UserId userId, const unsigned long long timestamp);
+
+	/**
+		Update the users from the frame, and estimate their poses. Used by both
+		processNextFrame() and processSkeletonFrame().
+
+		@param frame The frame with all the users
+		@param arrival When the frame was grabbed (see getPredictionLatency())
+
+		@return Returns a vector of pointers to users, for whom a pose was recognized.
 	*/
-	void fillUserList(const nite::Array<nite::UserData>& users);
+	std::vector<KinectUser*> recognizeFrame(const SkeletonFrame& frame, const std::chrono::steady_clock::time_point arrival);
 
 	/**
 		Estimate the pose of the current user. The method calculates the 'distance' from the
@@ -213,17 +907,73 @@ private:
 		in the user list.
 
 		@param user The reference to the current user, for whom the recognition is performed
+		@param model The pose library of the user
 		@param featureString A vector of features, extracted for the curren user
-		@param nearestNeighbours The parameter for the Nearest Neighbours algorithm. Default: 5.
 
 		@return The number of the recognized pose in the pose vector or -1 if no pose was recognized.
 	*/
-	int estimatePose(KinectUser& user, const FeatureString& featureString, const int nearestNeighbours = 5);
+	int estimatePose(KinectUser& user, const PoseModel& model, const FeatureString& featureString);
+
+	/**
+		Estimate the pose of the user, and report the change of the decision (see PoseEventDispatcher)
+
+		@param user The user
+		@param model The pose library of the user
+		@param featureString The features of the user in this frame
+		@param timestamp The timestamp of the frame
+		@param recognitionResult The user is added, if a pose was recognized
+	*/
+	void classifyUser(KinectUser& user, const PoseModel& model, const FeatureString& featureString, const unsigned long long timestamp, std::vector<KinectUser*>& recognitionResult);
+
+	/**
+		Take over the pose libraries, selected since the last frame (see selectPoseModel()),
+		and reset the poses of the users, whose library has changed
+
+		@param timestamp The timestamp of the current frame
+	*/
+	void switchPoseModels(const unsigned long long timestamp);
+
+	/**
+		Forget the pose of the user, and emit the event if the user was holding a pose
+
+		@param user The reference to the user
+		@param timestamp The timestamp of the current frame
+	*/
+	void resetUserPose(KinectUser& user, const unsigned long long timestamp);
+
+	/**
+		Get the library, the poses of the user are recognized with
+	*/
+	std::shared_ptr<const PoseModel>& getUserPoseModel(KinectUser& user);
+
+	/**
+		Get the library from the store, calibrated the same way as the recognizer's poses. The library
+		is adjusted only once, and then kept until the store gets its new version or the settings change.
+	*/
+	std::shared_ptr<const PoseModel> loadPoseModel(const std::string& folder, const FeatureProfile featureProfile = PROFILE_HEAD);
+
+	/**
+		Add a new training sample to a copy of the library, and write the new version back to the store,
+		so the sample isn't lost when the library is selected again
+
+		@param model The library of the user, replaced with the copy
+		@param poseIndex The index of the pose in the library
+		@param featureString The features of the current frame
+
+		@return Returns "false" if the pose didn't keep the sample.
+	*/
+	bool addTrainingSample(std::shared_ptr<const PoseModel>& model, const int poseIndex, const FeatureString& featureString);
 
 	/**
-		Draws the image of the instrument on the user, instead of simple text
+		Add the features of the current frame to the motion of the user, and report the recognized
+		gestures. Also records the new gesture, if the recording is on.
+
+		@param user The reference to the current user
+		@param featureString A vector of features, extracted for the current user (may be empty)
+		@param timestamp The timestamp of the frame
 	*/
-	void drawInstrument(KinectUser& user, cv::Mat& image);
+	void trackGestures(KinectUser& user, const FeatureString& featureString, const unsigned long long timestamp);
+
 	
 	// Toggle if the feature vector from the current iteration should be added as a training sample
 	bool rememberPose = false;
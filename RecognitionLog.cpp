@@ -0,0 +1,274 @@
+#include "RecognitionLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#define RECOGNITION_LOG_HEADER_SIZE 20    // the magic and four 32-bit values
+
+static void putU32(std::ostream& out, const unsigned int value) {
+	out.write((const char*)&value, 4);
+}
+
+static bool getU32(std::istream& in, unsigned int& value) {
+	return (bool)in.read((char*)&value, 4);
+}
+
+/**
+	Read the header of the log, and check that the records have the same layout
+*/
+static bool readHeader(std::istream& in) {
+
+	char magic[4];
+	unsigned int version, recordSize, topK, featureSlots;
+
+	if (!in.read(magic, 4) || std::memcmp(magic, RECOGNITION_LOG_MAGIC, 4) != 0)
+		return false;
+
+	if (!getU32(in, version) || !getU32(in, recordSize) || !getU32(in, topK) || !getU32(in, featureSlots))
+		return false;
+
+	return version == RECOGNITION_LOG_VERSION && recordSize == sizeof(RecognitionRecord)
+		&& topK == RECOGNITION_LOG_TOP_K && featureSlots == FeatureSchema::size;
+}
+
+// RecognitionLogWriter
+
+RecognitionLogWriter::RecognitionLogWriter() : committed(0), written(0), dropped(0), stopping(false), opened(false) {
+}
+
+bool RecognitionLogWriter::open(const std::string& fileName) {
+
+	close();
+
+	// an existing log is continued, if it has the same layout
+	std::streamoff existingSize = 0;
+	{
+		std::ifstream existing(fileName, std::ios::in | std::ios::binary | std::ios::ate);
+
+		if (existing.is_open() && (existingSize = existing.tellg()) > 0) {
+			existing.seekg(0);
+
+			if (!readHeader(existing)) {
+				std::cerr << "The recognition log " << fileName << " has a different format" << std::endl;
+				return false;
+			}
+		}
+	}
+
+	ofs.open(fileName, std::ios::out | std::ios::binary | std::ios::app);
+
+	if (!ofs.is_open()) {
+		std::cerr << "Couldn't open the recognition log " << fileName << std::endl;
+		return false;
+	}
+
+	if (existingSize <= 0) {
+		ofs.write(RECOGNITION_LOG_MAGIC, 4);
+		putU32(ofs, RECOGNITION_LOG_VERSION);
+		putU32(ofs, sizeof(RecognitionRecord));
+		putU32(ofs, RECOGNITION_LOG_TOP_K);
+		putU32(ofs, FeatureSchema::size);
+	}
+	else {
+		// complete the record, that was cut off (e.g. by a crash), with zeros, so the next ones are aligned. The reader skips it
+		std::streamoff partial = (existingSize - RECOGNITION_LOG_HEADER_SIZE) % sizeof(RecognitionRecord);
+
+		if (partial > 0) {
+			std::vector<char> padding((size_t)(sizeof(RecognitionRecord) - partial), 0);
+			ofs.write(padding.data(), padding.size());
+		}
+	}
+
+	ring.assign(RECOGNITION_LOG_SLOTS, RecognitionRecord());
+	committed = 0;
+	written = 0;
+	dropped = 0;
+	stopping = false;
+	opened = true;
+
+	writerThread = std::thread(&RecognitionLogWriter::run, this);
+
+	return true;
+}
+
+bool RecognitionLogWriter::isOpen() const {
+	// the file itself belongs to the writer thread
+	return this->opened;
+}
+
+RecognitionRecord* RecognitionLogWriter::beginRecord() {
+
+	unsigned long long head = committed.load(std::memory_order_relaxed);
+
+	// the writer thread hasn't written the oldest record yet
+	if (head - written.load(std::memory_order_acquire) >= ring.size()) {
+		dropped++;
+		return nullptr;
+	}
+
+	return &ring[head & (ring.size() - 1)];
+}
+
+void RecognitionLogWriter::commitRecord() {
+
+	unsigned long long head = committed.load(std::memory_order_relaxed);
+
+	ring[head & (ring.size() - 1)].end = RECOGNITION_LOG_RECORD_END;
+
+	committed.store(head + 1, std::memory_order_release);
+}
+
+void RecognitionLogWriter::run() {
+
+	while (!stopping) {
+		flush();
+		std::this_thread::sleep_for(std::chrono::milliseconds(RECOGNITION_LOG_FLUSH_INTERVAL));
+	}
+
+	// everything committed before stopping
+	flush();
+
+	ofs.close();
+	opened = false;
+}
+
+void RecognitionLogWriter::flush() {
+
+	unsigned long long end = committed.load(std::memory_order_acquire);
+	unsigned long long begin = written.load(std::memory_order_relaxed);
+
+	if (begin == end)
+		return;
+
+	while (begin < end) {
+		// the records up to the end of the ring at once
+		size_t index = (size_t)(begin & (ring.size() - 1));
+		size_t count = (size_t)(std::min)(end - begin, (unsigned long long)(ring.size() - index));
+
+		ofs.write((const char*)&ring[index], count * sizeof(RecognitionRecord));
+
+		begin += count;
+
+		// the slots can be reused
+		written.store(begin, std::memory_order_release);
+	}
+
+	ofs.flush();
+}
+
+void RecognitionLogWriter::close() {
+
+	if (!writerThread.joinable())
+		return;
+
+	// the writer thread writes the rest and closes the file
+	stopping = true;
+	writerThread.join();
+
+	if (dropped > 0)
+		std::cerr << "Recognition log: " << dropped << " records were dropped" << std::endl;
+}
+
+unsigned long long RecognitionLogWriter::getWrittenRecords() const {
+	return this->written;
+}
+
+unsigned long long RecognitionLogWriter::getDroppedRecords() const {
+	return this->dropped;
+}
+
+RecognitionLogWriter::~RecognitionLogWriter() {
+	close();
+}
+
+// RecognitionLogReader
+
+bool RecognitionLogReader::open(const std::string& fileName) {
+
+	close();
+
+	ifs.open(fileName, std::ios::in | std::ios::binary);
+
+	if (!ifs.is_open()) {
+		std::cerr << "Couldn't open the recognition log " << fileName << std::endl;
+		return false;
+	}
+
+	if (!readHeader(ifs)) {
+		std::cerr << "The recognition log " << fileName << " has a different format" << std::endl;
+		ifs.close();
+		return false;
+	}
+
+	return true;
+}
+
+bool RecognitionLogReader::isOpen() const {
+	return ifs.is_open();
+}
+
+bool RecognitionLogReader::readNext(RecognitionRecord& record) {
+
+	if (!ifs.is_open())
+		return false;
+
+	while (ifs.read((char*)&record, sizeof(RecognitionRecord))) {
+
+		// otherwise it's a record, that was cut off
+		if (record.end == RECOGNITION_LOG_RECORD_END)
+			return true;
+	}
+
+	return false;
+}
+
+void RecognitionLogReader::close() {
+	if (ifs.is_open())
+		ifs.close();
+
+	ifs.clear();
+}
+
+bool RecognitionLogReader::dump(const std::string& fileName, std::ostream& os) {
+
+	RecognitionLogReader reader;
+
+	if (!reader.open(fileName))
+		return false;
+
+	os << "frame,timestamp,user,candidate,decision,samples,margin,multiplier";
+
+	for (int i = 0; i < RECOGNITION_LOG_TOP_K; i++) {
+		os << ",pose" << i + 1 << ",distance" << i + 1;
+	}
+
+	for (int i = 0; i < FeatureSchema::size; i++) {
+		os << ",feature" << i << "x,feature" << i << "y";
+	}
+
+	os << std::endl;
+
+	RecognitionRecord record;
+
+	while (reader.readNext(record)) {
+		os << record.frameNumber << "," << record.timestamp << "," << record.userId << ","
+			<< record.candidate << "," << record.decision << "," << record.sampleCount << ","
+			<< record.margin << "," << record.thresholdMultiplier;
+
+		for (int i = 0; i < RECOGNITION_LOG_TOP_K; i++) {
+			if (i < record.topCount)
+				os << "," << record.topPoses[i] << "," << record.topDistances[i];
+			else
+				os << ",,";
+		}
+
+		for (int i = 0; i < FeatureSchema::size; i++) {
+			os << "," << record.features[i][0] << "," << record.features[i][1];
+		}
+
+		os << std::endl;
+	}
+
+	return true;
+}
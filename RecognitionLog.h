@@ -0,0 +1,198 @@
+#pragma once
+
+#include "FeatureSchema.h"
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define RECOGNITION_LOG_MAGIC "MPRL"         // the first 4 bytes of the log file
+#define RECOGNITION_LOG_VERSION 1            // the version of the record layout
+#define RECOGNITION_LOG_SLOTS 4096           // the number of records staged in memory (a power of two; ~14 s of 10 users at 30 FPS)
+#define RECOGNITION_LOG_TOP_K 8              // the number of the nearest training samples in a record
+#define RECOGNITION_LOG_FLUSH_INTERVAL 50    // how often the writer thread writes the staged records, in milliseconds
+#define RECOGNITION_LOG_RECORD_END 0x454C524D  // the last field of every complete record ("MRLE")
+
+/**
+	One pose estimation of one user (see PoseRecognizer::estimatePose()). Only fixed-size plain
+	types, so the records are written to the file as they are.
+*/
+struct RecognitionRecord {
+
+	// the number of the frame, and its timestamp in microseconds
+	unsigned long long frameNumber;
+	unsigned long long timestamp;
+
+	// the NiTE id of the user
+	int userId;
+
+	// the pose with the most votes of the nearest neighbours in this frame (or -1), and the recognized
+	// pose after the hold (or -1)
+	int candidate;
+	int decision;
+
+	// the number of the training samples within the thresholds
+	int sampleCount;
+
+	// how far inside the threshold is the nearest sample of the candidate (see KinectUser::getPoseMargin())
+	float margin;
+
+	// the factor of the distance thresholds for the distance of the user (see RecognizerParams::getThresholdMultiplier())
+	float thresholdMultiplier;
+
+	// the nearest training samples: their poses and distances, the nearest first
+	int topCount;
+	int topPoses[RECOGNITION_LOG_TOP_K];
+	float topDistances[RECOGNITION_LOG_TOP_K];
+
+	// the features of the user (see FeatureString)
+	float features[FeatureSchema::size][2];
+
+	// RECOGNITION_LOG_RECORD_END, set by the writer. A record cut off at the end of the file doesn't have it
+	unsigned int end;
+};
+
+/**
+	Logs the pose estimations of every frame into an append-only binary file, for the analytics.
+
+	The recognition thread fills the records directly in a fixed ring of RECOGNITION_LOG_SLOTS
+	records in memory (see beginRecord()). The ring has a single producer and a single consumer,
+	so it only needs two atomic counters: the recognition thread never takes a lock, never waits
+	and never allocates, and if the ring is full, the record is dropped and counted. A background
+	thread writes the staged records to the file every RECOGNITION_LOG_FLUSH_INTERVAL milliseconds.
+
+	The file starts with a header: RECOGNITION_LOG_MAGIC, the version, the size of a record,
+	RECOGNITION_LOG_TOP_K and the number of the feature slots (all 32-bit), followed by the records.
+	An existing log with the same layout is appended to. See RecognitionLogReader.
+*/
+class RecognitionLogWriter {
+
+public:
+	RecognitionLogWriter();
+
+	/**
+		Open the log file, and start the writer thread
+
+		@param fileName The path to the log file. If it exists, the records are appended.
+
+		@return Returns "false" if the file couldn't be opened, or it has a different layout.
+	*/
+	bool open(const std::string& fileName);
+
+	/**
+		Check if the log is open. Can be called from any thread.
+	*/
+	bool isOpen() const;
+
+	/**
+		Get the next free record in the ring. Only from one thread (the recognition thread).
+
+		@return Returns the record to fill, or nullptr if the ring is full (the record is dropped).
+	*/
+	RecognitionRecord* beginRecord();
+
+	/**
+		Hand over the record, filled since beginRecord(), to the writer thread
+	*/
+	void commitRecord();
+
+	/**
+		Write all the staged records, stop the writer thread and close the file
+	*/
+	void close();
+
+	/**
+		Get the number of the records written to the file so far
+	*/
+	unsigned long long getWrittenRecords() const;
+
+	/**
+		Get the number of the records dropped, because the ring was full
+	*/
+	unsigned long long getDroppedRecords() const;
+
+	~RecognitionLogWriter();
+
+private:
+	// the output file
+	std::ofstream ofs;
+
+	// the ring of the staged records
+	std::vector<RecognitionRecord> ring;
+
+	// the number of the records committed by the recognition thread, and written by the writer thread.
+	// Each is changed only by its own thread
+	std::atomic<unsigned long long> committed;
+	std::atomic<unsigned long long> written;
+
+	// the records dropped by the recognition thread
+	std::atomic<unsigned long long> dropped;
+
+	// the writer thread
+	std::thread writerThread;
+	std::atomic<bool> stopping;
+
+	// the file is open. Set before the writer thread starts, and cleared by it, once it has closed the file
+	std::atomic<bool> opened;
+
+	/**
+		The loop of the writer thread
+	*/
+	void run();
+
+	/**
+		Write all the committed records
+	*/
+	void flush();
+};
+
+/**
+	Reads the log, written by the RecognitionLogWriter
+*/
+class RecognitionLogReader {
+
+public:
+	/**
+		Open the log file
+
+		@param fileName The path to the log file
+
+		@return Returns "false" if the file couldn't be opened, or it has a different layout.
+	*/
+	bool open(const std::string& fileName);
+
+	/**
+		Check if the log is open
+	*/
+	bool isOpen() const;
+
+	/**
+		Read the next record
+
+		@param record The record
+		@return Returns "false" at the end of the log.
+	*/
+	bool readNext(RecognitionRecord& record);
+
+	/**
+		Close the log file
+	*/
+	void close();
+
+	/**
+		Print the whole log as CSV (one line per record), e.g. for a spreadsheet
+
+		@param fileName The path to the log file
+		@param os The output
+
+		@return Returns "false" if the log couldn't be opened.
+	*/
+	static bool dump(const std::string& fileName, std::ostream& os);
+
+private:
+	// the input file
+	std::ifstream ifs;
+};
@@ -0,0 +1,316 @@
+#include "ReplayBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iomanip>
+
+/**
+	The reference and the recognized poses of one user during the replay
+*/
+struct BenchmarkTrack {
+
+	// the current reference pose, the frame and the time it started at, and whether it was already recognized
+	int reference = -1;
+	unsigned long long referenceFrame = 0;
+	unsigned long long referenceTimestamp = 0;
+	bool recognized = false;
+
+	// the current recognized pose, and the frame it started at
+	int decision = -1;
+	unsigned long long decisionFrame = 0;
+};
+
+/**
+	A drawn joint, waiting for the frame of its display time
+*/
+struct PendingJoint {
+
+	// the display time, in microseconds
+	unsigned long long target;
+
+	int slot;
+	int joint;
+
+	// where the joint is drawn without and with the prediction
+	cv::Point2f stale;
+	cv::Point2f predicted;
+};
+
+/**
+	Get the mean and the 95th percentile of the errors
+*/
+static void summarize(std::vector<double>& errors, double& mean, double& p95) {
+
+	if (errors.empty())
+		return;
+
+	double sum = 0;
+	for (double error : errors) {
+		sum += error;
+	}
+
+	mean = sum / errors.size();
+
+	std::vector<double>::iterator percentile = errors.begin() + (errors.size() * 95) / 100;
+	std::nth_element(errors.begin(), percentile, errors.end());
+	p95 = *percentile;
+}
+
+ReplayBenchmark::ReplayBenchmark(const std::shared_ptr<const PoseModel>& poseModel) {
+	this->poseModel = poseModel;
+}
+
+bool ReplayBenchmark::run(const std::string& sessionFile, const BenchmarkSettings& settings, BenchmarkResult& result) {
+
+	SkeletonSessionReader reader;
+
+	if (!reader.open(sessionFile))
+		return false;
+
+	// read the whole session first, so only the recognition is timed
+	std::vector<SkeletonFrame> frames;
+	SkeletonFrame frame;
+
+	while (reader.readNextFrame(frame)) {
+		frames.push_back(frame);
+	}
+
+	std::unique_ptr<PoseRecognizer> recognizer(new PoseRecognizer());
+	recognizer->setPoseModel(poseModel);
+	recognizer->setDepthProjection(reader.getProjection());
+	recognizer->setJointSmoothing(settings.smoothing);
+	recognizer->setPoseHold(settings.poseHold);
+
+	result = BenchmarkResult();
+	run(*recognizer, frames, result);
+	result.settings = settings;
+
+	return true;
+}
+
+void ReplayBenchmark::run(PoseRecognizer& recognizer, const std::vector<SkeletonFrame>& frames, BenchmarkResult& result) {
+
+	BenchmarkTrack tracks[USER_SLOTS];
+
+	double totalFramesToPose = 0;
+	double totalMillisecondsToPose = 0;
+	unsigned long long matchedUserFrames = 0;
+	std::chrono::steady_clock::duration processing(0);
+
+	unsigned long long firstTimestamp = 0;
+	unsigned long long lastTimestamp = 0;
+
+	for (const SkeletonFrame& frame : frames) {
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		recognizer.processSkeletonFrame(frame);
+		processing += std::chrono::steady_clock::now() - start;
+
+		if (result.frames == 0)
+			firstTimestamp = frame.timestamp;
+		lastTimestamp = frame.timestamp;
+
+		for (const SkeletonUser& user : frame.users) {
+			if (user.getId() < 0 || user.getId() >= USER_SLOTS)
+				continue;
+
+			BenchmarkTrack& track = tracks[user.getId()];
+
+			KinectUser* kinectUser = recognizer.getUser(recognizer.getUserHandle(user.getId()));
+			int decision = (kinectUser != nullptr && !user.isLost()) ? kinectUser->getPoseIndex() : -1;
+			int reference = user.isLost() ? -1 : user.poseIndex;
+
+			if (!user.isLost()) {
+				result.userFrames++;
+
+				if (decision == reference)
+					matchedUserFrames++;
+			}
+
+			// a new reference pose has started
+			if (reference != track.reference) {
+				track.reference = reference;
+				track.referenceFrame = result.frames;
+				track.referenceTimestamp = frame.timestamp;
+				track.recognized = false;
+
+				if (reference >= 0)
+					result.referencePoses++;
+			}
+
+			if (reference >= 0 && !track.recognized && decision == reference) {
+				track.recognized = true;
+				result.recognizedPoses++;
+
+				totalFramesToPose += (double)(result.frames - track.referenceFrame);
+				totalMillisecondsToPose += (frame.timestamp - track.referenceTimestamp) / 1000.0;
+			}
+
+			// the recognized pose has changed
+			if (decision != track.decision) {
+				if (track.decision >= 0 && result.frames - track.decisionFrame < BENCHMARK_FLICKER_FRAMES)
+					result.flickers++;
+
+				track.decision = decision;
+				track.decisionFrame = result.frames;
+			}
+		}
+
+		result.frames++;
+	}
+
+	if (result.recognizedPoses > 0) {
+		result.framesToPose = totalFramesToPose / result.recognizedPoses;
+		result.millisecondsToPose = totalMillisecondsToPose / result.recognizedPoses;
+	}
+
+	if (result.userFrames > 0)
+		result.accuracy = (double)matchedUserFrames / result.userFrames;
+
+	result.minutes = (lastTimestamp - firstTimestamp) / 60e6;
+
+	if (result.minutes > 0)
+		result.flickersPerMinute = result.flickers / result.minutes;
+
+	if (result.frames > 0)
+		result.millisecondsPerFrame = std::chrono::duration<double, std::milli>(processing).count() / result.frames;
+}
+
+std::vector<BenchmarkResult> ReplayBenchmark::compare(const std::string& sessionFile, const std::vector<BenchmarkSettings>& settings) {
+
+	std::vector<BenchmarkResult> results;
+
+	for (const BenchmarkSettings& setting : settings) {
+		BenchmarkResult result;
+
+		if (run(sessionFile, setting, result))
+			results.push_back(result);
+	}
+
+	return results;
+}
+
+void ReplayBenchmark::print(std::ostream& os, const std::vector<BenchmarkResult>& results) {
+
+	os << std::left << std::setw(24) << "Settings" << std::right
+		<< std::setw(10) << "Frames" << std::setw(12) << "Recognized"
+		<< std::setw(10) << "Accuracy" << std::setw(12) << "To pose" << std::setw(12) << "To pose ms"
+		<< std::setw(10) << "Flicker" << std::setw(12) << "Flicker/min"
+		<< std::setw(10) << "ms/frame" << std::endl;
+
+	os << std::fixed << std::setprecision(2);
+
+	for (const BenchmarkResult& result : results) {
+		os << std::left << std::setw(24) << result.settings.name << std::right
+			<< std::setw(10) << result.frames
+			<< std::setw(12) << (std::to_string(result.recognizedPoses) + "/" + std::to_string(result.referencePoses))
+			<< std::setw(10) << result.accuracy * 100 << std::setw(12) << result.framesToPose << std::setw(12) << result.millisecondsToPose
+			<< std::setw(10) << result.flickers << std::setw(12) << result.flickersPerMinute
+			<< std::setw(10) << result.millisecondsPerFrame << std::endl;
+	}
+
+	os << std::defaultfloat;
+}
+
+bool ReplayBenchmark::measureOverlayError(const std::string& sessionFile, const double latency, OverlayErrorResult& result) {
+
+	SkeletonSessionReader reader;
+
+	if (!reader.open(sessionFile))
+		return false;
+
+	result = OverlayErrorResult();
+	result.latency = latency;
+
+	const DepthProjection projection = reader.getProjection();
+	const unsigned long long delay = (unsigned long long)(latency * 1000);
+
+	JointSnapshot snapshot(USER_SLOTS);
+	JointPredictor predictor(USER_SLOTS);
+
+	// the projected joints of the previous frame, to interpolate the true positions between the frames
+	JointSnapshot previous(USER_SLOTS);
+	unsigned long long previousTimestamp = 0;
+
+	std::deque<PendingJoint> pending;
+	std::vector<double> staleErrors, predictedErrors;
+
+	SkeletonFrame frame;
+
+	while (reader.readNextFrame(frame)) {
+
+		for (const SkeletonUser& user : frame.users) {
+			if (user.getId() < 0 || user.getId() >= USER_SLOTS)
+				continue;
+
+			if (user.isLost())
+				snapshot.clear(user.getId());
+			else
+				snapshot.capture(user.getId(), user.positions, user.confidences);
+		}
+
+		projection.projectAll(snapshot);
+
+		// compare the joints, that are shown between the previous frame and this one
+		while (!pending.empty() && pending.front().target <= frame.timestamp) {
+			const PendingJoint& joint = pending.front();
+			const nite::JointType type = (nite::JointType)joint.joint;
+
+			if (snapshot.isValid(joint.slot) && previous.isValid(joint.slot)) {
+				float t = (frame.timestamp > previousTimestamp) ? (float)(joint.target - previousTimestamp) / (frame.timestamp - previousTimestamp) : 1.f;
+
+				cv::Point2f from = previous.getDepthPosition(joint.slot, type);
+				cv::Point2f truth = from + (snapshot.getDepthPosition(joint.slot, type) - from) * t;
+
+				staleErrors.push_back(calcDistance(joint.stale, truth));
+				predictedErrors.push_back(calcDistance(joint.predicted, truth));
+			}
+
+			pending.pop_front();
+		}
+
+		predictor.update(snapshot, frame.timestamp);
+		predictor.predict(snapshot, (float)(latency / 1000));
+
+		// the joints of the upper body, that are drawn (see KinectUser::drawUserSkeleton())
+		for (int slot = 0; slot < USER_SLOTS; slot++) {
+			if (!snapshot.isValid(slot))
+				continue;
+
+			for (int j = nite::JOINT_HEAD; j <= nite::JOINT_RIGHT_HAND; j++) {
+				if (snapshot.getConfidence(slot, (nite::JointType)j) <= 0.5f)
+					continue;
+
+				PendingJoint joint;
+				joint.target = frame.timestamp + delay;
+				joint.slot = slot;
+				joint.joint = j;
+				joint.stale = snapshot.getDepthPosition(slot, (nite::JointType)j);
+				joint.predicted = snapshot.getDisplayPosition(slot, (nite::JointType)j);
+
+				pending.push_back(joint);
+			}
+		}
+
+		previous = snapshot;
+		previousTimestamp = frame.timestamp;
+	}
+
+	result.samples = staleErrors.size();
+
+	summarize(staleErrors, result.staleMean, result.staleP95);
+	summarize(predictedErrors, result.predictedMean, result.predictedP95);
+
+	return true;
+}
+
+void ReplayBenchmark::print(std::ostream& os, const OverlayErrorResult& result) {
+
+	os << std::fixed << std::setprecision(2)
+		<< "Overlay error at " << result.latency << " ms latency, " << result.samples << " joints:" << std::endl
+		<< "  without prediction: " << result.staleMean << " px mean, " << result.staleP95 << " px 95th percentile" << std::endl
+		<< "  with prediction:    " << result.predictedMean << " px mean, " << result.predictedP95 << " px 95th percentile" << std::endl;
+
+	os << std::defaultfloat;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "PoseRecognizer.h"
+
+#define BENCHMARK_FLICKER_FRAMES 10    // a recognized pose, that lasts fewer frames than this, counts as a flicker
+
+/**
+	One configuration of the recognizer to benchmark
+*/
+struct BenchmarkSettings {
+
+	// the name of the configuration in the report
+	std::string name;
+
+	// smooth the joints (see PoseRecognizer::setJointSmoothing())
+	bool smoothing;
+
+	// the pose hold (see PoseRecognizer::setPoseHold())
+	int poseHold;
+};
+
+/**
+	The results of one configuration
+*/
+struct BenchmarkResult {
+
+	BenchmarkSettings settings;
+
+	// the number of the replayed frames, and their length in minutes
+	unsigned long long frames = 0;
+	double minutes = 0;
+
+	// the number of the tracked users in all the frames, and the share of them, for which the
+	// recognized pose was the same as the reference (including no pose)
+	unsigned long long userFrames = 0;
+	double accuracy = 0;
+
+	// the number of the reference poses (see ReplayBenchmark), and how many of them were recognized
+	int referencePoses = 0;
+	int recognizedPoses = 0;
+
+	// the average time from the start of the reference pose to its recognition, in frames and in milliseconds
+	double framesToPose = 0;
+	double millisecondsToPose = 0;
+
+	// the number of the recognized poses, that lasted fewer than BENCHMARK_FLICKER_FRAMES frames,
+	// and the same per minute of the recording
+	int flickers = 0;
+	double flickersPerMinute = 0;
+
+	// the average processing time of a frame, in milliseconds
+	double millisecondsPerFrame = 0;
+};
+
+/**
+	The error of the drawn joints (see JointPredictor), measured on a recorded session
+*/
+struct OverlayErrorResult {
+
+	// the latency from the frame to the display, in milliseconds
+	double latency = 0;
+
+	// the number of the compared joints
+	unsigned long long samples = 0;
+
+	// the distance in pixels between the true position of the joint at the display time, and the position
+	// it's drawn at: without the prediction (the position of the frame), and with the prediction.
+	// The mean and the 95th percentile
+	double staleMean = 0;
+	double staleP95 = 0;
+	double predictedMean = 0;
+	double predictedP95 = 0;
+};
+
+/**
+	Replays a skeleton session (see SkeletonSessionReader) through the recognizer with different
+	settings, to show how quickly the poses are recognized, and how stable the recognition is.
+
+	The reference are the poses, stored in the session file together with the skeletons
+	(the decisions of the recognizer, that recorded the session, or the labels added later):
+	a reference pose starts when the stored pose of the user changes to a pose, and the time to
+	the pose is measured from there, until the replayed recognizer decides the same. The flicker
+	is counted without the reference: every recognized pose, that was left again within
+	BENCHMARK_FLICKER_FRAMES frames, is a flicker.
+*/
+class ReplayBenchmark {
+
+public:
+	/**
+		Create the benchmark
+
+		@param poseModel The poses to recognize
+	*/
+	ReplayBenchmark(const std::shared_ptr<const PoseModel>& poseModel);
+
+	/**
+		Replay the session with the settings
+
+		@param sessionFile The path to the skeleton session file (see PoseRecognizer::startRecording())
+		@param settings The settings of the recognizer
+		@param result The results
+
+		@return Returns "false" if the session couldn't be opened.
+	*/
+	bool run(const std::string& sessionFile, const BenchmarkSettings& settings, BenchmarkResult& result);
+
+	/**
+		Replay the frames through an already configured recognizer, and score its decisions.
+		The settings of the result are left as they are.
+
+		@param recognizer The recognizer, that hasn't processed any frames yet
+		@param frames The frames of the session
+		@param result The results
+	*/
+	static void run(PoseRecognizer& recognizer, const std::vector<SkeletonFrame>& frames, BenchmarkResult& result);
+
+	/**
+		Replay the session with every one of the settings
+
+		@param sessionFile The path to the skeleton session file
+		@param settings The configurations to compare
+
+		@return The results of all the configurations, that could be run
+	*/
+	std::vector<BenchmarkResult> compare(const std::string& sessionFile, const std::vector<BenchmarkSettings>& settings);
+
+	/**
+		Print the results as a table
+	*/
+	static void print(std::ostream& os, const std::vector<BenchmarkResult>& results);
+
+	/**
+		Measure, how far from the true position the joints of the upper body (the ones drawn on the
+		frame) would be drawn, if the frame was shown after the latency. The true position is taken
+		from the later frames of the session, interpolated to the display time.
+
+		@param sessionFile The path to the skeleton session file
+		@param latency The latency from the frame to the display, in milliseconds (see PoseRecognizer::getPredictionLatency())
+		@param result The errors with and without the prediction
+
+		@return Returns "false" if the session couldn't be opened.
+	*/
+	static bool measureOverlayError(const std::string& sessionFile, const double latency, OverlayErrorResult& result);
+
+	/**
+		Print the overlay errors
+	*/
+	static void print(std::ostream& os, const OverlayErrorResult& result);
+
+private:
+	// the poses to recognize
+	std::shared_ptr<const PoseModel> poseModel;
+};
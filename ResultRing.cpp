@@ -0,0 +1,235 @@
+#include "ResultRing.h"
+
+#include <cstring>
+#include <new>
+
+// ResultPublisher
+
+ResultPublisher::ResultPublisher() {
+}
+
+bool ResultPublisher::open(const std::string& name) {
+
+	close();
+
+	mapping = ::CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(SharedResultRing), name.c_str());
+
+	// another publisher owns the ring (or its readers still hold it), initializing it again would break the readers
+	if (mapping != NULL && ::GetLastError() == ERROR_ALREADY_EXISTS) {
+		std::cerr << "The shared memory " << name << " is already in use" << std::endl;
+		close();
+		return false;
+	}
+
+	if (mapping != NULL)
+		ring = (SharedResultRing*)::MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(SharedResultRing));
+
+	if (ring == nullptr) {
+		std::cerr << "Couldn't create the shared memory " << name << std::endl;
+		close();
+		return false;
+	}
+
+	// the memory is zeroed by the system, the atomics only need to be constructed
+	ring->magic = RESULT_RING_MAGIC;
+	ring->version = RESULT_RING_VERSION;
+	ring->slotCount = RESULT_RING_SLOTS;
+	ring->slotSize = sizeof(SharedResultSlot);
+
+	new (&ring->published) std::atomic<unsigned long long>(0);
+
+	for (SharedResultSlot& slot : ring->slots) {
+		new (&slot.sequence) std::atomic<unsigned long long>(0);
+	}
+
+	frameNumber = 0;
+
+	return true;
+}
+
+bool ResultPublisher::isOpen() const {
+	return ring != nullptr;
+}
+
+void ResultPublisher::publish(const unsigned long long timestamp, const std::vector<KinectUser*>& users) {
+
+	if (ring == nullptr)
+		return;
+
+	SharedResultSlot& slot = ring->slots[frameNumber % RESULT_RING_SLOTS];
+
+	// mark the slot as being written
+	slot.sequence.store(2 * frameNumber + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	SharedFrameResult& record = slot.record;
+	record.frameNumber = frameNumber;
+	record.timestamp = timestamp;
+	record.userCount = 0;
+
+	for (KinectUser* user : users) {
+		if (record.userCount >= RESULT_MAX_USERS)
+			break;
+
+		SharedUserResult& result = record.users[record.userCount++];
+
+		result.userId = user->getUserId();
+		result.poseIndex = user->getPoseIndex();
+
+		std::string poseName = user->getPoseName();
+		size_t length = (std::min)(poseName.size(), (size_t)RESULT_POSE_NAME_LENGTH - 1);
+		std::memcpy(result.poseName, poseName.c_str(), length);
+		result.poseName[length] = 0;
+
+		for (int j = 0; j < RESULT_KEY_JOINTS; j++) {
+			cv::Point3f joint = user->extractJoint3D(RESULT_KEY_JOINT_TYPES[j]);
+			result.joints[j][0] = joint.x;
+			result.joints[j][1] = joint.y;
+			result.joints[j][2] = joint.z;
+		}
+	}
+
+	// the record is complete
+	slot.sequence.store(2 * frameNumber + 2, std::memory_order_release);
+	ring->published.store(++frameNumber, std::memory_order_release);
+}
+
+void ResultPublisher::close() {
+
+	if (ring != nullptr)
+		::UnmapViewOfFile(ring);
+
+	if (mapping != NULL)
+		::CloseHandle(mapping);
+
+	ring = nullptr;
+	mapping = NULL;
+}
+
+ResultPublisher::~ResultPublisher() {
+	close();
+}
+
+// ResultSubscriber
+
+ResultSubscriber::ResultSubscriber() {
+}
+
+bool ResultSubscriber::open(const std::string& name) {
+
+	close();
+
+	mapping = ::OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+
+	if (mapping != NULL)
+		ring = (const SharedResultRing*)::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(SharedResultRing));
+
+	if (ring == nullptr) {
+		std::cerr << "Couldn't open the shared memory " << name << std::endl;
+		close();
+		return false;
+	}
+
+	if (ring->magic != RESULT_RING_MAGIC || ring->version != RESULT_RING_VERSION ||
+		ring->slotCount != RESULT_RING_SLOTS || ring->slotSize != sizeof(SharedResultSlot)) {
+		std::cerr << "The shared memory " << name << " has a different version of the records" << std::endl;
+		close();
+		return false;
+	}
+
+	// start with the frames, published from now on
+	nextFrame = ring->published.load(std::memory_order_acquire);
+	missedFrames = 0;
+
+	return true;
+}
+
+bool ResultSubscriber::isOpen() const {
+	return ring != nullptr;
+}
+
+bool ResultSubscriber::readFrame(const unsigned long long frame, SharedFrameResult& result) const {
+
+	const SharedResultSlot& slot = ring->slots[frame % RESULT_RING_SLOTS];
+
+	unsigned long long expected = 2 * frame + 2;
+
+	if (slot.sequence.load(std::memory_order_acquire) != expected)
+		return false;
+
+	std::memcpy(&result, &slot.record, sizeof(SharedFrameResult));
+
+	// the record must not have changed while it was copied
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	return slot.sequence.load(std::memory_order_relaxed) == expected;
+}
+
+bool ResultSubscriber::readLatest(SharedFrameResult& result) {
+
+	if (ring == nullptr)
+		return false;
+
+	unsigned long long published = ring->published.load(std::memory_order_acquire);
+
+	if (published <= nextFrame || published == 0)
+		return false;
+
+	// the latest frame can only be overwritten, if the publisher went around the whole ring meanwhile
+	if (!readFrame(published - 1, result))
+		return false;
+
+	missedFrames += published - 1 - nextFrame;
+	nextFrame = published;
+
+	return true;
+}
+
+bool ResultSubscriber::readNext(SharedFrameResult& result) {
+
+	if (ring == nullptr)
+		return false;
+
+	while (true) {
+		unsigned long long published = ring->published.load(std::memory_order_acquire);
+
+		if (published <= nextFrame)
+			return false;
+
+		// jump to the oldest frame still in the ring
+		if (published - nextFrame > RESULT_RING_SLOTS - 1) {
+			unsigned long long oldest = published - (RESULT_RING_SLOTS - 1);
+			missedFrames += oldest - nextFrame;
+			nextFrame = oldest;
+		}
+
+		if (readFrame(nextFrame, result)) {
+			nextFrame++;
+			return true;
+		}
+
+		// overwritten while copying, try again with a newer frame
+		missedFrames++;
+		nextFrame++;
+	}
+}
+
+unsigned long long ResultSubscriber::getMissedFrames() const {
+	return this->missedFrames;
+}
+
+void ResultSubscriber::close() {
+
+	if (ring != nullptr)
+		::UnmapViewOfFile(ring);
+
+	if (mapping != NULL)
+		::CloseHandle(mapping);
+
+	ring = nullptr;
+	mapping = NULL;
+}
+
+ResultSubscriber::~ResultSubscriber() {
+	close();
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "KinectUser.h"
+
+#include <Windows.h>
+
+#include <atomic>
+#include <iostream>
+#include <string>
+
+#define RESULT_RING_NAME "MusicalPoseRecognizer.Results"   // the default name of the shared memory
+#define RESULT_RING_MAGIC 0x4B52504D                        // "MPRK"
+#define RESULT_RING_VERSION 1                               // the version of the record layout
+#define RESULT_RING_SLOTS 64                                // number of frames kept in the ring (~2 seconds at 30 FPS)
+#define RESULT_MAX_USERS 10                                 // maximum number of users in a record
+#define RESULT_POSE_NAME_LENGTH 32                          // maximum length of the pose name, including the terminating zero
+#define RESULT_KEY_JOINTS 6                                 // number of the joints in a record (see RESULT_KEY_JOINT_TYPES)
+
+/**
+	The joints, that are published for every user: the head, the torso, both elbows and both hands
+*/
+static const nite::JointType RESULT_KEY_JOINT_TYPES[RESULT_KEY_JOINTS] = {
+	nite::JOINT_HEAD, nite::JOINT_TORSO,
+	nite::JOINT_LEFT_ELBOW, nite::JOINT_RIGHT_ELBOW,
+	nite::JOINT_LEFT_HAND, nite::JOINT_RIGHT_HAND
+};
+
+/**
+	The published state of a single user. Only fixed-size plain types, so the layout
+	is the same in every process.
+*/
+struct SharedUserResult {
+
+	// the NiTE id of the user
+	int userId;
+
+	// the index of the recognized pose, or -1
+	int poseIndex;
+
+	// the name of the recognized pose (zero-terminated), or an empty string
+	char poseName[RESULT_POSE_NAME_LENGTH];
+
+	// the real world positions of the key joints (see RESULT_KEY_JOINT_TYPES), in milimeters
+	float joints[RESULT_KEY_JOINTS][3];
+};
+
+/**
+	The published results of a single frame
+*/
+struct SharedFrameResult {
+
+	// the number of the frame, counted from the start of the publishing
+	unsigned long long frameNumber;
+
+	// the timestamp of the frame in microseconds
+	unsigned long long timestamp;
+
+	// the number of the users in the frame
+	int userCount;
+
+	SharedUserResult users[RESULT_MAX_USERS];
+};
+
+/**
+	A slot of the ring. The sequence works as a seqlock: it's odd, while the publisher is writing
+	the record, and it's 2 * (frameNumber + 1), once the record of that frame is complete.
+*/
+struct SharedResultSlot {
+
+	std::atomic<unsigned long long> sequence;
+
+	SharedFrameResult record;
+};
+
+/**
+	The layout of the whole shared memory: the header, followed by the ring of slots
+*/
+struct SharedResultRing {
+
+	// RESULT_RING_MAGIC
+	unsigned int magic;
+
+	// RESULT_RING_VERSION. The readers must check it before using the records
+	unsigned int version;
+
+	// the number of slots, and the size of a slot in bytes
+	unsigned int slotCount;
+	unsigned int slotSize;
+
+	// the number of the frames published so far
+	std::atomic<unsigned long long> published;
+
+	SharedResultSlot slots[RESULT_RING_SLOTS];
+};
+
+/**
+	Publishes the recognition results of every frame into the named shared memory, so other
+	processes on the same machine (e.g. a music engine) can read them without linking the recognizer.
+
+	The shared memory is a ring of the last RESULT_RING_SLOTS frames. Publishing a frame is just
+	a copy into the next slot, guarded by a seqlock: the publisher never waits for the readers and
+	never makes a system call, and any number of readers can read at the same time (see ResultSubscriber).
+*/
+class ResultPublisher {
+
+public:
+	ResultPublisher();
+
+	/**
+		Create the shared memory. The ring has a single publisher, so the name must not be in use
+		by another publisher (e.g. another recognizer in the same process, see MultiSourceHost).
+
+		@param name The name of the shared memory. Default: RESULT_RING_NAME.
+
+		@return Returns "true" if the shared memory was created, "false" if it couldn't be created or it already exists.
+	*/
+	bool open(const std::string& name = RESULT_RING_NAME);
+
+	/**
+		Check if the shared memory is open
+	*/
+	bool isOpen() const;
+
+	/**
+		Publish the results of a frame
+
+		@param timestamp The timestamp of the frame in microseconds
+		@param users All the tracked users
+	*/
+	void publish(const unsigned long long timestamp, const std::vector<KinectUser*>& users);
+
+	/**
+		Close the shared memory. It's destroyed, once all the readers close it too.
+	*/
+	void close();
+
+	~ResultPublisher();
+
+private:
+	// the shared memory
+	HANDLE mapping = NULL;
+	SharedResultRing* ring = nullptr;
+
+	// the number of the next frame
+	unsigned long long frameNumber = 0;
+};
+
+/**
+	Reads the results, published by the ResultPublisher in another (or the same) process.
+	The reader never blocks the publisher: if a record was overwritten while it was being copied,
+	the copy is simply discarded.
+*/
+class ResultSubscriber {
+
+public:
+	ResultSubscriber();
+
+	/**
+		Open the shared memory, created by the publisher
+
+		@param name The name of the shared memory. Default: RESULT_RING_NAME.
+
+		@return Returns "true" if the shared memory exists and has the same version of the records
+	*/
+	bool open(const std::string& name = RESULT_RING_NAME);
+
+	/**
+		Check if the shared memory is open
+	*/
+	bool isOpen() const;
+
+	/**
+		Read the latest published frame, skipping everything before it
+
+		@param result The copy of the frame
+		@return Returns "false" if there is no new frame since the last read
+	*/
+	bool readLatest(SharedFrameResult& result);
+
+	/**
+		Read the next frame after the last read one. If the reader is so late, that the frame
+		was already overwritten, it jumps to the oldest frame still in the ring.
+
+		@param result The copy of the frame
+		@return Returns "false" if there is no new frame since the last read
+	*/
+	bool readNext(SharedFrameResult& result);
+
+	/**
+		Get the number of the frames, that were overwritten before this reader could read them
+	*/
+	unsigned long long getMissedFrames() const;
+
+	/**
+		Close the shared memory
+	*/
+	void close();
+
+	~ResultSubscriber();
+
+private:
+	// the shared memory
+	HANDLE mapping = NULL;
+	const SharedResultRing* ring = nullptr;
+
+	// the number of the next frame to read
+	unsigned long long nextFrame = 0;
+
+	// the number of the missed frames
+	unsigned long long missedFrames = 0;
+
+	/**
+		Copy the record of the frame, if it's still in the ring
+
+		@return Returns "false" if the record was overwritten (or is being overwritten)
+	*/
+	bool readFrame(const unsigned long long frame, SharedFrameResult& result) const;
+};
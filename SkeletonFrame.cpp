@@ -0,0 +1,51 @@
+#include "SkeletonFrame.h"
+
+void SkeletonFrame::capture(const nite::UserTrackerFrameRef& userTrackerFrame) {
+
+	const nite::Array<nite::UserData>& niteUsers = userTrackerFrame.getUsers();
+
+	timestamp = userTrackerFrame.getTimestamp();
+
+	// the vector keeps its capacity, so there's no allocation after the first few frames
+	users.resize(niteUsers.getSize());
+
+	for (int u = 0; u < niteUsers.getSize(); ++u) {
+		const nite::UserData& niteUser = niteUsers[u];
+		const nite::Skeleton& skeleton = niteUser.getSkeleton();
+
+		SkeletonUser& user = users[u];
+
+		user.userId = niteUser.getId();
+		user.flags = (niteUser.isNew() ? SkeletonUser::USER_NEW : 0) |
+			(niteUser.isVisible() ? SkeletonUser::USER_VISIBLE : 0) |
+			(niteUser.isLost() ? SkeletonUser::USER_LOST : 0);
+		user.skeletonState = skeleton.getState();
+		user.poseIndex = -1;
+
+		for (int j = 0; j < NUM_JOINTS; j++) {
+			const nite::SkeletonJoint& joint = skeleton.getJoint((nite::JointType) j);
+			const nite::Point3f& position = joint.getPosition();
+
+			user.positions[j] = cv::Point3f(position.x, position.y, position.z);
+			user.confidences[j] = joint.getPositionConfidence();
+		}
+	}
+}
+
+SkeletonUser* SkeletonFrame::findUser(const nite::UserId userId) {
+	for (SkeletonUser& user : users) {
+		if (user.userId == userId)
+			return &user;
+	}
+
+	return nullptr;
+}
+
+const SkeletonUser* SkeletonFrame::findUser(const nite::UserId userId) const {
+	for (const SkeletonUser& user : users) {
+		if (user.userId == userId)
+			return &user;
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "JointSnapshot.h"
+
+#include <NiTE.h>
+
+#include <vector>
+
+/**
+	The state of a single user in a SkeletonFrame: the same information as the nite::UserData,
+	that the recognizer needs, but in a self-contained form, which can be recorded, replayed,
+	or passed between threads.
+*/
+struct SkeletonUser {
+
+	// the flags of the user
+	enum {
+		USER_NEW = 1,
+		USER_VISIBLE = 2,
+		USER_LOST = 4
+	};
+
+	nite::UserId userId = 0;
+
+	unsigned char flags = 0;
+
+	nite::SkeletonState skeletonState = nite::SKELETON_NONE;
+
+	// the real world positions of all the joints (see nite::JointType), in milimeters
+	cv::Point3f positions[NUM_JOINTS];
+
+	// the confidences of the joint positions (0..1)
+	float confidences[NUM_JOINTS];
+
+	// the index of the recognized pose of the user, or -1
+	int poseIndex = -1;
+
+	// same as in nite::UserData
+	nite::UserId getId() const { return userId; }
+	bool isNew() const { return (flags & USER_NEW) != 0; }
+	bool isVisible() const { return (flags & USER_VISIBLE) != 0; }
+	bool isLost() const { return (flags & USER_LOST) != 0; }
+};
+
+/**
+	All the users, tracked by the NiTE in a single frame.
+*/
+struct SkeletonFrame {
+
+	// the timestamp of the frame in microseconds (same as nite::UserTrackerFrameRef::getTimestamp())
+	unsigned long long timestamp = 0;
+
+	// the users in the frame
+	std::vector<SkeletonUser> users;
+
+	/**
+		Fill the frame from the NiTE user tracker frame
+
+		@param userTrackerFrame The current frame of the user tracker
+	*/
+	void capture(const nite::UserTrackerFrameRef& userTrackerFrame);
+
+	/**
+		Find the user in the frame
+
+		@return Returns a pointer to the user, or nullptr if there's no such user in the frame
+	*/
+	SkeletonUser* findUser(const nite::UserId userId);
+	const SkeletonUser* findUser(const nite::UserId userId) const;
+};
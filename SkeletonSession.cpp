@@ -0,0 +1,522 @@
+#include "SkeletonSession.h"
+
+#include <algorithm>
+#include <cstring>
+
+#define SESSION_HEADER_SIZE 32
+#define SESSION_FOOTER_SIZE 16
+#define SESSION_INDEX_ENTRY_SIZE 24
+#define SESSION_CHUNK_HEADER_SIZE 24      // "MPCH", frame count, payload size, first frame, first timestamp
+
+// helpers for the little-endian binary encoding
+
+static void putU32(std::vector<unsigned char>& out, const unsigned int value) {
+	for (int i = 0; i < 4; i++)
+		out.push_back((unsigned char)(value >> (8 * i)));
+}
+
+static void putU64(std::vector<unsigned char>& out, const unsigned long long value) {
+	for (int i = 0; i < 8; i++)
+		out.push_back((unsigned char)(value >> (8 * i)));
+}
+
+static void putF32(std::vector<unsigned char>& out, const float value) {
+	unsigned int bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	putU32(out, bits);
+}
+
+static void putVarint(std::vector<unsigned char>& out, unsigned long long value) {
+	while (value >= 0x80) {
+		out.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((unsigned char)value);
+}
+
+static void putZigzag(std::vector<unsigned char>& out, const int value) {
+	putVarint(out, (unsigned int)((value << 1) ^ (value >> 31)));
+}
+
+static unsigned int getU32(const unsigned char* in) {
+	return in[0] | (in[1] << 8) | (in[2] << 16) | ((unsigned int)in[3] << 24);
+}
+
+static unsigned long long getU64(const unsigned char* in) {
+	return getU32(in) | ((unsigned long long)getU32(in + 4) << 32);
+}
+
+static float getF32(const unsigned char* in) {
+	unsigned int bits = getU32(in);
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static bool getVarint(const unsigned char*& in, const unsigned char* end, unsigned long long& value) {
+	value = 0;
+	for (int shift = 0; in < end && shift < 64; shift += 7) {
+		unsigned char byte = *in++;
+		value |= (unsigned long long)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+static bool getZigzag(const unsigned char*& in, const unsigned char* end, int& value) {
+	unsigned long long raw;
+	if (!getVarint(in, end, raw))
+		return false;
+	value = (int)((unsigned int)raw >> 1) ^ -(int)(raw & 1);
+	return true;
+}
+
+// SkeletonSessionWriter
+
+SkeletonSessionWriter::SkeletonSessionWriter() {
+}
+
+bool SkeletonSessionWriter::open(const std::string& fileName, const DepthProjection& projection, const int framesPerChunk) {
+
+	close();
+
+	ofs.open(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+
+	if (!ofs.is_open()) {
+		std::cerr << "Couldn't create the session file " << fileName << std::endl;
+		return false;
+	}
+
+	this->framesPerChunk = (std::max)(1, framesPerChunk);
+	this->frameCount = 0;
+	this->index.clear();
+
+	std::vector<unsigned char> header;
+	header.insert(header.end(), { 'M', 'P', 'S', 'K' });
+	putU32(header, SESSION_VERSION);
+	putU32(header, this->framesPerChunk);
+	putF32(header, projection.getCoeffX());
+	putF32(header, projection.getCoeffY());
+	putF32(header, projection.getHalfResX());
+	putF32(header, projection.getHalfResY());
+	putU32(header, 0);
+
+	ofs.write((const char*)header.data(), header.size());
+
+	chunk.clear();
+	chunkFrames = 0;
+
+	return true;
+}
+
+bool SkeletonSessionWriter::isOpen() const {
+	return ofs.is_open();
+}
+
+void SkeletonSessionWriter::write(const SkeletonFrame& frame) {
+
+	if (!ofs.is_open())
+		return;
+
+	// start a new chunk
+	if (chunkFrames == 0) {
+		SessionChunk entry;
+		entry.offset = 0;
+		entry.firstTimestamp = frame.timestamp;
+		entry.firstFrame = frameCount;
+		entry.frameCount = 0;
+		index.push_back(entry);
+
+		lastTimestamp = 0;
+		std::fill(std::begin(hasPrevious), std::end(hasPrevious), false);
+	}
+
+	putVarint(chunk, frame.timestamp - lastTimestamp);
+	lastTimestamp = frame.timestamp;
+
+	int userCount = 0;
+	for (const SkeletonUser& user : frame.users) {
+		if (user.userId >= 0 && user.userId < SESSION_MAX_USER_ID)
+			userCount++;
+	}
+
+	chunk.push_back((unsigned char)userCount);
+
+	for (const SkeletonUser& user : frame.users) {
+		if (user.userId < 0 || user.userId >= SESSION_MAX_USER_ID)
+			continue;
+
+		chunk.push_back((unsigned char)user.userId);
+		chunk.push_back(user.flags);
+		chunk.push_back((unsigned char)user.skeletonState);
+		chunk.push_back((unsigned char)(user.poseIndex + 1));
+
+		int(&last)[NUM_JOINTS][3] = previous[user.userId];
+
+		for (int j = 0; j < NUM_JOINTS; j++) {
+			const int current[3] = {
+				(int)std::floor(user.positions[j].x + 0.5f),
+				(int)std::floor(user.positions[j].y + 0.5f),
+				(int)std::floor(user.positions[j].z + 0.5f)
+			};
+
+			for (int c = 0; c < 3; c++) {
+				putZigzag(chunk, current[c] - (hasPrevious[user.userId] ? last[j][c] : 0));
+				last[j][c] = current[c];
+			}
+
+			chunk.push_back((unsigned char)std::floor((std::min)((std::max)(user.confidences[j], 0.f), 1.f) * 255 + 0.5f));
+		}
+
+		hasPrevious[user.userId] = true;
+	}
+
+	chunkFrames++;
+	frameCount++;
+
+	if (chunkFrames >= framesPerChunk)
+		flushChunk();
+}
+
+void SkeletonSessionWriter::flushChunk() {
+
+	if (chunkFrames == 0)
+		return;
+
+	SessionChunk& entry = index.back();
+	entry.offset = (unsigned long long)ofs.tellp();
+	entry.frameCount = chunkFrames;
+
+	std::vector<unsigned char> header;
+	header.insert(header.end(), { 'M', 'P', 'C', 'H' });
+	putU32(header, chunkFrames);
+	putU32(header, (unsigned int)chunk.size());
+	putU32(header, entry.firstFrame);
+	putU64(header, entry.firstTimestamp);
+
+	ofs.write((const char*)header.data(), header.size());
+	ofs.write((const char*)chunk.data(), chunk.size());
+
+	// the chunk is readable, even if the recording never finishes
+	ofs.flush();
+
+	chunk.clear();
+	chunkFrames = 0;
+}
+
+void SkeletonSessionWriter::close() {
+
+	if (!ofs.is_open())
+		return;
+
+	flushChunk();
+
+	// write the index and the footer
+	std::vector<unsigned char> footer;
+
+	unsigned long long indexOffset = (unsigned long long)ofs.tellp();
+
+	for (const SessionChunk& entry : index) {
+		putU64(footer, entry.offset);
+		putU64(footer, entry.firstTimestamp);
+		putU32(footer, entry.firstFrame);
+		putU32(footer, entry.frameCount);
+	}
+
+	putU64(footer, indexOffset);
+	putU32(footer, (unsigned int)index.size());
+	footer.insert(footer.end(), { 'M', 'P', 'I', 'X' });
+
+	ofs.write((const char*)footer.data(), footer.size());
+	ofs.close();
+}
+
+unsigned int SkeletonSessionWriter::getFrameCount() const {
+	return this->frameCount;
+}
+
+SkeletonSessionWriter::~SkeletonSessionWriter() {
+	close();
+}
+
+// SkeletonSessionReader
+
+SkeletonSessionReader::SkeletonSessionReader() {
+}
+
+bool SkeletonSessionReader::open(const std::string& fileName) {
+
+	close();
+
+	// the session may still be recorded
+	file = ::CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (file == INVALID_HANDLE_VALUE) {
+		std::cerr << "Couldn't open the session file " << fileName << std::endl;
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!::GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < SESSION_HEADER_SIZE) {
+		close();
+		return false;
+	}
+
+	size = (size_t)fileSize.QuadPart;
+
+	mapping = ::CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping != NULL)
+		data = (const unsigned char*)::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (data == nullptr) {
+		close();
+		return false;
+	}
+
+	// check the header
+	if (std::memcmp(data, "MPSK", 4) != 0 || getU32(data + 4) != SESSION_VERSION) {
+		std::cerr << "Not a valid session file: " << fileName << std::endl;
+		close();
+		return false;
+	}
+
+	projection = DepthProjection(getF32(data + 12), getF32(data + 16), getF32(data + 20), getF32(data + 24));
+
+	if (!readIndex()) {
+		scanChunks();
+
+		std::cerr << "The session file " << fileName << " wasn't closed properly, " << getFrameCount() << " frames recovered" << std::endl;
+	}
+
+	return seek(0) || index.empty();
+}
+
+bool SkeletonSessionReader::readIndex() {
+
+	if (size < SESSION_HEADER_SIZE + SESSION_FOOTER_SIZE)
+		return false;
+
+	const unsigned char* footer = data + size - SESSION_FOOTER_SIZE;
+
+	if (std::memcmp(footer + 12, "MPIX", 4) != 0)
+		return false;
+
+	unsigned long long indexOffset = getU64(footer);
+	unsigned int chunkCount = getU32(footer + 8);
+
+	if (indexOffset + (unsigned long long)chunkCount * SESSION_INDEX_ENTRY_SIZE > size - SESSION_FOOTER_SIZE)
+		return false;
+
+	index.resize(chunkCount);
+
+	for (unsigned int i = 0; i < chunkCount; i++) {
+		const unsigned char* entry = data + indexOffset + i * SESSION_INDEX_ENTRY_SIZE;
+
+		index[i].offset = getU64(entry);
+		index[i].firstTimestamp = getU64(entry + 8);
+		index[i].firstFrame = getU32(entry + 16);
+		index[i].frameCount = getU32(entry + 20);
+	}
+
+	return true;
+}
+
+void SkeletonSessionReader::scanChunks() {
+
+	index.clear();
+
+	unsigned long long offset = SESSION_HEADER_SIZE;
+
+	while (offset + SESSION_CHUNK_HEADER_SIZE <= size) {
+		const unsigned char* header = data + offset;
+
+		// the end of the chunks (e.g. a partly written index)
+		if (std::memcmp(header, "MPCH", 4) != 0)
+			break;
+
+		unsigned long long end = offset + SESSION_CHUNK_HEADER_SIZE + getU32(header + 8);
+
+		// the last chunk may be cut off
+		if (end > size)
+			break;
+
+		SessionChunk entry;
+		entry.offset = offset;
+		entry.frameCount = getU32(header + 4);
+		entry.firstFrame = getU32(header + 12);
+		entry.firstTimestamp = getU64(header + 16);
+
+		index.push_back(entry);
+
+		offset = end;
+	}
+}
+
+bool SkeletonSessionReader::isOpen() const {
+	return data != nullptr;
+}
+
+void SkeletonSessionReader::close() {
+
+	if (data != nullptr)
+		::UnmapViewOfFile(data);
+
+	if (mapping != NULL)
+		::CloseHandle(mapping);
+
+	if (file != INVALID_HANDLE_VALUE)
+		::CloseHandle(file);
+
+	data = nullptr;
+	mapping = NULL;
+	file = INVALID_HANDLE_VALUE;
+	size = 0;
+
+	index.clear();
+	currentChunk = -1;
+	framesLeft = 0;
+	nextFrame = 0;
+}
+
+unsigned int SkeletonSessionReader::getFrameCount() const {
+	return index.empty() ? 0 : index.back().firstFrame + index.back().frameCount;
+}
+
+DepthProjection SkeletonSessionReader::getProjection() const {
+	return this->projection;
+}
+
+bool SkeletonSessionReader::startChunk(const int chunk) {
+
+	if (chunk < 0 || chunk >= index.size())
+		return false;
+
+	if (index[chunk].offset + SESSION_CHUNK_HEADER_SIZE > size)
+		return false;
+
+	const unsigned char* header = data + index[chunk].offset;
+
+	currentChunk = chunk;
+	framesLeft = getU32(header + 4);
+	position = header + SESSION_CHUNK_HEADER_SIZE;
+	chunkEnd = (std::min)(position + getU32(header + 8), data + size);
+	nextFrame = index[chunk].firstFrame;
+
+	lastTimestamp = 0;
+	std::fill(std::begin(hasPrevious), std::end(hasPrevious), false);
+
+	return true;
+}
+
+bool SkeletonSessionReader::seek(const unsigned int frame) {
+
+	if (frame >= getFrameCount())
+		return false;
+
+	// find the chunk, that contains the frame
+	auto chunk = std::upper_bound(std::begin(index), std::end(index), frame, [](const unsigned int f, const SessionChunk& c) {
+		return f < c.firstFrame;
+	}) - 1;
+
+	if (!startChunk((int)(chunk - std::begin(index))))
+		return false;
+
+	// decode the frames of the chunk up to the requested one
+	SkeletonFrame skipped;
+	while (nextFrame < frame) {
+		if (!readNextFrame(skipped))
+			return false;
+	}
+
+	return true;
+}
+
+bool SkeletonSessionReader::seekToTime(const unsigned long long timestamp) {
+
+	if (index.empty())
+		return false;
+
+	// find the last chunk, that starts before the timestamp
+	auto chunk = std::upper_bound(std::begin(index), std::end(index), timestamp, [](const unsigned long long t, const SessionChunk& c) {
+		return t < c.firstTimestamp;
+	});
+
+	if (chunk != std::begin(index))
+		chunk--;
+
+	if (!startChunk((int)(chunk - std::begin(index))))
+		return false;
+
+	// decode until the timestamp is reached
+	SkeletonFrame frame;
+	while (readNextFrame(frame)) {
+		// a frame can only be decoded after all the previous frames of its chunk, so decode them again
+		if (frame.timestamp >= timestamp)
+			return seek(nextFrame - 1);
+	}
+
+	return false;
+}
+
+bool SkeletonSessionReader::readNextFrame(SkeletonFrame& frame) {
+
+	if (data == nullptr)
+		return false;
+
+	// go to the next chunk
+	if (framesLeft == 0) {
+		if (!startChunk(currentChunk + 1))
+			return false;
+	}
+
+	unsigned long long delta;
+	if (!getVarint(position, chunkEnd, delta) || position >= chunkEnd)
+		return false;
+
+	frame.timestamp = lastTimestamp = lastTimestamp + delta;
+
+	int userCount = *position++;
+	frame.users.resize(userCount);
+
+	for (int u = 0; u < userCount; u++) {
+		if (position + 4 > chunkEnd)
+			return false;
+
+		SkeletonUser& user = frame.users[u];
+		user.userId = position[0];
+		user.flags = position[1];
+		user.skeletonState = (nite::SkeletonState) position[2];
+		user.poseIndex = (int)position[3] - 1;
+		position += 4;
+
+		int(&last)[NUM_JOINTS][3] = previous[user.userId];
+
+		for (int j = 0; j < NUM_JOINTS; j++) {
+			for (int c = 0; c < 3; c++) {
+				int value;
+				if (!getZigzag(position, chunkEnd, value))
+					return false;
+
+				last[j][c] = value + (hasPrevious[user.userId] ? last[j][c] : 0);
+			}
+
+			if (position >= chunkEnd)
+				return false;
+
+			user.positions[j] = cv::Point3f((float)last[j][0], (float)last[j][1], (float)last[j][2]);
+			user.confidences[j] = *position++ / 255.f;
+		}
+
+		hasPrevious[user.userId] = true;
+	}
+
+	framesLeft--;
+	nextFrame++;
+
+	return true;
+}
+
+SkeletonSessionReader::~SkeletonSessionReader() {
+	close();
+}
@@ -0,0 +1,240 @@
+#pragma once
+
+#include "SkeletonFrame.h"
+#include "DepthProjection.h"
+
+#include <Windows.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#define SESSION_VERSION 1              // the version of the session file format
+#define SESSION_FRAMES_PER_CHUNK 300   // default number of frames in a chunk (10 seconds at 30 FPS)
+#define SESSION_MAX_USER_ID 256        // user ids are stored as a single byte
+
+/**
+	The compact binary recording of a skeleton session: the timestamps, the user ids and states,
+	all the joint positions and confidences, and the recognized poses, but no video.
+
+	File layout (all the numbers are little-endian):
+
+	Header      "MPSK", version (u32), frames per chunk (u32),
+	            depth projection: coeffX, coeffY, halfResX, halfResY (4 x f32), reserved (u32)
+	Chunk       "MPCH", frame count (u32), payload size (u32), first frame (u32), first timestamp (u64), payload
+	...
+	Index       one entry per chunk: file offset (u64), first timestamp (u64), first frame (u32), frame count (u32)
+	Footer      index offset (u64), chunk count (u32), "MPIX"
+
+	The index and the footer are written only when the session is closed. Every chunk is written
+	(and flushed) as soon as it's full, and its header describes it completely, so a session cut off
+	by a crash is still readable: without the footer, the reader rebuilds the index by scanning
+	the chunks, and only the frames after the last complete chunk are lost.
+
+	Every frame in the chunk payload is:
+
+	timestamp delta (varint), user count (u8), and for every user:
+	id (u8), flags (u8), skeleton state (u8), pose index + 1 (u8),
+	for every joint: the delta of x, y, z in milimeters (3 x zigzag varint), confidence * 255 (u8)
+
+	The timestamps and the positions are delta-encoded against the previous frame (of the same user)
+	in the same chunk, so every chunk can be decoded on its own, and the index at the end of the
+	file allows to seek to any frame without reading the whole file.
+*/
+
+/**
+	An entry of the chunk index
+*/
+struct SessionChunk {
+
+	unsigned long long offset;
+
+	unsigned long long firstTimestamp;
+
+	unsigned int firstFrame;
+
+	unsigned int frameCount;
+};
+
+/**
+	Writes the skeleton session into a file. The frames are encoded into an in-memory chunk,
+	which is written to the disk only when it's full, so writing a frame is just a few hundred
+	bytes of encoding.
+*/
+class SkeletonSessionWriter {
+
+public:
+	SkeletonSessionWriter();
+
+	/**
+		Create a new session file
+
+		@param fileName The path to the file
+		@param projection The depth projection, used to draw the replayed skeletons
+		@param framesPerChunk Number of frames in a chunk. Default: SESSION_FRAMES_PER_CHUNK.
+
+		@return Returns "true" if the file was created.
+	*/
+	bool open(const std::string& fileName, const DepthProjection& projection, const int framesPerChunk = SESSION_FRAMES_PER_CHUNK);
+
+	/**
+		Check if the session file is open
+	*/
+	bool isOpen() const;
+
+	/**
+		Add a frame to the session
+
+		@param frame The frame with all the users
+	*/
+	void write(const SkeletonFrame& frame);
+
+	/**
+		Write the last chunk and the index, and close the file
+	*/
+	void close();
+
+	/**
+		Get the number of frames written so far
+	*/
+	unsigned int getFrameCount() const;
+
+	~SkeletonSessionWriter();
+
+private:
+	// the output file
+	std::ofstream ofs;
+
+	// the encoded frames of the current chunk
+	std::vector<unsigned char> chunk;
+
+	// number of frames in the current chunk, and the maximum number of frames
+	int chunkFrames = 0;
+	int framesPerChunk = SESSION_FRAMES_PER_CHUNK;
+
+	// the timestamp of the previous frame in the chunk
+	unsigned long long lastTimestamp = 0;
+
+	// the total number of frames
+	unsigned int frameCount = 0;
+
+	// the chunk index
+	std::vector<SessionChunk> index;
+
+	// the previous positions of every user in the current chunk, in milimeters
+	int previous[SESSION_MAX_USER_ID][NUM_JOINTS][3];
+	bool hasPrevious[SESSION_MAX_USER_ID];
+
+	/**
+		Write the current chunk to the file and start a new one
+	*/
+	void flushChunk();
+};
+
+/**
+	Reads the skeleton session from a file. The file is memory-mapped, so seeking to any frame
+	only decodes the chunk, that contains it.
+*/
+class SkeletonSessionReader {
+
+public:
+	SkeletonSessionReader();
+
+	/**
+		Open the session file
+
+		@param fileName The path to the file
+		@return Returns "true" if the file is a valid session file
+	*/
+	bool open(const std::string& fileName);
+
+	/**
+		Check if the session file is open
+	*/
+	bool isOpen() const;
+
+	/**
+		Close the file
+	*/
+	void close();
+
+	/**
+		Get the total number of frames in the session
+	*/
+	unsigned int getFrameCount() const;
+
+	/**
+		Get the depth projection, that was used during the recording
+	*/
+	DepthProjection getProjection() const;
+
+	/**
+		Jump to the specified frame
+
+		@param frame The number of the frame (0..getFrameCount()-1)
+		@return Returns "true" if there is such a frame
+	*/
+	bool seek(const unsigned int frame);
+
+	/**
+		Jump to the first frame with the timestamp not less than the specified one
+
+		@param timestamp The timestamp in microseconds
+		@return Returns "true" if there is such a frame
+	*/
+	bool seekToTime(const unsigned long long timestamp);
+
+	/**
+		Decode the next frame
+
+		@param frame The decoded frame
+		@return Returns "false" at the end of the session
+	*/
+	bool readNextFrame(SkeletonFrame& frame);
+
+	~SkeletonSessionReader();
+
+private:
+	// the memory-mapped file
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = NULL;
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+
+	// the projection from the header
+	DepthProjection projection;
+
+	// the chunk index
+	std::vector<SessionChunk> index;
+
+	// the current chunk, the position in it, and the number of frames left in it
+	int currentChunk = -1;
+	const unsigned char* position = nullptr;
+	const unsigned char* chunkEnd = nullptr;
+	unsigned int framesLeft = 0;
+
+	// the number of the next frame
+	unsigned int nextFrame = 0;
+
+	// the decoding state of the current chunk (see SkeletonSessionWriter)
+	unsigned long long lastTimestamp = 0;
+	int previous[SESSION_MAX_USER_ID][NUM_JOINTS][3];
+	bool hasPrevious[SESSION_MAX_USER_ID];
+
+	/**
+		Start decoding the chunk from its first frame
+	*/
+	bool startChunk(const int chunk);
+
+	/**
+		Read the chunk index from the end of the file
+
+		@return Returns "false" if the file has no valid index (e.g. the recording didn't finish).
+	*/
+	bool readIndex();
+
+	/**
+		Rebuild the chunk index from the headers of the chunks. Stops at the first incomplete chunk.
+	*/
+	void scanChunks();
+};
@@ -0,0 +1,282 @@
+#include "StreamSession.h"
+
+#include <cstring>
+
+// helpers for the little-endian binary encoding
+
+static void putU32(std::ostream& out, const unsigned int value) {
+	unsigned char bytes[4];
+	for (int i = 0; i < 4; i++)
+		bytes[i] = (unsigned char)(value >> (8 * i));
+	out.write((const char*)bytes, 4);
+}
+
+static void putU64(std::ostream& out, const unsigned long long value) {
+	putU32(out, (unsigned int)value);
+	putU32(out, (unsigned int)(value >> 32));
+}
+
+static bool getU32(std::istream& in, unsigned int& value) {
+	unsigned char bytes[4];
+	if (!in.read((char*)bytes, 4))
+		return false;
+	value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((unsigned int)bytes[3] << 24);
+	return true;
+}
+
+static bool getU64(std::istream& in, unsigned long long& value) {
+	unsigned int low, high;
+	if (!getU32(in, low) || !getU32(in, high))
+		return false;
+	value = low | ((unsigned long long)high << 32);
+	return true;
+}
+
+// StreamSessionWriter
+
+StreamSessionWriter::StreamSessionWriter(const int maxQueuedFrames) : writtenFrames(0), droppedFrames(0) {
+	this->maxQueuedFrames = (std::max)(1, maxQueuedFrames);
+}
+
+bool StreamSessionWriter::open(const std::string& fileName) {
+
+	close();
+
+	ofs.open(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+
+	if (!ofs.is_open()) {
+		std::cerr << "Couldn't create the stream file " << fileName << std::endl;
+		return false;
+	}
+
+	ofs.write("MPST", 4);
+	putU32(ofs, STREAM_VERSION);
+
+	writtenFrames = 0;
+	droppedFrames = 0;
+	stopping = false;
+
+	writerThread = std::thread(&StreamSessionWriter::run, this);
+
+	return true;
+}
+
+bool StreamSessionWriter::isOpen() const {
+	return ofs.is_open();
+}
+
+bool StreamSessionWriter::write(const unsigned long long timestamp, const cv::Mat& depth, const cv::Mat& color) {
+
+	if (!ofs.is_open())
+		return false;
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+
+		if (queue.size() >= maxQueuedFrames) {
+			droppedFrames++;
+			return false;
+		}
+
+		// only the references are queued, the images are not copied
+		StreamFrame frame;
+		frame.timestamp = timestamp;
+		frame.depth = depth;
+		frame.color = color;
+
+		queue.push_back(frame);
+	}
+
+	queueCondition.notify_one();
+
+	return true;
+}
+
+void StreamSessionWriter::run() {
+
+	// the buffer for the compressed data, reused for every frame
+	std::vector<unsigned char> buffer;
+
+	while (true) {
+		StreamFrame frame;
+
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueCondition.wait(lock, [this] { return stopping || !queue.empty(); });
+
+			// write everything that was queued before stopping
+			if (queue.empty())
+				break;
+
+			frame = queue.front();
+			queue.pop_front();
+		}
+
+		writeFrame(frame, buffer);
+		writtenFrames++;
+	}
+}
+
+void StreamSessionWriter::writeFrame(const StreamFrame& frame, std::vector<unsigned char>& buffer) {
+
+	putU64(ofs, frame.timestamp);
+
+	// the depth map
+	if (!frame.depth.empty() && frame.depth.type() == CV_16UC1) {
+		compressDepthRVL(frame.depth, buffer);
+
+		putU32(ofs, frame.depth.rows);
+		putU32(ofs, frame.depth.cols);
+		putU32(ofs, (unsigned int)buffer.size());
+		ofs.write((const char*)buffer.data(), buffer.size());
+	}
+	else {
+		putU32(ofs, 0);
+		putU32(ofs, 0);
+		putU32(ofs, 0);
+	}
+
+	// the color image
+	buffer.clear();
+
+	if (!frame.color.empty())
+		cv::imencode(".png", frame.color, buffer, std::vector<int>({ cv::IMWRITE_PNG_COMPRESSION, STREAM_PNG_COMPRESSION }));
+
+	putU32(ofs, (unsigned int)buffer.size());
+	ofs.write((const char*)buffer.data(), buffer.size());
+}
+
+void StreamSessionWriter::close() {
+
+	if (!ofs.is_open())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		stopping = true;
+	}
+
+	queueCondition.notify_one();
+
+	if (writerThread.joinable())
+		writerThread.join();
+
+	ofs.close();
+
+	if (droppedFrames > 0)
+		std::cerr << "Stream recording: " << droppedFrames << " frames were dropped" << std::endl;
+}
+
+unsigned int StreamSessionWriter::getWrittenFrames() const {
+	return this->writtenFrames;
+}
+
+unsigned int StreamSessionWriter::getDroppedFrames() const {
+	return this->droppedFrames;
+}
+
+StreamSessionWriter::~StreamSessionWriter() {
+	close();
+}
+
+// StreamSessionReader
+
+StreamSessionReader::StreamSessionReader() {
+}
+
+bool StreamSessionReader::open(const std::string& fileName, const bool realTime) {
+
+	close();
+
+	ifs.open(fileName, std::ios::in | std::ios::binary);
+
+	if (!ifs.is_open()) {
+		std::cerr << "Couldn't open the stream file " << fileName << std::endl;
+		return false;
+	}
+
+	char magic[4];
+	unsigned int version;
+
+	if (!ifs.read(magic, 4) || std::memcmp(magic, "MPST", 4) != 0 || !getU32(ifs, version) || version != STREAM_VERSION) {
+		std::cerr << "Not a valid stream file: " << fileName << std::endl;
+		close();
+		return false;
+	}
+
+	this->realTime = realTime;
+	this->started = false;
+
+	return true;
+}
+
+bool StreamSessionReader::isOpen() const {
+	return ifs.is_open();
+}
+
+void StreamSessionReader::close() {
+	if (ifs.is_open())
+		ifs.close();
+}
+
+bool StreamSessionReader::readNextFrame(StreamFrame& frame) {
+
+	if (!ifs.is_open())
+		return false;
+
+	unsigned int rows, cols, size;
+
+	if (!getU64(ifs, frame.timestamp) || !getU32(ifs, rows) || !getU32(ifs, cols) || !getU32(ifs, size))
+		return false;
+
+	// the depth map
+	buffer.resize(size);
+	if (!ifs.read((char*)buffer.data(), size))
+		return false;
+
+	if (rows > 0 && cols > 0) {
+		frame.depth = depthPool.acquire(rows, cols, CV_16UC1);
+
+		if (!decompressDepthRVL(buffer.data(), buffer.size(), frame.depth)) {
+			std::cerr << "Corrupted depth map at " << frame.timestamp << std::endl;
+			frame.depth.release();
+		}
+	}
+	else {
+		frame.depth.release();
+	}
+
+	// the color image
+	if (!getU32(ifs, size))
+		return false;
+
+	buffer.resize(size);
+	if (!ifs.read((char*)buffer.data(), size))
+		return false;
+
+	if (size > 0) {
+		frame.color = colorPool.acquire(frame.depth.empty() ? 480 : frame.depth.rows, frame.depth.empty() ? 640 : frame.depth.cols, CV_8UC3);
+		cv::imdecode(buffer, cv::IMREAD_UNCHANGED, &frame.color);
+	}
+	else {
+		frame.color.release();
+	}
+
+	// wait until the frame is due
+	if (realTime) {
+		if (!started) {
+			started = true;
+			firstTimestamp = frame.timestamp;
+			startTime = std::chrono::steady_clock::now();
+		}
+		else if (frame.timestamp > firstTimestamp) {
+			std::this_thread::sleep_until(startTime + std::chrono::microseconds(frame.timestamp - firstTimestamp));
+		}
+	}
+
+	return true;
+}
+
+StreamSessionReader::~StreamSessionReader() {
+	close();
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include "DepthCodec.h"
+#include "FramePool.h"
+
+#include "opencv2/highgui/highgui.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#define STREAM_VERSION 1              // the version of the stream file format
+#define STREAM_MAX_QUEUED_FRAMES 30   // default number of frames waiting for the compression (1 second at 30 FPS)
+#define STREAM_PNG_COMPRESSION 1      // the PNG compression level of the color images (fastest)
+
+/**
+	The recording of the raw camera streams: the depth map and the color image of every frame,
+	both compressed losslessly, so the whole pipeline (tracking, recognition and rendering)
+	can be reproduced offline.
+
+	File layout (all the numbers are little-endian):
+
+	Header      "MPST", version (u32)
+	Frame       timestamp (u64), depth rows (u32), depth cols (u32), depth size (u32), RVL depth data,
+	            color size (u32), PNG color data
+	...
+
+	Empty images are stored with zero size.
+*/
+
+/**
+	A single frame of the camera streams
+*/
+struct StreamFrame {
+
+	// the timestamp of the frame in microseconds (same as in the SkeletonFrame)
+	unsigned long long timestamp = 0;
+
+	// the depth map (CV_16UC1), in milimeters
+	cv::Mat depth;
+
+	// the color image (CV_8UC3)
+	cv::Mat color;
+};
+
+/**
+	Writes the camera streams into a file. The frames are compressed and written on a background
+	thread, so write() never blocks the capture: the images are only queued, sharing the data
+	with the caller (the pooled buffers are not reused while they are in the queue, see FramePool).
+	If the writer can't keep up, and the queue is full, the new frames are dropped and counted.
+*/
+class StreamSessionWriter {
+
+public:
+	/**
+		Create the writer
+
+		@param maxQueuedFrames The maximum number of frames waiting for the compression. Default: STREAM_MAX_QUEUED_FRAMES.
+	*/
+	StreamSessionWriter(const int maxQueuedFrames = STREAM_MAX_QUEUED_FRAMES);
+
+	/**
+		Create a new stream file and start the writer thread
+
+		@param fileName The path to the file
+
+		@return Returns "true" if the file was created.
+	*/
+	bool open(const std::string& fileName);
+
+	/**
+		Check if the stream file is open
+	*/
+	bool isOpen() const;
+
+	/**
+		Queue a frame for writing. Doesn't copy the images.
+
+		@param timestamp The timestamp of the frame in microseconds
+		@param depth The depth map (CV_16UC1). The image must not be modified afterwards.
+		@param color The color image (CV_8UC3). The image must not be modified afterwards.
+
+		@return Returns "false" if the frame was dropped, because the queue is full.
+	*/
+	bool write(const unsigned long long timestamp, const cv::Mat& depth, const cv::Mat& color);
+
+	/**
+		Write all the queued frames, stop the writer thread and close the file
+	*/
+	void close();
+
+	/**
+		Get the number of frames written so far
+	*/
+	unsigned int getWrittenFrames() const;
+
+	/**
+		Get the number of frames dropped, because the queue was full
+	*/
+	unsigned int getDroppedFrames() const;
+
+	~StreamSessionWriter();
+
+private:
+	// the output file
+	std::ofstream ofs;
+
+	// the writer thread
+	std::thread writerThread;
+
+	// the frames waiting for the compression
+	std::deque<StreamFrame> queue;
+	int maxQueuedFrames;
+
+	// guards the queue and the stopping flag
+	std::mutex queueMutex;
+	std::condition_variable queueCondition;
+	bool stopping = false;
+
+	// the statistics
+	std::atomic<unsigned int> writtenFrames;
+	std::atomic<unsigned int> droppedFrames;
+
+	/**
+		The loop of the writer thread
+	*/
+	void run();
+
+	/**
+		Compress and write a single frame
+	*/
+	void writeFrame(const StreamFrame& frame, std::vector<unsigned char>& buffer);
+};
+
+/**
+	Reads the camera streams from a file, either as fast as possible, or at the original rate
+	of the recording.
+*/
+class StreamSessionReader {
+
+public:
+	StreamSessionReader();
+
+	/**
+		Open the stream file
+
+		@param fileName The path to the file
+		@param realTime Feed the frames at the original rate (true), or as fast as possible (false). Default: true.
+
+		@return Returns "true" if the file is a valid stream file
+	*/
+	bool open(const std::string& fileName, const bool realTime = true);
+
+	/**
+		Check if the stream file is open
+	*/
+	bool isOpen() const;
+
+	/**
+		Close the file
+	*/
+	void close();
+
+	/**
+		Decode the next frame. In the real time mode, waits until the frame is due.
+		The images are decoded into reused buffers, which are not overwritten while
+		the caller still holds them.
+
+		@param frame The decoded frame
+		@return Returns "false" at the end of the file
+	*/
+	bool readNextFrame(StreamFrame& frame);
+
+	~StreamSessionReader();
+
+private:
+	// the input file
+	std::ifstream ifs;
+
+	// feed the frames at the original rate?
+	bool realTime = true;
+
+	// the timestamp of the first frame, and the time it was read
+	bool started = false;
+	unsigned long long firstTimestamp = 0;
+	std::chrono::steady_clock::time_point startTime;
+
+	// the buffers for the decoded images
+	FramePool depthPool;
+	FramePool colorPool;
+
+	// the buffer for the compressed data
+	std::vector<unsigned char> buffer;
+};
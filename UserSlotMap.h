@@ -0,0 +1,196 @@
+#pragma once
+
+#include <NiTE.h>
+
+/**
+	A handle to a user stored in the UserSlotMap. The handle remembers the generation
+	of the slot at the moment it was issued, so a handle to a user who has already left
+	the scene can be detected, even if NiTE has reused the same user id for somebody else.
+*/
+struct UserHandle {
+
+	int index;
+
+	unsigned int generation;
+
+	UserHandle() {
+		index = -1;
+		generation = 0;
+	}
+
+	UserHandle(int indx, unsigned int gen) {
+		index = indx;
+		generation = gen;
+	}
+
+	bool isNull() const { return index < 0; }
+};
+
+/**
+	A fixed-capacity container for the tracked users, indexed directly by the NiTE user id.
+
+	Every user lives in its own slot for as long as he is tracked, and the slots are never
+	moved or reallocated, so pointers and references to the stored users stay valid until
+	the user is removed. Lookups, insertions and removals are O(1).
+
+	Every removal bumps the generation counter of the slot, which invalidates all the
+	handles issued for the previous occupant.
+
+	@tparam T The type of the stored user (normally KinectUser)
+	@tparam Capacity The maximum number of users. NiTE user ids have to be lower than this value.
+*/
+template <typename T, int Capacity>
+class UserSlotMap {
+
+public:
+	UserSlotMap() {
+		for (int i = 0; i < Capacity; i++) {
+			occupied[i] = false;
+			generation[i] = 0;
+		}
+		count = 0;
+	}
+
+	/**
+		Get the maximum number of users that can be stored
+	*/
+	static int capacity() { return Capacity; }
+
+	/**
+		Get the number of the users that are currently stored
+	*/
+	int size() const { return count; }
+
+	/**
+		Check if the user id can be stored in the map at all
+	*/
+	static bool isValidId(const nite::UserId userId) { return userId >= 0 && userId < Capacity; }
+
+	/**
+		Check if there's a user with the specified id in the map
+	*/
+	bool contains(const nite::UserId userId) const { return isValidId(userId) && occupied[userId]; }
+
+	/**
+		Put a new user into the slot with the specified id. If the slot was already occupied,
+		the previous user is replaced and his handles are invalidated.
+
+		@param userId The NiTE id of the user
+		@param user The user object
+		@return Returns a pointer to the stored user, or nullptr if the id doesn't fit into the map
+	*/
+	T* insert(const nite::UserId userId, const T& user) {
+		if (!isValidId(userId))
+			return nullptr;
+
+		if (occupied[userId])
+			erase(userId);
+
+		slots[userId] = user;
+		occupied[userId] = true;
+		count++;
+
+		return &slots[userId];
+	}
+
+	/**
+		Remove the user with the specified id from the map
+
+		@return Returns "true" if there was such a user
+	*/
+	bool erase(const nite::UserId userId) {
+		if (!contains(userId))
+			return false;
+
+		slots[userId] = T();
+		occupied[userId] = false;
+		generation[userId]++;
+		count--;
+
+		return true;
+	}
+
+	/**
+		Find the user by his NiTE id
+
+		@return Returns a pointer to the user or nullptr if there's no such user
+	*/
+	T* find(const nite::UserId userId) {
+		return contains(userId) ? &slots[userId] : nullptr;
+	}
+
+	const T* find(const nite::UserId userId) const {
+		return contains(userId) ? &slots[userId] : nullptr;
+	}
+
+	/**
+		Issue a handle for the user with the specified id
+
+		@return Returns a valid handle, or a null handle if there's no such user
+	*/
+	UserHandle getHandle(const nite::UserId userId) const {
+		return contains(userId) ? UserHandle(userId, generation[userId]) : UserHandle();
+	}
+
+	/**
+		Resolve the handle back to the user
+
+		@return Returns a pointer to the user, or nullptr if the user was removed in the meantime
+	*/
+	T* resolve(const UserHandle& handle) {
+		if (handle.isNull() || !contains(handle.index) || generation[handle.index] != handle.generation)
+			return nullptr;
+
+		return &slots[handle.index];
+	}
+
+	const T* resolve(const UserHandle& handle) const {
+		if (handle.isNull() || !contains(handle.index) || generation[handle.index] != handle.generation)
+			return nullptr;
+
+		return &slots[handle.index];
+	}
+
+	/**
+		Call the function for every stored user, in the order of their ids
+
+		@param func The function (or lambda) that accepts a reference to the user
+	*/
+	template <typename Func>
+	void forEach(Func func) {
+		for (int i = 0; i < Capacity; i++) {
+			if (occupied[i])
+				func(slots[i]);
+		}
+	}
+
+	template <typename Func>
+	void forEach(Func func) const {
+		for (int i = 0; i < Capacity; i++) {
+			if (occupied[i])
+				func(slots[i]);
+		}
+	}
+
+	/**
+		Remove all the users from the map
+	*/
+	void clear() {
+		for (int i = 0; i < Capacity; i++) {
+			erase(i);
+		}
+	}
+
+private:
+	// the users themselves. Never relocated.
+	T slots[Capacity];
+
+	// is the slot currently occupied?
+	bool occupied[Capacity];
+
+	// generation counter for every slot, incremented on every removal
+	unsigned int generation[Capacity];
+
+	// number of occupied slots
+	int count;
+};
@@ -1,5 +1,11 @@
 #include "Utils.h"
 
+// only for the file listing. The min/max macros would break std::min/std::max below
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+
 // check if the a value lies between two constrains
 bool isInRange(const double value, const double A, const double B) {
 	if (value >= std::fmin(A, B) && value <= std::fmax(A, B))
@@ -146,3 +152,27 @@ void overlayImage(cv::Mat& src, cv::Mat& overlay, const cv::Point& location) {
 	}
 }
 
+std::vector<std::string> get_all_files_names_within_folder(std::string folder) {
+	std::vector<std::string> names;
+	std::string s = folder + "/*.txt";
+	std::wstring search_path = std::wstring(s.begin(), s.end());
+
+	WIN32_FIND_DATA fd;
+	HANDLE hFind = ::FindFirstFile(search_path.c_str(), &fd);
+	if (hFind != INVALID_HANDLE_VALUE) {
+		do {
+			if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+
+				std::string fullPath = folder + "/";
+
+				std::wstring fname(std::wstring(fullPath.begin(), fullPath.end()) + fd.cFileName);
+
+				fullPath = std::string(fname.begin(), fname.end());
+
+				names.push_back(fullPath);
+			}
+		} while (::FindNextFile(hFind, &fd));
+		::FindClose(hFind);
+	}
+	return names;
+}
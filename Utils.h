@@ -1,6 +1,8 @@
 #pragma once
 
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include "opencv2/highgui/highgui.hpp"
 
@@ -105,3 +107,13 @@ void inclim(int& value, const int upperLimit);
 	@param The upper left corner position of the overlay image on the destination image
 */
 void overlayImage(cv::Mat& src, cv::Mat& overlay, const cv::Point & location);
+
+/**
+	Gets the list of the .txt files in the folder. Uses Windows API, so it needs to be reworked
+	for other operating systems
+
+	@param folder The folder that contains files
+
+	@return A string vector with the names of files in the folder.
+*/
+std::vector<std::string> get_all_files_names_within_folder(std::string folder);
@@ -0,0 +1,133 @@
+#include "VideoRecorder.h"
+
+#include <iostream>
+
+VideoRecorder::VideoRecorder(const BackpressurePolicy policy, const int maxQueuedFrames) : queue(policy, maxQueuedFrames), framePool(maxQueuedFrames + 2), writtenFrames(0), repeatedFrames(0) {
+	this->policy = policy;
+	this->maxQueuedFrames = maxQueuedFrames;
+}
+
+bool VideoRecorder::open(const std::string& fileName, const double fps, const int fourcc) {
+
+	if (isOpen())
+		return false;
+
+	this->fileName = fileName;
+	this->fps = (fps > 0) ? fps : VIDEO_DEFAULT_FPS;
+	this->fourcc = fourcc;
+
+	queue.reset(policy, maxQueuedFrames);
+	writtenFrames = 0;
+	repeatedFrames = 0;
+
+	encoderThread = std::thread(&VideoRecorder::run, this);
+
+	return true;
+}
+
+bool VideoRecorder::isOpen() const {
+	return encoderThread.joinable();
+}
+
+bool VideoRecorder::write(const unsigned long long timestamp, const cv::Mat& image) {
+
+	if (!isOpen())
+		return false;
+
+	// the caller may draw on the image, while the encoder reads the copy. The buffer goes back
+	// to the pool, once the encoder is done with it
+	VideoFrame frame;
+	frame.timestamp = timestamp;
+	frame.image = framePool.acquire(image.rows, image.cols, image.type());
+	image.copyTo(frame.image);
+
+	return queue.post(std::move(frame));
+}
+
+void VideoRecorder::run() {
+
+	cv::VideoWriter writer;
+	cv::Size size;
+
+	// the last written frame, repeated over the gaps
+	cv::Mat previous;
+
+	// the timestamp of the first frame, and the number of the frames in the file
+	unsigned long long start = 0;
+	unsigned long long slots = 0;
+
+	VideoFrame frame;
+
+	while (queue.take(frame)) {
+
+		if (frame.image.empty())
+			continue;
+
+		// the file is created with the size of the first frame
+		if (!writer.isOpened()) {
+			if (!writer.open(fileName, fourcc, fps, frame.image.size(), frame.image.channels() == 3)) {
+				std::cerr << "Couldn't create the video file " << fileName << std::endl;
+				queue.close();
+				break;
+			}
+
+			size = frame.image.size();
+			start = frame.timestamp;
+		}
+
+		if (frame.image.size() != size)
+			continue;
+
+		// the place of the frame in the video. The frames, that come faster than the frame rate, are left out
+		unsigned long long slot = (frame.timestamp > start) ? (unsigned long long)((frame.timestamp - start) * fps / 1e6 + 0.5) : 0;
+
+		if (slot < slots)
+			continue;
+
+		// keep the real time over the dropped frames
+		for (; slots < slot && !previous.empty(); slots++) {
+			writer.write(previous);
+			writtenFrames++;
+			repeatedFrames++;
+		}
+
+		writer.write(frame.image);
+		writtenFrames++;
+		slots = slot + 1;
+
+		previous = frame.image;
+	}
+
+	writer.release();
+}
+
+void VideoRecorder::close() {
+
+	if (!isOpen())
+		return;
+
+	// the queued frames are still encoded
+	queue.close();
+	encoderThread.join();
+
+	MailboxStatistics statistics = queue.getStatistics();
+
+	if (statistics.dropped > 0 || statistics.coalesced > 0)
+		std::cerr << "Video recording: " << (statistics.dropped + statistics.coalesced) << " frames were dropped" << std::endl;
+}
+
+MailboxStatistics VideoRecorder::getStatistics() const {
+	return queue.getStatistics();
+}
+
+unsigned long long VideoRecorder::getWrittenFrames() const {
+	return this->writtenFrames;
+}
+
+unsigned long long VideoRecorder::getRepeatedFrames() const {
+	return this->repeatedFrames;
+}
+
+VideoRecorder::~VideoRecorder() {
+	close();
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "FrameMailbox.h"
+#include "FramePool.h"
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/highgui/highgui.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#define VIDEO_MAX_QUEUED_FRAMES 4     // the maximum number of frames waiting for the encoder
+#define VIDEO_DEFAULT_FPS 30.0        // the frame rate of the video file
+
+/**
+	A frame waiting for the encoder
+*/
+struct VideoFrame {
+
+	// the timestamp of the frame in microseconds
+	unsigned long long timestamp = 0;
+
+	// a copy of the image, in one of the buffers of the recorder
+	cv::Mat image;
+};
+
+/**
+	Records the annotated frames (see PoseRecognizer::getModifiedFrame()) into a video file, without
+	slowing down the frame loop.
+
+	write() copies the image into one of the reused buffers of the recorder (see FramePool), so the
+	caller may go on drawing on it, and the frames are encoded by the cv::VideoWriter on a separate thread. If the encoder can't keep up, the queue doesn't grow: the frames are dropped
+	by the policy of the queue (see FrameMailbox), and counted. The video file has a fixed frame rate,
+	so the encoder places every frame by its timestamp, and repeats the previous frame over the gaps
+	left by the dropped frames (or by a slow frame loop), so the video keeps the real time.
+*/
+class VideoRecorder {
+
+public:
+	/**
+		Create the recorder
+
+		@param policy Which frames to drop when the encoder is behind. BACKPRESSURE_BLOCK would stall the frame loop. Default: BACKPRESSURE_DROP_OLDEST.
+		@param maxQueuedFrames The maximum number of frames waiting for the encoder. Default: VIDEO_MAX_QUEUED_FRAMES.
+	*/
+	VideoRecorder(const BackpressurePolicy policy = BACKPRESSURE_DROP_OLDEST, const int maxQueuedFrames = VIDEO_MAX_QUEUED_FRAMES);
+
+	/**
+		Start a new video file. The file is created by the encoder thread with the size of the first frame.
+
+		@param fileName The path to the video file
+		@param fps The frame rate of the video. Default: VIDEO_DEFAULT_FPS.
+		@param fourcc The codec (see cv::VideoWriter::fourcc()). Default: MJPG.
+
+		@return Returns "false" if the recording is already running.
+	*/
+	bool open(const std::string& fileName, const double fps = VIDEO_DEFAULT_FPS, const int fourcc = cv::VideoWriter::fourcc('M', 'J', 'P', 'G'));
+
+	/**
+		Check if the recording is running
+	*/
+	bool isOpen() const;
+
+	/**
+		Queue a copy of the frame for the encoder. Never waits for the encoder (unless the policy
+		is BACKPRESSURE_BLOCK).
+
+		@param timestamp The timestamp of the frame in microseconds
+		@param image The image (CV_8UC3). May be modified afterwards.
+
+		@return Returns "false" if the recording isn't running.
+	*/
+	bool write(const unsigned long long timestamp, const cv::Mat& image);
+
+	/**
+		Encode all the queued frames, stop the encoder thread and close the file
+	*/
+	void close();
+
+	/**
+		Get the counters of the queue: the queued, the encoded, the dropped and the coalesced frames
+	*/
+	MailboxStatistics getStatistics() const;
+
+	/**
+		Get the number of the frames written into the file, including the repeated ones
+	*/
+	unsigned long long getWrittenFrames() const;
+
+	/**
+		Get the number of the frames repeated to fill the gaps
+	*/
+	unsigned long long getRepeatedFrames() const;
+
+	~VideoRecorder();
+
+private:
+	// the frames waiting for the encoder
+	FrameMailbox<VideoFrame> queue;
+
+	BackpressurePolicy policy;
+	int maxQueuedFrames;
+
+	// the copies of the queued frames. Enough for the queue, the frame being encoded and the previous one
+	FramePool framePool;
+
+	// the encoder thread
+	std::thread encoderThread;
+
+	// the output file
+	std::string fileName;
+	double fps = VIDEO_DEFAULT_FPS;
+	int fourcc = 0;
+
+	// the statistics
+	std::atomic<unsigned long long> writtenFrames;
+	std::atomic<unsigned long long> repeatedFrames;
+
+	/**
+		The loop of the encoder thread
+	*/
+	void run();
+};
@@ -3,11 +3,14 @@
 #include <Windows.h>
 
 #include "PoseRecognizer.h"
+#include "MultiSourceHost.h"
+#include "ReplayBenchmark.h"
+#include "ParameterSweep.h"
 
 int main() {
 
 	// Create a new recognizer object
-	PoseRecognizer pr = PoseRecognizer();
+	PoseRecognizer pr;
 
 	if (!pr.initialize()) { 
 		std::cerr << "init error!" << std::endl;
@@ -18,10 +21,17 @@ int main() {
 	// Option one
 	// Either just start the app by calling .start()
 	// It will automatically run in a new thread
+	// (optionally draw the overlays where the hands will be, when the frame is shown:
+	// pr.setJointPrediction(true);
+	// and keep the annotated frames for the archive: pr.startVideoRecording("show.avi");
+	// or log every pose estimation for the analytics: pr.startRecognitionLog("show.mprl");
+	// and later RecognitionLogReader::dump("show.mprl", csvFile);)
 	 pr.start();
 
 	// Option two
 	// Or you can do this manually and process each frame individually
+	// (if your processing is slower than the Kinect, grab the frames on a separate thread,
+	// and recognize only the newest one: pr.startCapture(BACKPRESSURE_LATEST_WINS);)
 	/*
 	while (cv::waitKey(5) != 27) {	// while ESC key is not pressed
 	
@@ -44,5 +54,63 @@ int main() {
 	}
 	*/
 
+	// Option three
+	// Or run several recognizers at once (several Kinects, or recorded streams),
+	// sharing the same pose data
+	/*
+	MultiSourceHost host(PoseModelStore::getDefault()->load("./poses"));
+	host.addSensor(0);
+	host.addSensor(1);
+	host.addReplay("stage.mpst", "stage.mpsk", false);
+
+	host.start();
+
+	// all the libraries are in memory, so the venue can be changed at any moment
+	// host.selectPoseModel(PoseModelStore::getDefault()->load("./poses_belt_level", PROFILE_BELT));
+
+	host.wait();
+	host.printStatistics(std::cout);
+	*/
+
+	// Option four
+	// Or compare the settings of the recognizer on a recorded session: how quickly
+	// the poses are recognized, and how often the recognition flickers
+	/*
+	ReplayBenchmark benchmark(PoseModelStore::getDefault()->load("./poses"));
+
+	ReplayBenchmark::print(std::cout, benchmark.compare("stage.mpsk", {
+		{ "raw, hold 3", false, 3 },
+		{ "smoothed, hold 3", true, 3 },
+		{ "smoothed, hold 1", true, 1 }
+	}));
+
+	// how far the overlays are from the hands at the display time, with and without the prediction
+	OverlayErrorResult overlayError;
+	if (ReplayBenchmark::measureOverlayError("stage.mpsk", 100, overlayError))
+		ReplayBenchmark::print(std::cout, overlayError);
+	*/
+
+	// Option five
+	// Or try a grid of the recognition parameters on the labelled sessions, on all the cores,
+	// and pick the fastest combination, that is still accurate enough
+	/*
+	ParameterSweep sweep(PoseModelStore::getDefault()->load("./poses"), true);
+	sweep.addSession("stage.mpsk");
+	sweep.addSession("rehearsal.mpsk");
+
+	SweepGrid grid;
+	grid.nearestNeighbours = { 3, 5, 7, 9 };
+	grid.poseHolds = { 1, 3, 5 };
+	grid.frameSkips = { 1, 2, 4 };
+	grid.thresholdScales = { 0.8, 1.0, 1.2 };
+
+	std::vector<SweepResult> results = sweep.run(ParameterSweep::makeGrid(grid));
+	ParameterSweep::print(std::cout, results);
+
+	const SweepResult* fastest = ParameterSweep::findFastest(results, 0.9);
+	if (fastest != nullptr)
+		pr.setParams(fastest->params);
+	*/
+
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,138 @@
+/**
+	Checks the angle kernels (see AngleKernels.h) against getAngle() and getThreePointAngle()
+	from Utils.h over the full range of angles, for the single and the batch versions.
+
+	Build it together with AngleKernels.cpp and Utils.cpp, and run it: it prints the maximum
+	errors, and returns 0 if all of them are within the tolerance, otherwise 1.
+*/
+#include "../AngleKernels.h"
+#include "../Utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#define DIRECTION_TOLERANCE 2e-4      // the maximum error of the direction angles, in degrees
+#define THREE_POINT_TOLERANCE 1e-5    // the maximum error of the three-point angles, in radians
+#define ANGLE_STEPS 20000             // the number of the angles in the sweep
+
+// the lengths of the vectors, from the tiny ones to the huge ones
+static const float lengths[] = { 1e-4f, 1e-2f, 1.f, 150.f, 1e4f };
+
+/**
+	The difference between two direction angles in degrees, with 360 and 0 considered equal
+*/
+static double directionError(const double a, const double b) {
+	double d = std::abs(a - b);
+	return (std::min)(d, 360 - d);
+}
+
+/**
+	Sweep the direction of the vector over -PI..PI
+*/
+static bool checkDirectionAngles() {
+
+	std::vector<float> x1, y1, x2, y2;
+	std::vector<double> expected;
+
+	double maxError = 0;
+
+	for (const float length : lengths) {
+		for (int i = 0; i <= ANGLE_STEPS; i++) {
+			double theta = -PI + 2 * PI * i / ANGLE_STEPS;
+
+			// a start point off the origin, so the subtraction is tested too
+			cv::Point2f from(12.5f, -7.25f);
+			cv::Point2f to(from.x + (float)(length * std::cos(theta)), from.y + (float)(length * std::sin(theta)));
+
+			// the rounding may leave a zero vector, which has no direction
+			if (to == from)
+				continue;
+
+			double reference = getAngle(from, to);
+
+			maxError = (std::max)(maxError, directionError(fastDirectionAngle(from.x, from.y, to.x, to.y), reference));
+
+			x1.push_back(from.x);
+			y1.push_back(from.y);
+			x2.push_back(to.x);
+			y2.push_back(to.y);
+			expected.push_back(reference);
+		}
+	}
+
+	std::vector<float> result(expected.size());
+	directionAngles(x1.data(), y1.data(), x2.data(), y2.data(), result.data(), (int)result.size());
+
+	double maxBatchError = 0;
+
+	for (size_t i = 0; i < result.size(); i++) {
+		maxBatchError = (std::max)(maxBatchError, directionError(result[i], expected[i]));
+	}
+
+	std::cout << "Direction angles:   max error " << maxError << " deg, batch " << maxBatchError << " deg" << std::endl;
+
+	return maxError <= DIRECTION_TOLERANCE && maxBatchError <= DIRECTION_TOLERANCE;
+}
+
+/**
+	Sweep the angle between the upper and the lower arm over 0..PI
+*/
+static bool checkThreePointAngles() {
+
+	std::vector<float> ax, ay, az, bx, by, bz, cx, cy, cz;
+	std::vector<double> expected;
+
+	double maxError = 0;
+
+	for (const float length : lengths) {
+		for (int i = 0; i <= ANGLE_STEPS; i++) {
+			double theta = PI * i / ANGLE_STEPS;
+
+			// the elbow, the shoulder on one side of it, and the hand turned by theta, in a tilted plane
+			cv::Point3f b(100.f, 200.f, 2000.f);
+			cv::Point3f a = b + cv::Point3f(length * 0.6f, length * 0.8f, 0.f);
+			cv::Point3f c = b + cv::Point3f((float)(length * std::cos(theta) * 0.6), (float)(length * std::cos(theta) * 0.8), (float)(length * std::sin(theta)));
+
+			if (a == b || c == b)
+				continue;
+
+			double reference = getThreePointAngle(a, b, c);
+
+			// acos() of a cosine rounded beyond 1 in double
+			if (reference != reference)
+				continue;
+
+			maxError = (std::max)(maxError, std::abs(fastThreePointAngle(a.x, a.y, a.z, b.x, b.y, b.z, c.x, c.y, c.z) - reference));
+
+			ax.push_back(a.x); ay.push_back(a.y); az.push_back(a.z);
+			bx.push_back(b.x); by.push_back(b.y); bz.push_back(b.z);
+			cx.push_back(c.x); cy.push_back(c.y); cz.push_back(c.z);
+			expected.push_back(reference);
+		}
+	}
+
+	std::vector<float> result(expected.size());
+	threePointAngles(ax.data(), ay.data(), az.data(), bx.data(), by.data(), bz.data(), cx.data(), cy.data(), cz.data(), result.data(), (int)result.size());
+
+	double maxBatchError = 0;
+
+	for (size_t i = 0; i < result.size(); i++) {
+		maxBatchError = (std::max)(maxBatchError, std::abs(result[i] - expected[i]));
+	}
+
+	std::cout << "Three-point angles: max error " << maxError << " rad, batch " << maxBatchError << " rad" << std::endl;
+
+	return maxError <= THREE_POINT_TOLERANCE && maxBatchError <= THREE_POINT_TOLERANCE;
+}
+
+int main() {
+
+	bool passed = checkDirectionAngles();
+	passed = checkThreePointAngles() && passed;
+
+	std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+
+	return passed ? 0 : 1;
+}